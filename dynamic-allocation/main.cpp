@@ -1,6 +1,7 @@
 
 #include <iostream>
 #include <cassert>
+#include <memory_resource>
 /*
     * new && delete scalar form
     * new && delete array form
@@ -88,23 +89,30 @@ Because the void pointer does not know what type of object it is pointing to, de
 */
 
 //  a class implementing RAII technique
+// the memory comes from a memory resource (new/delete by default): the owner of many short lived IntArrs can pass an arena instead
+// (see object-relationships/examples/int-array)
 class IntArr
 {
 private:
     int length{};
     int *arr{};
+    std::pmr::memory_resource *resource{};
 
 public:
-    IntArr(int len)
+    IntArr(int len, std::pmr::memory_resource *res = std::pmr::get_default_resource()) : resource{res}
     {
         assert(len > 0);
-        arr = new int[static_cast<std::size_t>(len)];
+        arr = static_cast<int *>(resource->allocate(sizeof(int) * static_cast<std::size_t>(len), alignof(int)));
         length = len;
     }
 
+    // the object owns its memory: no copies (see the rule of three)
+    IntArr(const IntArr &) = delete;
+    IntArr &operator=(const IntArr &) = delete;
+
     ~IntArr()
     {
-        delete[] arr;
+        resource->deallocate(arr, sizeof(int) * static_cast<std::size_t>(length), alignof(int));
     }
 };
 
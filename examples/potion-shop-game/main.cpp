@@ -1,3 +1,4 @@
+#include "money.h"
 #include "random.h"
 #include <iostream>
 #include <string_view>
@@ -17,17 +18,22 @@ namespace Potion
     };
     using namespace std::literals::string_view_literals;
     constexpr std::array potion_names{"healing"sv, "mana"sv, "speed"sv, "invisibility"sv};
-    constexpr std::array potion_costs{20, 30, 12, 50};
+    constexpr std::array potion_costs{20, 30, 12, 50}; // in gold pieces
     static_assert(std::size(potion_names) == max_potions);
     static_assert(std::size(potion_names) == max_potions);
 
+    // gold pieces can't be split: no minor units
+    inline const Currency gold{Currency::add("GLD", 0)};
+
+    Money cost(Type p) { return Money::major(potion_costs[p], gold); }
+
     void shop()
     {
         std::cout << "\nHere is our selection for today:\n";
 
         for (size_t i{0}; i < max_potions; ++i)
         {
-            std::cout << i << ") " << potion_names[i] << " costs " << potion_costs[i] << '\n';
+            std::cout << i << ") " << potion_names[i] << " costs " << cost(static_cast<Type>(i)) << '\n';
         }
     }
 }
@@ -36,16 +42,16 @@ class Player
 {
 private:
     std::string name{};
-    int gold_amout{};
+    Money m_gold{};
     std::array<int, Potion::max_potions> potion_inventory{};
 
 public:
     Player(std::string_view name_) : name{name_}
     {
-        gold_amout = Random::get(80, 120);
+        m_gold = Money::major(Random::get(80, 120), Potion::gold);
     }
     const std::string_view getName() const { return name; }
-    const int getGold() const { return gold_amout; }
+    const Money getGold() const { return m_gold; }
     const int inventory(Potion::Type p) { return potion_inventory[p]; }
     void purchasePotion(Potion::Type);
     void quitShop();
@@ -53,15 +59,15 @@ public:
 
 void Player::purchasePotion(Potion::Type p)
 {
-    if (gold_amout < Potion::potion_costs[p])
+    if (m_gold < Potion::cost(p))
     {
         std::cout << "You can not afford that.\n";
     }
     else
     {
         ++potion_inventory[p];
-        gold_amout -= Potion::potion_costs[p];
-        std::cout << "You purchased a potion of speed.  You have " << gold_amout << " gold left.\n";
+        m_gold -= Potion::cost(p);
+        std::cout << "You purchased a potion of speed.  You have " << m_gold << " left.\n";
     }
 }
 void Player::quitShop()
@@ -72,7 +78,7 @@ void Player::quitShop()
         if (potion_inventory[p] != 0)
             std::cout << potion_inventory[p] << "x potion of " << Potion::potion_names[p] << '\n';
     }
-    std::cout << "You escaped with " << getGold() << " gold remaining.\n";
+    std::cout << "You escaped with " << getGold() << " remaining.\n";
 }
 
 int main()
@@ -83,7 +89,7 @@ int main()
     std::string name{};
     std::getline(std::cin >> std::ws, name);
     Player player{name};
-    std::cout << "Hello, " << name << ", you have " << player.getGold() << " gold.\n\n";
+    std::cout << "Hello, " << name << ", you have " << player.getGold() << ".\n\n";
 
     bool wrong_input{false};
     bool quit{false};
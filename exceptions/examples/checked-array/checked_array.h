@@ -0,0 +1,133 @@
+#ifndef CHECKED_ARRAY_H
+#define CHECKED_ARRAY_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+// what an out of range index does, chosen at compile time
+enum class BoundsCheck
+{
+    none,      // nothing: an out of range index is undefined behavior (like a built-in array)
+    assertion, // assert(): stops debug builds, free in release builds (NDEBUG), like the IntArray classes of the other lessons
+    exception, // throws std::out_of_range, in every build, like IntArray in exceptions/main.cpp
+};
+
+// A dynamic array whose bounds checking is a template parameter: the same class is used with checks while developing
+// and testing, and without them where the cost matters, instead of one array class per checking strategy.
+//
+// Checking every access costs a compare and a branch per element in a loop. range(first, last) checks a whole window once and
+// returns a std::span over it: the loop over the span isn't checked anymore (and the compiler can vectorize it).
+template <typename T, BoundsCheck Check = BoundsCheck::assertion>
+class CheckedArray
+{
+private:
+    std::unique_ptr<T[]> m_data{};
+    std::size_t m_length{};
+
+    // a separate [[noreturn]] function: the compiler moves the throw out of the loops, the hot path is a compare and a branch never taken
+    [[noreturn]] static void outOfRange(const char *what)
+    {
+        throw std::out_of_range{std::string{"CheckedArray: "} + what};
+    }
+    static void check([[maybe_unused]] bool in_range, [[maybe_unused]] const char *what)
+    {
+        if constexpr (Check == BoundsCheck::assertion)
+            assert(in_range && what);
+        else if constexpr (Check == BoundsCheck::exception)
+        {
+            if (!in_range) [[unlikely]]
+                outOfRange(what);
+        }
+    }
+
+public:
+    static constexpr BoundsCheck bounds_check{Check};
+
+    CheckedArray() = default;
+    explicit CheckedArray(std::size_t length) : m_data{std::make_unique<T[]>(length)}, m_length{length} {}
+    CheckedArray(std::initializer_list<T> list) : CheckedArray(list.size())
+    {
+        std::copy(list.begin(), list.end(), m_data.get());
+    }
+    CheckedArray(const CheckedArray &array) : CheckedArray(array.m_length)
+    {
+        std::copy_n(array.m_data.get(), m_length, m_data.get());
+    }
+    CheckedArray &operator=(const CheckedArray &array)
+    {
+        if (this != &array)
+            *this = CheckedArray{array};
+        return *this;
+    }
+    CheckedArray(CheckedArray &&) noexcept = default;
+    CheckedArray &operator=(CheckedArray &&) noexcept = default;
+
+    std::size_t size() const { return m_length; }
+    bool empty() const { return m_length == 0; }
+    T *data() { return m_data.get(); }
+    const T *data() const { return m_data.get(); }
+
+    // checked according to the policy
+    T &operator[](std::size_t index)
+    {
+        check(index < m_length, "index out of range");
+        return m_data[index];
+    }
+    const T &operator[](std::size_t index) const
+    {
+        check(index < m_length, "index out of range");
+        return m_data[index];
+    }
+    // always checked, whatever the policy (like std::vector::at())
+    T &at(std::size_t index)
+    {
+        if (index >= m_length) [[unlikely]]
+            outOfRange("at(): index out of range");
+        return m_data[index];
+    }
+    const T &at(std::size_t index) const
+    {
+        if (index >= m_length) [[unlikely]]
+            outOfRange("at(): index out of range");
+        return m_data[index];
+    }
+
+    // the elements [first, last), checked once according to the policy: the span itself isn't checked
+    std::span<T> range(std::size_t first, std::size_t last)
+    {
+        check(first <= last && last <= m_length, "range out of bounds");
+        return {m_data.get() + first, last - first};
+    }
+    std::span<const T> range(std::size_t first, std::size_t last) const
+    {
+        check(first <= last && last <= m_length, "range out of bounds");
+        return {m_data.get() + first, last - first};
+    }
+    // count elements from first
+    std::span<T> subspan(std::size_t first, std::size_t count)
+    {
+        check(first <= m_length && count <= m_length - first, "range out of bounds");
+        return {m_data.get() + first, count};
+    }
+    std::span<const T> subspan(std::size_t first, std::size_t count) const
+    {
+        check(first <= m_length && count <= m_length - first, "range out of bounds");
+        return {m_data.get() + first, count};
+    }
+
+    // the whole array: nothing to check
+    std::span<T> span() { return {m_data.get(), m_length}; }
+    std::span<const T> span() const { return {m_data.get(), m_length}; }
+    T *begin() { return m_data.get(); }
+    T *end() { return m_data.get() + m_length; }
+    const T *begin() const { return m_data.get(); }
+    const T *end() const { return m_data.get() + m_length; }
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include "checked_array.h"
+#include "timer.h"
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <stdexcept>
+#include <cassert>
+
+/*
+    * Compile-time policies: a template parameter that selects a behavior
+    * Bounds checking: none, assert, exception
+    * Hoisting checks out of loops: one check per range instead of one per element
+*/
+
+/*
+The IntArray of exceptions/main.cpp throws std::out_of_range from operator[], the IntArray classes of the other lessons assert(), a built-in
+array doesn't check at all. Each choice is right somewhere:
+    exceptions:   the index comes from outside (user input, a file) and the program can recover
+    assert():     an out of range index is a bug: catch it while testing, pay nothing in release builds
+    no checks:    the indexes are known to be valid and the loop is hot
+CheckedArray<T, BoundsCheck> makes it a template parameter: if constexpr keeps only the code of the chosen policy, there is no runtime cost
+for the choice itself.
+
+A loop that checks every element pays a compare and a branch each time, and a possible throw in the middle of the loop can stop the
+compiler from vectorizing it. range(first, last) validates the whole window up front and returns a std::span: one check per loop.
+*/
+
+// sums the elements of [first, last) through operator[] (one check per element)
+template <typename Array>
+std::int64_t sumIndexed(const Array &array, std::size_t first, std::size_t last)
+{
+    std::int64_t sum{0};
+    for (std::size_t i{first}; i < last; ++i)
+        sum += array[i];
+    return sum;
+}
+
+// sums the elements of [first, last) through a checked range (one check per call)
+template <typename Array>
+std::int64_t sumRange(const Array &array, std::size_t first, std::size_t last)
+{
+    std::int64_t sum{0};
+    for (int value : array.range(first, last))
+        sum += value;
+    return sum;
+}
+
+struct Window
+{
+    std::size_t first{};
+    std::size_t last{};
+};
+
+template <typename Array>
+void benchmark(const char *name, const Array &array, const std::vector<Window> &windows)
+{
+    Timer timer{};
+    std::int64_t indexed{0};
+    for (const Window &window : windows)
+        indexed += sumIndexed(array, window.first, window.last);
+    double indexed_time{timer.elapsed()};
+
+    timer.reset();
+    std::int64_t ranged{0};
+    for (const Window &window : windows)
+        ranged += sumRange(array, window.first, window.last);
+    double range_time{timer.elapsed()};
+
+    if (indexed != ranged)
+        throw std::logic_error{"the two sums differ"};
+    std::cout << name << "operator[] " << indexed_time << " s, range() " << range_time << " s\n";
+}
+
+int main()
+{
+    CheckedArray<int, BoundsCheck::exception> grades{15, 12, 18};
+    try
+    {
+        std::cout << grades[grades.size()] << '\n'; // one past the end
+    }
+    catch (const std::out_of_range &exception)
+    {
+        std::cerr << exception.what() << '\n';
+    }
+    try
+    {
+        for (int grade : grades.range(1, 4)) // caught before the loop starts
+            std::cout << grade << '\n';
+    }
+    catch (const std::out_of_range &exception)
+    {
+        std::cerr << exception.what() << '\n';
+    }
+    CheckedArray<int, BoundsCheck::none> unchecked(grades.range(0, 2).size()); // parentheses: braces would pick the initializer list constructor
+    unchecked[1] = grades.at(2);
+    assert(unchecked[1] == 18);
+
+    /* Benchmark: summing windows of a 1M element array */
+    constexpr std::size_t length{1 << 20};
+    CheckedArray<int, BoundsCheck::none> none(length);
+    CheckedArray<int, BoundsCheck::assertion> asserted(length);
+    CheckedArray<int, BoundsCheck::exception> throwing(length);
+    std::mt19937 mt{7};
+    for (std::size_t i{0}; i < length; ++i)
+        none[i] = asserted[i] = throwing[i] = static_cast<int>(mt() % 1000);
+
+    std::vector<Window> windows{};
+    std::uniform_int_distribution<std::size_t> position{0, length};
+    for (int i{0}; i < 2000; ++i)
+    {
+        std::size_t a{position(mt)};
+        std::size_t b{position(mt)};
+        windows.push_back({std::min(a, b), std::max(a, b)});
+    }
+
+    std::cout << "sum of " << windows.size() << " windows";
+#ifdef NDEBUG
+    std::cout << " (NDEBUG: assert() does nothing)";
+#endif
+    std::cout << ":\n";
+    benchmark("BoundsCheck::none      ", none, windows);
+    benchmark("BoundsCheck::assertion ", asserted, windows);
+    benchmark("BoundsCheck::exception ", throwing, windows);
+
+    return 0;
+}
@@ -0,0 +1,347 @@
+#ifndef FAST_SEARCH_H
+#define FAST_SEARCH_H
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <climits>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+
+// Faster searches in sorted arrays of ints, for big arrays searched many times.
+//
+// binarySearchIterative() (main.cpp) loses its time in two ways once the array is big:
+//   its if/else goes left or right at random: the cpu guesses the branch, and about one guess in two is wrong, ~15 cycles lost each
+//   each step reads an element far from the last one: past the size of the caches, every step waits for memory (~100 ns),
+//   and the next address is only known once that wait is over
+// lowerBoundBranchless() removes the branches: the next position is computed with a conditional move, and the loop always runs
+// log2(size) times. It also prefetches the two elements the next step may read, so that the memory has already been asked
+// for them when the comparison picks one. That makes it twice as fast while the array is in the caches; past them, it's no
+// faster than the branchy loop: the branch predictor's guesses also start the next load early (on the right side half the
+// time), and the steps far apart still wait for memory one after the other.
+// searchBatch() looks up many targets at once: it advances a group of searches one step each, in turn, so that the group's
+// memory accesses are all on their way at the same time instead of one after the other.
+// EytzingerArray and StaticBTree copy the array into a layout made for searching (see their comments): they cost memory and
+// a build, and pay off when the array is searched many times.
+//
+// StaticBTree compares 16 keys at once with one AVX-512 instruction, two AVX2 ones or four SSE2 ones, the best the cpu supports,
+// chosen on the first search (like StringSearch::find()). The compiler vectorizes a plain loop counting the keys < target too,
+// but adds up the 16 results with a chain of shuffles; a comparison mask and a popcount are half as many instructions
+// on the path from one level to the next. Other targets (or FAST_SEARCH_NO_DISPATCH) use the plain loop.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(FAST_SEARCH_NO_DISPATCH)
+#define FAST_SEARCH_X86
+#include <immintrin.h>
+#endif
+
+// the index of the first element of array[0, size) that is >= target, size if there is none
+inline int lowerBoundBranchless(const int *array, int size, int target)
+{
+    if (size <= 0)
+        return 0;
+    const int *base{array};
+    int length{size};
+    while (length > 1)
+    {
+        int half{length / 2};
+        length -= half;
+        // the middle of the next step is one of these two: ask for both while the comparison waits for base[half - 1]
+        int next{std::max(length / 2 - 1, 0)};
+        __builtin_prefetch(base + next);
+        __builtin_prefetch(base + half + next);
+        base += (base[half - 1] < target) * half; // no branch: an addition of 0 or half (a cmov)
+    }
+    return static_cast<int>(base - array) + (*base < target);
+}
+
+// binarySearchIterative() without branches: the index of target in array[min, max], -1 if it's not there
+// (the first one when target is there several times)
+inline int binarySearchBranchless(const int *array, int target, int min, int max)
+{
+    if (array == nullptr || min > max)
+        return -1;
+    int index{min + lowerBoundBranchless(array + min, max - min + 1, target)};
+    return index <= max && array[index] == target ? index : -1;
+}
+
+// out[i] = the index of targets[i] in array[0, size), -1 if it's not there (like binarySearchIterative(array, targets[i], 0, size - 1),
+// with the first index when the target is there several times)
+// A binary search in a big array waits for memory at each step, and can't do anything else meanwhile: the next address depends
+// on the value it waits for. Searches for different targets don't depend on each other, though. searchBatch() runs group_size
+// of them in lockstep: each round does one step of every search of the group (branchless, like lowerBoundBranchless()) and
+// prefetches the element each will read next; by the time the round comes back to a search, its element has had the whole
+// round to arrive, and the group's cache misses overlapped. All the searches of a group take the same number of steps (it only
+// depends on size), so the lockstep costs nothing.
+inline void searchBatch(const int *array, int size, std::span<const int> targets, std::span<int> out)
+{
+    constexpr std::size_t group_size{32}; // enough misses in flight to keep the memory busy, few enough to stay in registers and L1
+    assert(out.size() >= targets.size());
+    if (array == nullptr || size <= 0)
+    {
+        std::fill(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(targets.size()), -1);
+        return;
+    }
+    for (std::size_t first{0}; first < targets.size(); first += group_size)
+    {
+        const std::size_t count{std::min(group_size, targets.size() - first)};
+        const int *group_targets{targets.data() + first};
+        const int *bases[group_size];
+        for (std::size_t i{0}; i < count; ++i)
+            bases[i] = array;
+        int length{size};
+        while (length > 1)
+        {
+            int half{length / 2};
+            length -= half;
+            for (std::size_t i{0}; i < count; ++i)
+            {
+                bases[i] += (bases[i][half - 1] < group_targets[i]) * half;
+                __builtin_prefetch(bases[i] + std::max(length / 2 - 1, 0)); // what the next round reads
+            }
+        }
+        for (std::size_t i{0}; i < count; ++i)
+        {
+            int index{static_cast<int>(bases[i] - array) + (*bases[i] < group_targets[i])};
+            out[first + i] = index < size && array[index] == group_targets[i] ? index : -1;
+        }
+    }
+}
+
+namespace FastSearchDetail
+{
+    struct AlignedDeleter
+    {
+        void operator()(int *keys) const { ::operator delete(keys, std::align_val_t{64}); }
+    };
+    using AlignedArray = std::unique_ptr<int[], AlignedDeleter>;
+
+    // count ints, on a cache line boundary
+    inline AlignedArray allocate(std::size_t count)
+    {
+        return AlignedArray{static_cast<int *>(::operator new(count * sizeof(int), std::align_val_t{64}))};
+    }
+}
+
+// A sorted array in Eytzinger (breadth first) order, like a binary heap: the root at 1, the children of k at 2k and 2k + 1.
+// A search goes down from the root; the first levels are together at the start of the array and stay in the cache, and the 16
+// descendants of k four levels down are the 16 ints (one cache line) at 16k: the search prefetches them four steps before
+// it needs them, whichever way it goes in between. The descent is branchless, like lowerBoundBranchless().
+// The tree is made complete (2^height - 1 keys, the missing ones are INT_MAX at the end of the order): every search takes
+// height steps, and the position of a node in the sorted array is computed from its number, without a table.
+class EytzingerArray
+{
+private:
+    FastSearchDetail::AlignedArray m_keys{};
+    int m_size{};   // of the sorted array
+    int m_height{}; // of the tree: 2^m_height - 1 keys
+
+    // fills the tree in order: an in-order walk of the tree visits the sorted array in order
+    int fill(std::span<const int> sorted, int next, std::size_t node)
+    {
+        if (node >= (std::size_t{1} << m_height))
+            return next;
+        next = fill(sorted, next, 2 * node);
+        m_keys[node] = next < static_cast<int>(sorted.size()) ? sorted[static_cast<std::size_t>(next)] : INT_MAX;
+        return fill(sorted, next + 1, 2 * node + 1);
+    }
+
+public:
+    explicit EytzingerArray(std::span<const int> sorted)
+    {
+        assert(std::is_sorted(sorted.begin(), sorted.end()));
+        if (sorted.size() >= (std::size_t{1} << 30))
+            throw std::length_error{"EytzingerArray: more than 2^30 elements"};
+        m_size = static_cast<int>(sorted.size());
+        m_height = std::bit_width(sorted.size()); // 2^height - 1 >= size
+        std::size_t slots{std::size_t{1} << m_height};
+        m_keys = FastSearchDetail::allocate(slots);
+        m_keys[0] = INT_MIN; // unused
+        fill(sorted, 0, 1);
+    }
+
+    int size() const { return m_size; }
+
+    // the index in the sorted array of the first element >= target, size() if there is none
+    int lowerBound(int target) const
+    {
+        std::size_t k{lowerBoundNode(target)};
+        return k == 0 ? m_size : std::min(position(k), m_size);
+    }
+
+    // the index of target in the sorted array, -1 if it's not there
+    int find(int target) const
+    {
+        std::size_t k{lowerBoundNode(target)};
+        return k != 0 && m_keys[k] == target && position(k) < m_size ? position(k) : -1;
+    }
+
+private:
+    // the node of the first key >= target, 0 if there is none
+    std::size_t lowerBoundNode(int target) const
+    {
+        const int *keys{m_keys.get()};
+        std::size_t k{1};
+        // 16 k is in the tree until the last four levels: no prefetch there, they are the ones it was asking for
+        int level{0};
+        for (; level < m_height - 4; ++level)
+        {
+            __builtin_prefetch(keys + 16 * k);
+            k = 2 * k + (keys[k] < target);
+        }
+        for (; level < m_height; ++level)
+            k = 2 * k + (keys[k] < target);
+        // k went right after the last node that is >= target, then only left: remove those right turns and the left turn before
+        // them (k is 0 when the search only went right: every key is < target)
+        return k >> (std::countr_one(k) + 1);
+    }
+
+    // the position of node k in the sorted array: at depth d (2^d <= k < 2^(d + 1)), (2 (k - 2^d) + 1) 2^(height - 1 - d) - 1
+    int position(std::size_t k) const
+    {
+        int depth{static_cast<int>(std::bit_width(k)) - 1};
+        return static_cast<int>(((2 * (k - (std::size_t{1} << depth)) + 1) << (m_height - 1 - depth)) - 1);
+    }
+};
+
+// A static B+ tree ("S+ tree", from Algorithmica's "Static B-Trees"): nodes of 16 keys, one cache line, with 17 children each.
+// A search reads one node per level: log17(n) cache misses instead of log2(n) for a binary search (6 instead of 27 for 100M
+// elements), and compares the target with the 16 keys of a node at once, counting the keys < target without a branch: a
+// comparison mask (one _mm512_cmplt_epi32_mask, two AVX2 or four SSE2 comparisons and a movemask) and a popcount, see
+// rankAvx512(), rankAvx2() and rankSse2(). The last level (the leaves) is the sorted array itself, padded
+// with INT_MAX to a multiple of 16, so a position in it is an index of the sorted array.
+// Key j of an internal node is the smallest element of its child j + 1; the nodes of a level are one after the other, the root last.
+class StaticBTree
+{
+public:
+    static constexpr int node_size{16};
+
+private:
+    FastSearchDetail::AlignedArray m_keys{};
+    int m_size{};
+    int m_levels{};
+    int m_level_offsets[8]{}; // the first key of each level, the leaves at 0: 17^7 leaves are more than 2^31 elements
+
+    static std::size_t nodesAbove(std::size_t nodes) { return (nodes + node_size) / (node_size + 1); }
+
+    using LowerBoundFunction = int (StaticBTree::*)(int target) const;
+
+    // goes down the levels, rank(node keys, target) being the number of keys < target: the position in the leaves at the end
+    // (all the keys of the children before child rank are < target; child rank may have only keys < target too, then the search
+    // ends past its last leaf, at the first element of the next leaf: the answer)
+#define STATIC_B_TREE_DESCEND(rank)                                                          \
+    const int *keys{m_keys.get()};                                                           \
+    std::size_t node{0};                                                                     \
+    for (int level{m_levels - 1}; level > 0; --level)                                        \
+        node = node * (node_size + 1) + rank(keys + m_level_offsets[level] + node * node_size, target); \
+    return static_cast<int>(node * node_size + rank(keys + node * node_size, target));
+
+    static std::size_t rankScalar(const int *node_keys, int target)
+    {
+        std::size_t rank{0};
+        for (int j{0}; j < node_size; ++j) // no early exit: vectorized
+            rank += node_keys[j] < target;
+        return rank;
+    }
+    int lowerBoundScalar(int target) const { STATIC_B_TREE_DESCEND(rankScalar) }
+
+#if defined(FAST_SEARCH_X86)
+    static std::size_t rankSse2(const int *node_keys, int target)
+    {
+        const __m128i key{_mm_set1_epi32(target)};
+        const __m128i *keys{reinterpret_cast<const __m128i *>(node_keys)};
+        // the 16 comparisons (-1 or 0) packed into 16 bytes: one bit each in the mask
+        unsigned mask{static_cast<unsigned>(_mm_movemask_epi8(_mm_packs_epi16(_mm_packs_epi32(_mm_cmplt_epi32(_mm_load_si128(keys), key), _mm_cmplt_epi32(_mm_load_si128(keys + 1), key)),
+                                                                              _mm_packs_epi32(_mm_cmplt_epi32(_mm_load_si128(keys + 2), key), _mm_cmplt_epi32(_mm_load_si128(keys + 3), key)))))};
+        return static_cast<std::size_t>(__builtin_popcount(mask));
+    }
+    int lowerBoundSse2(int target) const { STATIC_B_TREE_DESCEND(rankSse2) }
+
+    __attribute__((target("avx2,popcnt"))) static std::size_t rankAvx2(const int *node_keys, int target)
+    {
+        const __m256i key{_mm256_set1_epi32(target)};
+        const __m256i *keys{reinterpret_cast<const __m256i *>(node_keys)};
+        __m256i low{_mm256_cmpgt_epi32(key, _mm256_load_si256(keys))}, high{_mm256_cmpgt_epi32(key, _mm256_load_si256(keys + 1))};
+        unsigned mask{static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(low))) | static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(high))) << 8};
+        return static_cast<std::size_t>(__builtin_popcount(mask));
+    }
+    __attribute__((target("avx2,popcnt"))) int lowerBoundAvx2(int target) const { STATIC_B_TREE_DESCEND(rankAvx2) }
+
+    __attribute__((target("avx512f,popcnt"))) static std::size_t rankAvx512(const int *node_keys, int target)
+    {
+        __mmask16 less{_mm512_cmplt_epi32_mask(_mm512_load_si512(node_keys), _mm512_set1_epi32(target))};
+        return static_cast<std::size_t>(__builtin_popcount(less));
+    }
+    __attribute__((target("avx512f,popcnt"))) int lowerBoundAvx512(int target) const { STATIC_B_TREE_DESCEND(rankAvx512) }
+
+    static LowerBoundFunction selectLowerBound()
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("popcnt"))
+            return &StaticBTree::lowerBoundAvx512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+            return &StaticBTree::lowerBoundAvx2;
+        return &StaticBTree::lowerBoundSse2;
+    }
+#else
+    static LowerBoundFunction selectLowerBound() { return &StaticBTree::lowerBoundScalar; }
+#endif
+#undef STATIC_B_TREE_DESCEND
+
+public:
+    explicit StaticBTree(std::span<const int> sorted)
+    {
+        assert(std::is_sorted(sorted.begin(), sorted.end()));
+        if (sorted.size() >= (std::size_t{1} << 30))
+            throw std::length_error{"StaticBTree: more than 2^30 elements"};
+        m_size = static_cast<int>(sorted.size());
+
+        std::size_t total{0};
+        std::size_t nodes{std::max<std::size_t>(1, (sorted.size() + node_size - 1) / node_size)};
+        while (true)
+        {
+            m_level_offsets[m_levels++] = static_cast<int>(total);
+            total += nodes * node_size;
+            if (nodes == 1)
+                break;
+            nodes = nodesAbove(nodes);
+        }
+        m_keys = FastSearchDetail::allocate(total);
+        int *keys{m_keys.get()};
+        std::copy(sorted.begin(), sorted.end(), keys);
+        std::fill(keys + sorted.size(), keys + (m_levels > 1 ? m_level_offsets[1] : node_size), INT_MAX); // the last leaf
+
+        // key j of node i of a level: the first leaf under child (17 i + j + 1) is that child times 17^(level - 1)
+        std::size_t leaves_per_child{1};
+        for (int level{1}; level < m_levels; ++level)
+        {
+            std::size_t level_keys{static_cast<std::size_t>((level + 1 < m_levels ? m_level_offsets[level + 1] : static_cast<int>(total)) - m_level_offsets[level])};
+            for (std::size_t slot{0}; slot < level_keys; ++slot)
+            {
+                std::size_t node{slot / node_size}, j{slot % node_size};
+                std::size_t first{((node * (node_size + 1) + j + 1) * leaves_per_child) * node_size};
+                keys[static_cast<std::size_t>(m_level_offsets[level]) + slot] = first < sorted.size() ? sorted[first] : INT_MAX;
+            }
+            leaves_per_child *= node_size + 1;
+        }
+    }
+
+    int size() const { return m_size; }
+
+    // the index in the sorted array of the first element >= target, size() if there is none
+    int lowerBound(int target) const
+    {
+        static const LowerBoundFunction search{selectLowerBound()}; // chosen on the first call
+        return std::min((this->*search)(target), m_size);
+    }
+
+    // the index of target in the sorted array, -1 if it's not there
+    int find(int target) const
+    {
+        int index{lowerBound(target)};
+        return index < m_size && m_keys[static_cast<std::size_t>(index)] == target ? index : -1;
+    }
+};
+
+#endif
@@ -0,0 +1,265 @@
+#ifndef LEARNED_INDEX_H
+#define LEARNED_INDEX_H
+
+#include "fast_search.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+// Searches that guess where the target is from its value, instead of starting from the middle.
+//
+// In a phone book, "Smith" is looked for near the end, not in the middle: the position of a value follows from the value when
+// the values are spread evenly. A binary search ignores that and takes log2(n) steps (27 for 100 million elements), each a cache
+// miss once the array is big. A good guess lands a few elements away from the answer, and one or two cache lines are read.
+//
+// interpolationSearch() guesses by a straight line between the two ends of the range, then between the two ends of the part
+// left, and so on: about log2(log2(n)) steps for evenly spread values. Its worst case is n steps (values like 1, 2, 3, ..., 10^9),
+// so a step that doesn't halve the range is followed by a halving step: never more than 2 log2(n) steps.
+//
+// LearnedIndex learns the positions of the values (Ferragina and Vinciguerra's PGM-index, "The PGM-index: a fully-dynamic
+// compressed learned index with provable worst-case bounds"): the array is split into segments where a straight line predicts
+// the position of each value within epsilon, and the segments are found the same way, by a smaller level of segments over
+// their first values, up to a single segment. A search computes a prediction per level and searches the 2 epsilon elements
+// around it. Uneven values (clusters, a long tail) just take more, shorter, segments.
+inline int interpolationSearch(const int *array, int target, int min, int max)
+{
+    if (array == nullptr || min > max)
+        return -1;
+    // the first element >= target is in [low, high]: array[low - 1] < target <= array[high] (when they are in the range)
+    int low{min}, high{max + 1};
+    bool interpolate{true};
+    while (low < high)
+    {
+        // between the ends of [low, high - 1]: if target is outside, it's at one of the ends
+        std::int64_t first{array[low]}, last{array[high - 1]};
+        if (target <= first)
+        {
+            high = low;
+            break;
+        }
+        if (target > last)
+        {
+            low = high;
+            break;
+        }
+        int length{high - low};
+        // first < target <= last: the guess is in [low, high - 1]
+        int guess{interpolate ? low + static_cast<int>((target - first) * (length - 1) / (last - first)) : low + length / 2};
+        if (array[guess] < target)
+            low = guess + 1;
+        else
+            high = guess;
+        interpolate = high - low <= length / 2; // a bad guess: halve the next time
+    }
+    return low <= max && array[low] == target ? low : -1;
+}
+
+// A learned index of a sorted array of ints: find(target, min, max) returns what binarySearchIterative(array, target, min, max)
+// returns (the first index of target when it is there several times).
+//
+// Each segment predicts the position of a value from the value with a straight line, in integers (a fixed point slope, so
+// that the prediction is exactly the same when the index is built and when it is used). The segments are cut by the "shrinking
+// cone" method, in one pass: the line starts at the first value of the segment, and each value narrows the range of slopes that
+// keep the values seen within epsilon; the segment ends when the range is empty. The errors of the line are then measured on
+// the values themselves: the search of the window they give can't miss, whatever the rounding or the duplicates (a value repeated
+// more than epsilon times ends its segment, whose window is then as long as needed).
+//
+// The index doesn't copy the array, it reads it: the array must outlive the index, and rebuild() must be called when it
+// changes. A rebuild is one pass over the array, O(n), and reuses the memory of the last one: apply a batch of insertions
+// and deletions to the sorted array (std::merge, std::set_difference), then rebuild.
+class LearnedIndex
+{
+public:
+    static constexpr int default_epsilon{32};
+
+private:
+    struct Segment
+    {
+        int key{};        // the first value of the segment
+        int last_key{};   // the last
+        int begin{};      // the position of the first value
+        int end{};        // one past the position of the last value
+        std::uint64_t slope{}; // positions per unit of value, times 2^32
+        int low_error{};  // the first positions of the values are >= predicted + low_error
+        int high_error{}; // the last positions of the values (but the last value) are <= predicted + high_error
+    };
+    static_assert(sizeof(Segment) == 32);
+
+    // the segments over the values of the level below: m_levels[0] over the array, the top level has one segment
+    struct Level
+    {
+        std::vector<Segment> segments{};
+        std::vector<int> keys{}; // the first value of each segment, what the level above is built on
+    };
+
+    std::span<const int> m_array{};
+    int m_epsilon{};
+    std::vector<Level> m_levels{};
+    int m_level_count{}; // m_levels is only grown: the levels above m_level_count are the memory of an old rebuild
+
+    static std::int64_t predict(const Segment &segment, int target)
+    {
+        std::uint64_t distance{static_cast<std::uint64_t>(std::int64_t{target} - segment.key)};
+        return segment.begin + static_cast<std::int64_t>((distance * segment.slope) >> 32);
+    }
+
+    // the first element of values >= target; target is in [segment.key, segment.last_key + 1)
+    static int lowerBound(const int *values, const Segment &segment, int target)
+    {
+        if (target > segment.last_key)
+            return segment.end;
+        std::int64_t predicted{predict(segment, target)};
+        int from{static_cast<int>(std::max<std::int64_t>(segment.begin, predicted + segment.low_error))};
+        int to{static_cast<int>(std::min<std::int64_t>(segment.end, predicted + segment.high_error + 1))};
+        return from + lowerBoundBranchless(values + from, to - from, target);
+    }
+
+    // cuts values (sorted, with duplicates or not) into segments
+    void buildLevel(std::span<const int> values, Level &level) const
+    {
+        level.segments.clear();
+        level.keys.clear();
+        const int size{static_cast<int>(values.size())};
+        const double epsilon{static_cast<double>(m_epsilon)};
+        int first{0};
+        while (first < size)
+        {
+            const int key{values[static_cast<std::size_t>(first)]};
+            double min_slope{0}, max_slope{std::numeric_limits<double>::infinity()};
+            // the values of the segment, one distinct value at a time: [next, run_end) are the copies of values[next]
+            int next{first}, run_end{first};
+            while (run_end < size && values[static_cast<std::size_t>(run_end)] == key)
+                ++run_end;
+            bool last{run_end - 1 - first > m_epsilon}; // too many copies of the first value: alone in its segment
+            while (!last && run_end < size)
+            {
+                next = run_end;
+                const int value{values[static_cast<std::size_t>(next)]};
+                while (run_end < size && values[static_cast<std::size_t>(run_end)] == value)
+                    ++run_end;
+                const double distance{static_cast<double>(std::int64_t{value} - key)};
+                // the first copy at most epsilon after the prediction, the last copy at most epsilon before it
+                double highest{(next + epsilon - first) / distance};
+                if (highest < min_slope)
+                {
+                    run_end = next; // this value is in the next segment
+                    break;
+                }
+                double lowest{(run_end - 1 - epsilon - first) / distance};
+                max_slope = std::min(max_slope, highest);
+                if (lowest > max_slope)
+                    last = true; // fits as the last value of the segment, whose last copy isn't used
+                else
+                    min_slope = std::max(min_slope, lowest);
+            }
+
+            Segment segment{key, values[static_cast<std::size_t>(run_end - 1)], first, run_end};
+            if (run_end - first > 1 && segment.last_key != key)
+            {
+                double slope{max_slope == std::numeric_limits<double>::infinity() ? min_slope : (min_slope + max_slope) / 2};
+                // no overflow in predict(): the distance to key is at most last_key - key
+                std::uint64_t span{static_cast<std::uint64_t>(std::int64_t{segment.last_key} - key)};
+                double limit{static_cast<double>(std::numeric_limits<std::uint64_t>::max() / span)};
+                segment.slope = static_cast<std::uint64_t>(std::min(slope * 4294967296.0, limit));
+            }
+            measure(values, segment);
+            level.segments.push_back(segment);
+            level.keys.push_back(key);
+            first = run_end;
+        }
+    }
+
+    // the errors of the prediction: what makes a search of the window exact
+    static void measure(std::span<const int> values, Segment &segment)
+    {
+        segment.low_error = 0;
+        segment.high_error = -1;
+        for (int i{segment.begin}; i < segment.end; ++i)
+        {
+            const int value{values[static_cast<std::size_t>(i)]};
+            const std::int64_t predicted{predict(segment, value)};
+            if (i == segment.begin || values[static_cast<std::size_t>(i - 1)] != value)
+                segment.low_error = static_cast<int>(std::min<std::int64_t>(segment.low_error, i - predicted));
+            if (value != segment.last_key && values[static_cast<std::size_t>(i + 1)] != value)
+                segment.high_error = static_cast<int>(std::max<std::int64_t>(segment.high_error, i - predicted));
+        }
+    }
+
+public:
+    // epsilon: the error the segments aim for. A search reads a window of about 2 epsilon elements; a smaller epsilon takes
+    // more segments (about 16'000 of 32 bytes for 100 million uniform values with 32)
+    explicit LearnedIndex(std::span<const int> sorted, int epsilon = default_epsilon)
+    {
+        if (epsilon < 1)
+            throw std::invalid_argument{"LearnedIndex: epsilon < 1"};
+        m_epsilon = epsilon;
+        rebuild(sorted);
+    }
+
+    // indexes sorted instead: the array changed, or moved
+    void rebuild(std::span<const int> sorted)
+    {
+        assert(std::is_sorted(sorted.begin(), sorted.end()));
+        if (sorted.size() >= (std::size_t{1} << 30))
+            throw std::length_error{"LearnedIndex: more than 2^30 elements"};
+        m_array = sorted;
+        m_level_count = 0;
+        std::span<const int> values{sorted};
+        do
+        {
+            if (m_level_count == static_cast<int>(m_levels.size()))
+                m_levels.emplace_back();
+            buildLevel(values, m_levels[static_cast<std::size_t>(m_level_count)]);
+            values = m_levels[static_cast<std::size_t>(m_level_count++)].keys;
+        } while (values.size() > 1);
+    }
+
+    int size() const { return static_cast<int>(m_array.size()); }
+    int levels() const { return m_level_count; }
+    // the segments over the array
+    std::size_t segments() const { return m_levels[0].segments.size(); }
+    // the memory of the index, without the array
+    std::size_t bytes() const
+    {
+        std::size_t total{0};
+        for (int level{0}; level < m_level_count; ++level)
+            total += m_levels[static_cast<std::size_t>(level)].segments.size() * (sizeof(Segment) + sizeof(int));
+        return total;
+    }
+
+    // the index of the first element >= target, size() if there is none
+    int lowerBound(int target) const
+    {
+        if (m_array.empty() || target <= m_array[0])
+            return 0;
+        // from the top: the segment of the level below is the last one whose first value is <= target (the first one is
+        // m_array[0], < target)
+        std::size_t segment{0};
+        for (int level{m_level_count - 1}; level > 0; --level)
+        {
+            const std::vector<int> &keys{m_levels[static_cast<std::size_t>(level - 1)].keys};
+            int position{lowerBound(keys.data(), m_levels[static_cast<std::size_t>(level)].segments[segment], target)};
+            segment = static_cast<std::size_t>(position < static_cast<int>(keys.size()) && keys[static_cast<std::size_t>(position)] == target ? position : position - 1);
+        }
+        return lowerBound(m_array.data(), m_levels[0].segments[segment], target);
+    }
+
+    // like binarySearchIterative(array, target, min, max): the index of target in [min, max], -1 if it's not there
+    int find(int target, int min, int max) const
+    {
+        min = std::max(min, 0);
+        max = std::min(max, size() - 1);
+        if (min > max)
+            return -1;
+        int index{std::max(lowerBound(target), min)};
+        return index <= max && m_array[static_cast<std::size_t>(index)] == target ? index : -1;
+    }
+    int find(int target) const { return find(target, 0, size() - 1); }
+};
+
+#endif
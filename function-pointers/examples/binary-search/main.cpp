@@ -1,5 +1,58 @@
+#include "fast_search.h"
+#include "learned_index.h"
+#include "timer.h"
 #include <iostream>
 #include <iterator>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <cstdint>
+#include <cassert>
+#include <iomanip>
+#include <climits>
+#include <string>
+#include <utility>
+
+/*
+    * Binary search, iterative and recursive
+    * Branchless binary search (conditional moves) and prefetching
+    * Cache friendly layouts of sorted arrays: Eytzinger, static B+ tree (S+ tree)
+    * Many searches at once: overlapping their memory accesses
+    * Guessing the position from the value: interpolation search, learned index
+*/
+
+/*
+A binary search takes log2(n) steps: 27 for 100 million elements. Yet on a big array each step of binarySearchIterative() costs
+far more than a comparison:
+    the branch (go left or right) is random: the cpu mispredicts it about half the time, and throws away the work it started
+    the element a step reads is far from the ones before: once the array is bigger than the caches, every step waits for memory,
+    and the address of the next step depends on the value being waited for, so nothing overlaps
+fast_search.h has three answers, compared below from an array that fits in the L1 cache to one that only fits in memory:
+    lowerBoundBranchless(): the same halving, with a conditional move instead of a branch, and a prefetch of both elements the
+    next step may need: twice as fast in the caches, no faster in memory
+    EytzingerArray: the array stored as a breadth first tree, so that the first levels share a few cache lines and the 16
+    descendants four levels below a node share one, prefetched ahead
+    StaticBTree: a B+ tree of 16 keys per node: log17(n) steps instead of log2(n), each a cache line compared at once with SIMD
+The layouts cost a copy of the array (and a build), and are for arrays that are searched many times. std::lower_bound is a
+branchy binary search too (compilers may turn it into a conditional move, GCC does not for this loop).
+When many targets are searched at once, searchBatch() interleaves their searches: while one waits for memory, the others
+step forward, and up to 32 cache misses are on their way together instead of one. It needs no copy of the array.
+
+All of these compare the target with elements, and never look at how far from it they are. learned_index.h uses the values
+themselves to guess where the target is (see its comments):
+    interpolationSearch(): the same contract as binarySearchIterative(), guessing by a straight line between the ends of the range
+    LearnedIndex: straight lines fitted to the array in one pass, each guaranteed within a measured error: a search reads the
+    few cache lines around its guess. It reads the array without copying it, and is rebuilt in one pass after a batch of changes
+They are compared on three distributions of values: uniform, Zipf (a few values repeated a lot, then a long sparse tail) and
+clustered (dense groups far apart). On 100 million uniform values, LearnedIndex measured 1.2 to 2 times faster than
+binarySearchIterative(); on clustered ones, from as fast to 1.2 times faster (more segments, each one more cache miss to read).
+On Zipf values it varies from run to run, from slower (272 against 169 ns on 10 million) to 1.5 times faster (135 against 209
+ns on 100 million): most targets are among the few repeated values, which a binary search also finds in the cache. The index
+takes 0.5 to 5 MB. StaticBTree stays faster still, 1.1 to 2.5 times: a search is a chain of dependent loads either way, the
+learned one (the segment, then its window of 2 epsilon elements) isn't shorter than the last levels of the tree, but the tree
+is a copy of the array. interpolationSearch() is up to 1.5 times faster than a binary search on uniform values (and sometimes
+slower), and many times slower on the others, where its guesses are far off and it falls back to halving, one cache miss per step.
+*/
 
 int binarySearchIterative(const int *array, int target, int min, int max)
 {
@@ -72,5 +125,252 @@ int main()
             std::cout << "test value " << testValues[count] << " failed.  There's something wrong with your code!\n";
     }
 
+    // against std::lower_bound, with duplicates, absent values, and the extremes of int
+    {
+        std::mt19937 random{1};
+        for (int size : {0, 1, 2, 3, 15, 16, 17, 100, 1000, 4097})
+        {
+            std::vector<int> values(static_cast<std::size_t>(size));
+            for (int &value : values)
+                value = static_cast<int>(random() % 200) - 100;
+            if (size > 2)
+            {
+                values[0] = INT_MIN;
+                values[1] = INT_MAX;
+            }
+            std::sort(values.begin(), values.end());
+            EytzingerArray eytzinger{values};
+            StaticBTree tree{values};
+            for (int target : {INT_MIN, INT_MAX, -101, 100, 0, 50})
+                for (int offset{0}; offset < 5; ++offset)
+                {
+                    int key{target > INT_MIN + 10 && target < INT_MAX - 10 ? target + offset : target};
+                    int expected{static_cast<int>(std::lower_bound(values.begin(), values.end(), key) - values.begin())};
+                    assert(lowerBoundBranchless(values.data(), size, key) == expected);
+                    assert(eytzinger.lowerBound(key) == expected && tree.lowerBound(key) == expected);
+                    int found{expected < size && values[static_cast<std::size_t>(expected)] == key ? expected : -1};
+                    assert(binarySearchBranchless(values.data(), key, 0, size - 1) == found);
+                    assert(eytzinger.find(key) == found && tree.find(key) == found);
+                }
+            // more targets than a group, with a last group that isn't full
+            std::vector<int> targets(77);
+            for (int &target : targets)
+                target = static_cast<int>(random() % 220) - 110;
+            targets[0] = INT_MIN;
+            targets[1] = INT_MAX;
+            std::vector<int> found(targets.size());
+            searchBatch(values.data(), size, targets, found);
+            for (std::size_t i{0}; i < targets.size(); ++i)
+                assert(found[i] == binarySearchBranchless(values.data(), targets[i], 0, size - 1));
+        }
+        // learned_index.h: the duplicates, the long runs of one value and the gaps are what could take a search out of its window
+        for (int size : {0, 1, 2, 3, 100, 1000, 20'000})
+            for (int spread : {1, 3, 1000, 1 << 24})
+            {
+                std::vector<int> values(static_cast<std::size_t>(size));
+                std::int64_t value{INT_MIN + 5};
+                for (int &element : values)
+                {
+                    // repeated values, small steps, now and then a big jump, and a long run of the last value when they overflow
+                    if (random() % 50 == 0)
+                        value += static_cast<std::int64_t>(random() % static_cast<unsigned>(spread)) * 50;
+                    else if (random() % 8 != 0)
+                        value += random() % static_cast<unsigned>(spread);
+                    element = static_cast<int>(std::min<std::int64_t>(value, INT_MAX - 5));
+                }
+                for (int epsilon : {1, 4, LearnedIndex::default_epsilon})
+                {
+                    LearnedIndex index{values, epsilon};
+                    auto check{[&](int key)
+                               {
+                                   int expected{static_cast<int>(std::lower_bound(values.begin(), values.end(), key) - values.begin())};
+                                   assert(index.lowerBound(key) == expected);
+                                   int found{expected < size && values[static_cast<std::size_t>(expected)] == key ? expected : -1};
+                                   assert(index.find(key) == found);
+                                   assert(interpolationSearch(values.data(), key, 0, size - 1) == found);
+                                   int min{size / 3}, max{size - 1 - size / 4};
+                                   assert(index.find(key, min, max) == binarySearchBranchless(values.data(), key, min, max));
+                                   assert(interpolationSearch(values.data(), key, min, max) == binarySearchBranchless(values.data(), key, min, max));
+                               }};
+                    for (int key : values)
+                    {
+                        check(key);
+                        check(key - 1);
+                        check(key + 1);
+                    }
+                    for (int key : {INT_MIN, INT_MIN + 1, INT_MAX, 0})
+                        check(key);
+                }
+            }
+        constexpr int size{static_cast<int>(std::size(array))};
+        EytzingerArray eytzinger{array};
+        StaticBTree tree{array};
+        for (int count{0}; count < numTestValues; ++count)
+        {
+            assert(binarySearchBranchless(array, testValues[count], 0, size - 1) == expectedValues[count]);
+            assert(eytzinger.find(testValues[count]) == expectedValues[count] && tree.find(testValues[count]) == expectedValues[count]);
+        }
+        int found[numTestValues]{};
+        searchBatch(array, size, testValues, found);
+        assert(std::equal(std::begin(found), std::end(found), std::begin(expectedValues)));
+        LearnedIndex index{array};
+        for (int count{0}; count < numTestValues; ++count)
+        {
+            assert(interpolationSearch(array, testValues[count], 0, size - 1) == expectedValues[count]);
+            assert(index.find(testValues[count], 0, size - 1) == expectedValues[count]);
+        }
+    }
+
+    /* Benchmark */
+    std::cout << "ns per search, 1M random targets (half of them in the array):\n";
+    std::cout << std::left << std::setw(11) << "elements" << std::setw(11) << "size" << std::setw(11) << "iterative" << std::setw(11)
+              << "recursive" << std::setw(18) << "std::lower_bound" << std::setw(12) << "branchless" << std::setw(11) << "Eytzinger"
+              << std::setw(13) << "StaticBTree" << "searchBatch\n";
+    std::mt19937 random{42};
+    for (int size : {1'000, 10'000, 100'000, 1'000'000, 10'000'000, 100'000'000})
+    {
+        // distinct values: every function returns the same index
+        std::vector<int> values(static_cast<std::size_t>(size));
+        for (int i{0}; i < size; ++i)
+            values[static_cast<std::size_t>(i)] = 4 * i + static_cast<int>(random() % 4);
+        std::vector<int> targets(1'000'000);
+        for (int &target : targets)
+            target = static_cast<int>(random() % (4u * static_cast<unsigned>(size)));
+        const EytzingerArray eytzinger{values};
+        const StaticBTree tree{values};
+
+        auto time{[&](auto search)
+                  {
+                      std::int64_t check{0};
+                      Timer timer{};
+                      for (int target : targets)
+                          check += search(target);
+                      double nanoseconds{timer.elapsed() * 1e9 / static_cast<double>(targets.size())};
+                      return std::pair{nanoseconds, check};
+                  }};
+        const int *data{values.data()};
+        auto [iterative, check]{time([&](int target)
+                                     { return binarySearchIterative(data, target, 0, size - 1); })};
+        auto results{std::vector{
+            time([&](int target)
+                 { return binarySearchRecursive(data, target, 0, size - 1); }),
+            time([&](int target)
+                 {
+                     auto it{std::lower_bound(values.begin(), values.end(), target)};
+                     return it != values.end() && *it == target ? static_cast<int>(it - values.begin()) : -1;
+                 }),
+            time([&](int target)
+                 { return binarySearchBranchless(data, target, 0, size - 1); }),
+            time([&](int target)
+                 { return eytzinger.find(target); }),
+            time([&](int target)
+                 { return tree.find(target); })}};
+
+        // all the targets at once
+        std::vector<int> found(targets.size());
+        Timer timer{};
+        searchBatch(data, size, targets, found);
+        double batch_time{timer.elapsed() * 1e9 / static_cast<double>(targets.size())};
+        std::int64_t batch_check{0};
+        for (int index : found)
+            batch_check += index;
+        assert(batch_check == check);
+
+        std::cout << std::setw(11) << size << std::setw(11) << std::to_string(values.size() * sizeof(int) / 1024) + " KB" << std::setw(11) << iterative;
+        int widths[]{11, 18, 12, 11, 13};
+        for (std::size_t i{0}; i < results.size(); ++i)
+        {
+            assert(results[i].second == check);
+            std::cout << std::setw(widths[i]) << results[i].first;
+        }
+        std::cout << batch_time << '\n';
+    }
+
+    /* Benchmark: learned_index.h on three distributions of values */
+    std::cout << "\nns per search, 1M targets next to values of the array; LearnedIndex (epsilon " << LearnedIndex::default_epsilon << ") size and build time:\n";
+    std::cout << std::left << std::setw(11) << "values" << std::setw(11) << "elements" << std::setw(11) << "iterative" << std::setw(15)
+              << "interpolation" << std::setw(13) << "StaticBTree" << std::setw(14) << "LearnedIndex" << std::setw(10) << "segments"
+              << std::setw(12) << "index size" << "rebuild\n";
+    for (int size : {1'000'000, 10'000'000, 100'000'000})
+        for (const char *distribution : {"uniform", "Zipf", "clustered"})
+        {
+            std::vector<int> values(static_cast<std::size_t>(size));
+            std::uniform_real_distribution<double> uniform{0, 1};
+            if (distribution == std::string{"uniform"})
+            {
+                int value{0};
+                for (int &element : values)
+                    element = value += static_cast<int>(random() % 8);
+            }
+            else if (distribution == std::string{"Zipf"})
+            {
+                // the quantiles of a density falling as 1 / value^2 (a Zipf law of exponent 2), one random quantile per 1 / size:
+                // the first values repeated thousands of times, then further and further apart
+                for (int i{0}; i < size; ++i)
+                {
+                    double quantile{(i + uniform(random)) / size};
+                    values[static_cast<std::size_t>(i)] = static_cast<int>(std::min(1000 / (1 - quantile), double{INT_MAX}));
+                }
+            }
+            else
+            {
+                // groups of 10'000 values (a normal distribution 20'000 wide) spread over the ints
+                constexpr int group_size{10'000};
+                const std::int64_t spacing{(std::int64_t{1} << 32) / (size / group_size + 1)};
+                std::normal_distribution<double> normal{0, 20'000};
+                for (int first{0}; first < size; first += group_size)
+                {
+                    std::int64_t center{INT_MIN + spacing * (first / group_size + 1)};
+                    auto group{values.begin() + first};
+                    for (auto element{group}; element != group + group_size; ++element)
+                        *element = static_cast<int>(center + std::clamp<std::int64_t>(std::llround(normal(random)), -spacing / 2 + 1, spacing / 2 - 1));
+                    std::sort(group, group + group_size);
+                }
+            }
+
+            std::vector<int> targets(1'000'000);
+            for (int &target : targets)
+            {
+                int value{values[random() % values.size()]};
+                target = value < INT_MAX && random() % 2 ? value + 1 : value;
+            }
+            const StaticBTree tree{values};
+            LearnedIndex index{values};
+            Timer rebuild_timer{};
+            index.rebuild(values); // like after a batch of changes: the memory of the last build is reused
+            double rebuild_time{rebuild_timer.elapsed()};
+
+            // binarySearchIterative() may return another copy of a repeated value: compare the number of targets found
+            auto time{[&](auto search)
+                      {
+                          int found{0};
+                          Timer timer{};
+                          for (int target : targets)
+                              found += search(target) >= 0;
+                          double nanoseconds{timer.elapsed() * 1e9 / static_cast<double>(targets.size())};
+                          return std::pair{nanoseconds, found};
+                      }};
+            const int *data{values.data()};
+            auto [iterative, found]{time([&](int target)
+                                         { return binarySearchIterative(data, target, 0, size - 1); })};
+            auto results{std::vector{
+                time([&](int target)
+                     { return interpolationSearch(data, target, 0, size - 1); }),
+                time([&](int target)
+                     { return tree.find(target); }),
+                time([&](int target)
+                     { return index.find(target, 0, size - 1); })}};
+
+            std::cout << std::setw(11) << distribution << std::setw(11) << size << std::setw(11) << iterative;
+            int widths[]{15, 13, 14};
+            for (std::size_t i{0}; i < results.size(); ++i)
+            {
+                assert(results[i].second == found);
+                std::cout << std::setw(widths[i]) << results[i].first;
+            }
+            std::cout << std::setw(10) << index.segments() << std::setw(12) << std::to_string(index.bytes() / 1024) + " KB"
+                      << rebuild_time * 1e3 << " ms\n";
+        }
+
     return 0;
-}
\ No newline at end of file
+}
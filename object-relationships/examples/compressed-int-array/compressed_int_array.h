@@ -0,0 +1,311 @@
+#ifndef COMPRESSED_INT_ARRAY_H
+#define COMPRESSED_INT_ARRAY_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <utility>
+#include <vector>
+
+// An array of ints stored in as few bits as their values need.
+//
+// The elements are cut in blocks of 128. Each block is stored with one of two encodings, whichever is smaller:
+//   frame of reference: the block minimum (the "base") is stored once, each element is stored as element - base in just enough bits
+//                       for the largest difference (values between 1000 and 1200 need 8 bits each instead of 32)
+//   delta:              for sorted or slowly changing data: the first element, then the differences between elements (the gaps),
+//                       in as many bits as the largest gap needs
+//
+// The packed values are laid out for SIMD ("vertical" layout): a block is 4 lanes of 32 values, value k is in lane k % 4, and the
+// 32 bit words of the 4 lanes are interleaved. Unpacking then does the same shift and mask in the 4 lanes at once, which is what
+// a vector instruction does. For the same reason a delta is the gap to the element 4 positions earlier (same lane, previous row):
+// decoding a row of 4 is a single vector addition to the row before.
+//
+// Random access costs two 32 bit loads, a shift and a mask in a frame of reference block, and adds up the gaps of the lane in a delta
+// block (at most 31 of them, still a bounded cost whatever the size of the array).
+// Appending is supported (push_back): the last, incomplete block stays uncompressed until it is full.
+class CompressedIntArray
+{
+public:
+    static constexpr int block_size{128};
+    static constexpr int lanes{4};
+    static constexpr int rows{block_size / lanes};
+
+    enum class Encoding : std::uint8_t
+    {
+        frame_of_reference,
+        delta,
+    };
+
+private:
+    struct Block
+    {
+        std::uint32_t offset{}; // first word of the packed values in m_words
+        std::int32_t base{};    // frame of reference: the minimum, delta: the first element
+        std::uint8_t width{};   // bits per packed value (0 to 32)
+        Encoding encoding{};
+        std::int32_t min{}; // the block's range: lets count() skip blocks
+        std::int32_t max{};
+    };
+
+    std::vector<Block> m_blocks{};
+    // a block of width w takes 4 * w words; 4 words of padding at the end, read (and ignored) by the last extractions
+    std::vector<std::uint32_t> m_words{std::vector<std::uint32_t>(lanes)};
+    std::array<int, block_size> m_tail{}; // the incomplete last block, not compressed yet
+    int m_tail_length{};
+
+    static constexpr std::uint32_t mask(int width)
+    {
+        return width == 32 ? UINT32_MAX : (std::uint32_t{1} << width) - 1;
+    }
+
+    // packed value k of the block starting at words; width > 0 (a block of width 0 has no words)
+    static std::uint32_t extract(const std::uint32_t *words, int k, int width)
+    {
+        int lane{k % lanes};
+        int bit{(k / lanes) * width};
+        const std::uint32_t *word{words + (bit / 32) * lanes + lane};
+        std::uint64_t pair{word[0] | (std::uint64_t{word[lanes]} << 32)}; // the value may continue in the lane's next word
+        return static_cast<std::uint32_t>(pair >> (bit % 32)) & mask(width);
+    }
+
+    // appends the block's 128 values, width bits each, in the vertical layout
+    void pack(const std::array<std::uint32_t, block_size> &values, int width)
+    {
+        std::size_t offset{m_words.size() - lanes}; // overwrite the padding
+        m_words.resize(offset + static_cast<std::size_t>(lanes * width) + lanes, 0);
+        std::uint32_t *words{m_words.data() + offset};
+        for (int k{0}; k < block_size && width > 0; ++k)
+        {
+            int lane{k % lanes};
+            int bit{(k / lanes) * width};
+            int shift{bit % 32};
+            std::uint32_t *word{words + (bit / 32) * lanes + lane};
+            word[0] |= values[static_cast<std::size_t>(k)] << shift;
+            if (shift + width > 32)
+                word[lanes] |= values[static_cast<std::size_t>(k)] >> (32 - shift);
+        }
+    }
+
+    void encodeBlock(std::span<const int> values)
+    {
+        assert(values.size() == block_size);
+        Block block{};
+        block.offset = static_cast<std::uint32_t>(m_words.size() - lanes);
+        auto [min, max]{std::minmax_element(values.begin(), values.end())};
+        block.min = *min;
+        block.max = *max;
+
+        // unsigned arithmetic: the difference of any two ints fits in 32 bits
+        std::array<std::uint32_t, block_size> offsets{};
+        for (int k{0}; k < block_size; ++k)
+            offsets[static_cast<std::size_t>(k)] = static_cast<std::uint32_t>(values[k]) - static_cast<std::uint32_t>(block.min);
+        int offsets_width{static_cast<int>(std::bit_width(static_cast<std::uint32_t>(block.max) - static_cast<std::uint32_t>(block.min)))};
+
+        // the first row is relative to the first element, the other rows to the row before
+        std::array<std::uint32_t, block_size> deltas{};
+        std::uint32_t largest{0};
+        for (int k{0}; k < block_size; ++k)
+        {
+            int previous{k < lanes ? values[0] : values[k - lanes]};
+            deltas[static_cast<std::size_t>(k)] = static_cast<std::uint32_t>(values[k]) - static_cast<std::uint32_t>(previous);
+            largest = std::max(largest, deltas[static_cast<std::size_t>(k)]);
+        }
+        int deltas_width{static_cast<int>(std::bit_width(largest))};
+
+        if (deltas_width < offsets_width)
+        {
+            block.encoding = Encoding::delta;
+            block.base = values[0];
+            block.width = static_cast<std::uint8_t>(deltas_width);
+            pack(deltas, deltas_width);
+        }
+        else
+        {
+            block.encoding = Encoding::frame_of_reference;
+            block.base = block.min;
+            block.width = static_cast<std::uint8_t>(offsets_width);
+            pack(offsets, offsets_width);
+        }
+        m_blocks.push_back(block);
+    }
+
+    // unpacks one row (4 lanes): with Width and Row known at compile time, the word index and the shifts are constants
+    // and the 4 lanes become one vector shift, or, and and
+    template <int Width, int Row>
+    static void unpackRow(const std::uint32_t *words, std::uint32_t *out)
+    {
+        constexpr int bit{Row * Width};
+        constexpr int shift{bit % 32};
+        const std::uint32_t *word{words + (bit / 32) * lanes};
+        for (int lane{0}; lane < lanes; ++lane)
+        {
+            std::uint32_t value{word[lane] >> shift};
+            if constexpr (shift + Width > 32)
+                value |= word[lanes + lane] << (32 - shift);
+            out[Row * lanes + lane] = value & mask(Width);
+        }
+    }
+    template <int Width>
+    static void unpack(const std::uint32_t *words, std::uint32_t *out)
+    {
+        if constexpr (Width == 0)
+            std::fill_n(out, block_size, 0u);
+        else
+            [&]<int... Row>(std::integer_sequence<int, Row...>)
+            { (unpackRow<Width, Row>(words, out), ...); }(std::make_integer_sequence<int, rows>{});
+    }
+    // calls unpack<width>: a table of the 33 instantiations indexed by the runtime width
+    static void unpack(int width, const std::uint32_t *words, std::uint32_t *out)
+    {
+        using Unpack = void (*)(const std::uint32_t *, std::uint32_t *);
+        static constexpr auto table{[]<int... Width>(std::integer_sequence<int, Width...>)
+                                    { return std::array<Unpack, sizeof...(Width)>{&unpack<Width>...}; }(std::make_integer_sequence<int, 33>{})};
+        table[static_cast<std::size_t>(width)](words, out);
+    }
+
+public:
+    CompressedIntArray() = default;
+    explicit CompressedIntArray(std::span<const int> values)
+    {
+        std::size_t full{values.size() / block_size * block_size};
+        m_blocks.reserve(full / block_size);
+        for (std::size_t i{0}; i < full; i += block_size)
+            encodeBlock(values.subspan(i, block_size));
+        for (std::size_t i{full}; i < values.size(); ++i)
+            push_back(values[i]);
+    }
+
+    std::int64_t size() const { return static_cast<std::int64_t>(m_blocks.size()) * block_size + m_tail_length; }
+    bool empty() const { return size() == 0; }
+    int blockCount() const { return static_cast<int>(m_blocks.size()) + (m_tail_length > 0); }
+    // memory used by the elements (packed values, block descriptions and the uncompressed tail)
+    std::size_t bytes() const { return m_words.size() * sizeof(std::uint32_t) + m_blocks.size() * sizeof(Block) + sizeof(m_tail); }
+    Encoding encoding(int block) const { return m_blocks[static_cast<std::size_t>(block)].encoding; }
+
+    void push_back(int value)
+    {
+        m_tail[static_cast<std::size_t>(m_tail_length++)] = value;
+        if (m_tail_length == block_size)
+        {
+            encodeBlock(m_tail);
+            m_tail_length = 0;
+        }
+    }
+
+    int operator[](std::int64_t index) const
+    {
+        assert(index >= 0 && index < size());
+        std::size_t block_index{static_cast<std::size_t>(index / block_size)};
+        int k{static_cast<int>(index % block_size)};
+        if (block_index == m_blocks.size())
+            return m_tail[static_cast<std::size_t>(k)];
+
+        const Block &block{m_blocks[block_index]};
+        const std::uint32_t *words{m_words.data() + block.offset};
+        // width 0: every offset (or gap) is 0, and the block has no words to read, only the padding of the next one
+        if (block.width == 0)
+            return block.base;
+        std::uint32_t value{static_cast<std::uint32_t>(block.base)};
+        if (block.encoding == Encoding::frame_of_reference)
+            return static_cast<int>(value + extract(words, k, block.width));
+
+        // the gaps of rows 0 to k / 4 in lane k % 4, walking the lane's bits
+        const std::uint32_t *lane_words{words + k % lanes};
+        const int width{block.width};
+        const std::uint32_t value_mask{mask(width)};
+        for (int row{0}, bit{0}; row <= k / lanes; ++row, bit += width)
+        {
+            const std::uint32_t *word{lane_words + (bit / 32) * lanes};
+            std::uint64_t pair{word[0] | (std::uint64_t{word[lanes]} << 32)};
+            value += static_cast<std::uint32_t>(pair >> (bit % 32)) & value_mask;
+        }
+        return static_cast<int>(value);
+    }
+
+    // decodes block number block into out (block_size elements, fewer for the last block), returns the number of elements
+    int decodeBlock(int block_index, int *out) const
+    {
+        if (static_cast<std::size_t>(block_index) == m_blocks.size())
+        {
+            std::copy_n(m_tail.begin(), m_tail_length, out);
+            return m_tail_length;
+        }
+        const Block &block{m_blocks[static_cast<std::size_t>(block_index)]};
+        std::uint32_t packed[block_size];
+        unpack(block.width, m_words.data() + block.offset, packed);
+        std::uint32_t base{static_cast<std::uint32_t>(block.base)};
+        if (block.encoding == Encoding::frame_of_reference)
+        {
+            for (int k{0}; k < block_size; ++k)
+                out[k] = static_cast<int>(base + packed[k]);
+        }
+        else
+        {
+            // a prefix sum per lane: row r = row r - 1 + gaps, 4 lanes at a time
+            for (int k{0}; k < lanes; ++k)
+                packed[k] += base;
+            for (int k{lanes}; k < block_size; ++k)
+                packed[k] += packed[k - lanes];
+            for (int k{0}; k < block_size; ++k)
+                out[k] = static_cast<int>(packed[k]);
+        }
+        return block_size;
+    }
+
+    void decode(std::span<int> out) const
+    {
+        assert(static_cast<std::int64_t>(out.size()) >= size());
+        for (int block{0}; block < blockCount(); ++block)
+            decodeBlock(block, out.data() + static_cast<std::size_t>(block) * block_size);
+    }
+
+    // the scans decode one block at a time into a small buffer that stays in the L1 cache
+    std::int64_t sum() const
+    {
+        std::int64_t total{0};
+        for (std::size_t b{0}; b < m_blocks.size(); ++b)
+        {
+            const Block &block{m_blocks[b]};
+            if (block.encoding == Encoding::frame_of_reference)
+            {
+                // no need to add the base 128 times
+                std::uint32_t packed[block_size];
+                unpack(block.width, m_words.data() + block.offset, packed);
+                std::int64_t block_total{std::int64_t{block.base} * block_size};
+                for (std::uint32_t value : packed)
+                    block_total += value;
+                total += block_total;
+                continue;
+            }
+            int values[block_size];
+            decodeBlock(static_cast<int>(b), values);
+            for (int value : values)
+                total += value;
+        }
+        for (int k{0}; k < m_tail_length; ++k)
+            total += m_tail[static_cast<std::size_t>(k)];
+        return total;
+    }
+
+    std::int64_t count(int target) const
+    {
+        std::int64_t result{0};
+        int values[block_size];
+        for (int b{0}; b < blockCount(); ++b)
+        {
+            // the range of the block says when the target can't be in it: sorted data skips almost every block without decoding it
+            if (static_cast<std::size_t>(b) < m_blocks.size() && (target < m_blocks[static_cast<std::size_t>(b)].min || target > m_blocks[static_cast<std::size_t>(b)].max))
+                continue;
+            int length{decodeBlock(b, values)};
+            for (int k{0}; k < length; ++k)
+                result += (values[k] == target);
+        }
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include "compressed_int_array.h"
+#include "timer.h"
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <algorithm>
+#include <cassert>
+
+/*
+    * Compressed arrays: bit packing
+    * Frame of reference and delta encoding
+    * Random access in a compressed array
+*/
+
+/*
+An int takes 32 bits whatever its value. Many arrays only hold small numbers (ages, grades, counters) or sorted ones (ids, timestamps):
+    values in 0..1000 need 10 bits: bit packing stores them in 10 bits each instead of 32
+    values in 1'000'000..1'001'000 need 20 bits, but their difference to the smallest one only needs 10: frame of reference
+    sorted values grow without bound, but the gaps between neighbours stay small: delta encoding stores the gaps
+CompressedIntArray picks the smaller of the last two for each block of 128 values.
+
+Less memory also means less memory traffic: a scan over a large array is limited by how fast the memory delivers the bytes, not by
+the cpu. Unpacking costs a few instructions per value, but 3 times fewer bytes have to be read.
+Random access is where compression costs: reading one element touches the block description and the packed words (two cache misses
+instead of one), and adds up to 31 gaps in a delta block. Compressed arrays are for data that is mostly scanned.
+*/
+
+struct Dataset
+{
+    const char *name{};
+    std::vector<int> values{};
+};
+
+int main()
+{
+    /* Basic use */
+    CompressedIntArray small{};
+    for (int i{0}; i < 1000; ++i)
+        small.push_back(i % 7 - 3);
+    assert(small.size() == 1000 && small[0] == -3 && small[999] == 999 % 7 - 3);
+    assert(small.count(0) == 143);
+    // blocks of width 0 (all 128 values equal, or all gaps 0) take no words: the last block must not read past the end
+    for (int length : {128, 129, 256})
+    {
+        CompressedIntArray constant{std::vector<int>(static_cast<std::size_t>(length), 7)};
+        for (int i{0}; i < length; ++i)
+            assert(constant[i] == 7);
+        assert(constant.count(7) == length && constant.sum() == 7 * length);
+    }
+
+    /* Datasets */
+    constexpr int count{16 * 1024 * 1024};
+    std::mt19937 mt{42};
+    std::vector<Dataset> datasets{};
+
+    Dataset grades{"small range (0..1000)"};
+    std::uniform_int_distribution<int> grade{0, 1000};
+    for (int i{0}; i < count; ++i)
+        grades.values.push_back(grade(mt));
+    datasets.push_back(std::move(grades));
+
+    Dataset ids{"sorted (gaps of 0..15)"};
+    std::uniform_int_distribution<int> gap{0, 15};
+    int id{1'000'000};
+    for (int i{0}; i < count; ++i)
+        ids.values.push_back(id += gap(mt));
+    datasets.push_back(std::move(ids));
+
+    Dataset random{"full range random"};
+    std::uniform_int_distribution<int> any{INT32_MIN, INT32_MAX};
+    for (int i{0}; i < count; ++i)
+        random.values.push_back(any(mt));
+    datasets.push_back(std::move(random));
+
+    for (const Dataset &dataset : datasets)
+    {
+        const std::vector<int> &values{dataset.values};
+        Timer timer{};
+        CompressedIntArray compressed{values};
+        double encode_time{timer.elapsed()};
+
+        // check random access and decoding
+        std::vector<int> decoded(values.size());
+        compressed.decode(decoded);
+        assert(decoded == values);
+        for (int i{0}; i < count; i += 9973)
+            assert(compressed[i] == values[static_cast<std::size_t>(i)]);
+
+        constexpr int rounds{10};
+        timer.reset();
+        std::int64_t plain_sum{0};
+        for (int round{0}; round < rounds; ++round)
+            for (int value : values)
+                plain_sum += value;
+        double plain_time{timer.elapsed()};
+
+        timer.reset();
+        std::int64_t compressed_sum{0};
+        for (int round{0}; round < rounds; ++round)
+            compressed_sum += compressed.sum();
+        double compressed_time{timer.elapsed()};
+        assert(plain_sum == compressed_sum);
+
+        // count() skips the blocks whose range can't hold the target
+        int target{values[values.size() / 2]};
+        timer.reset();
+        std::int64_t plain_count{0};
+        for (int round{0}; round < rounds; ++round)
+            plain_count += std::count(values.begin(), values.end(), target);
+        double plain_count_time{timer.elapsed()};
+        timer.reset();
+        std::int64_t compressed_count{0};
+        for (int round{0}; round < rounds; ++round)
+            compressed_count += compressed.count(target);
+        double compressed_count_time{timer.elapsed()};
+        assert(plain_count == compressed_count);
+
+        // random access
+        constexpr int reads{5'000'000};
+        std::uniform_int_distribution<int> index{0, count - 1};
+        std::vector<int> indexes(reads);
+        for (int &i : indexes)
+            i = index(mt);
+        timer.reset();
+        std::int64_t plain_reads{0};
+        for (int i : indexes)
+            plain_reads += values[static_cast<std::size_t>(i)];
+        double plain_read_time{timer.elapsed()};
+        timer.reset();
+        std::int64_t compressed_reads{0};
+        for (int i : indexes)
+            compressed_reads += compressed[i];
+        double compressed_read_time{timer.elapsed()};
+        assert(plain_reads == compressed_reads);
+
+        double plain_bytes{static_cast<double>(values.size() * sizeof(int))};
+        std::cout << dataset.name << ":\n";
+        std::cout << "  memory       " << plain_bytes / (1024 * 1024) << " MiB -> " << static_cast<double>(compressed.bytes()) / (1024 * 1024)
+                  << " MiB (x" << plain_bytes / static_cast<double>(compressed.bytes()) << "), encoded in " << encode_time << " s\n";
+        std::cout << "  sum          int array " << plain_time / rounds << " s, compressed " << compressed_time / rounds << " s\n";
+        std::cout << "  count        int array " << plain_count_time / rounds << " s, compressed " << compressed_count_time / rounds << " s\n";
+        std::cout << "  random reads int array " << plain_read_time << " s, compressed " << compressed_read_time << " s\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef COW_INT_ARRAY_H
+#define COW_INT_ARRAY_H
+
+#include "shared_buffer.h"
+#include <algorithm>
+#include <cassert>
+#include <initializer_list>
+
+// An IntArray whose copies share their elements until one of them is modified (copy-on-write).
+// It's a separate class rather than a flag of IntArray: the const/non-const split of the interface is what makes it work
+// (reading through a const CowIntArray never copies, anything that hands out a non-const int* or int& makes the array unique first).
+//
+// Careful: the non-const operator[] detaches even when it's only used to read, call it through a const reference
+// (std::as_const) in read-only loops. And a reference obtained from it is only valid until the array is copied.
+template <Sharing S = Sharing::atomic>
+class CowIntArray
+{
+private:
+    SharedBuffer<int, S> m_buffer{};
+
+public:
+    CowIntArray() = default;
+    CowIntArray(int length) : m_buffer(length)
+    {
+        assert(length >= 0);
+        std::fill_n(m_buffer.mutableData(), length, 0);
+        m_buffer.setLength(length);
+    }
+    CowIntArray(std::initializer_list<int> list) : m_buffer(static_cast<int>(list.size()))
+    {
+        std::copy(list.begin(), list.end(), m_buffer.mutableData());
+        m_buffer.setLength(static_cast<int>(list.size()));
+    }
+    // the copy constructor, copy assignment and moves of SharedBuffer are exactly what we need: no user-defined ones here
+
+    int size() const { return m_buffer.length(); }
+    int capacity() const { return m_buffer.capacity(); }
+    bool empty() const { return size() == 0; }
+    // how many arrays share the elements (for demos and tests)
+    int useCount() const { return m_buffer.useCount(); }
+
+    const int &operator[](int index) const
+    {
+        assert(index >= 0 && index < size());
+        return m_buffer.data()[index];
+    }
+    int &operator[](int index)
+    {
+        assert(index >= 0 && index < size());
+        return m_buffer.mutableData()[index];
+    }
+
+    const int *data() const { return m_buffer.data(); }
+    int *mutableData() { return m_buffer.mutableData(); }
+    const int *begin() const { return data(); }
+    const int *end() const { return data() + size(); }
+
+    void push_back(int value)
+    {
+        int length{size()};
+        int *data{m_buffer.mutableData(length < capacity() ? 0 : std::max(4, 2 * capacity()))};
+        data[length] = value;
+        m_buffer.setLength(length + 1);
+    }
+};
+
+#endif
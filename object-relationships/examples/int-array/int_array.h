@@ -0,0 +1,231 @@
+#ifndef INT_ARRAY_H
+#define INT_ARRAY_H
+
+#include <algorithm>
+#include <cassert>
+#include <initializer_list>
+#include <memory_resource>
+#include <utility>
+
+// The container class of object-relationships/main.cpp, grown into a dynamic array:
+// it keeps a capacity next to its length, so appending an element only reallocates when the capacity is used up.
+// The memory comes from a polymorphic allocator (std::pmr): by default new/delete, but the caller can hand it an arena or a pool.
+class IntArray
+{
+public:
+    // makes std::pmr containers of IntArray pass their memory resource down to the elements
+    using allocator_type = std::pmr::polymorphic_allocator<int>;
+    // the buffer starts on a cache line: a 64 byte (AVX-512) vector load never straddles two lines (see int_array_ops.h)
+    static constexpr std::size_t data_alignment{64};
+
+private:
+    int m_length{};
+    int m_capacity{};
+    int *m_data{};
+    allocator_type m_alloc{};
+
+    int *allocate(int count)
+    {
+        return count ? static_cast<int *>(m_alloc.allocate_bytes(sizeof(int) * static_cast<std::size_t>(count), data_alignment)) : nullptr;
+    }
+    void deallocate()
+    {
+        if (m_data)
+            m_alloc.deallocate_bytes(m_data, sizeof(int) * static_cast<std::size_t>(m_capacity), data_alignment);
+    }
+
+    // moves the elements into a new buffer of new_capacity elements (new elements are left uninitialized)
+    void reallocateKeep(int new_capacity)
+    {
+        assert(new_capacity >= m_length);
+        int *new_data{allocate(new_capacity)};
+        std::copy_n(m_data, m_length, new_data);
+        deallocate();
+        m_data = new_data;
+        m_capacity = new_capacity;
+    }
+
+    // geometric growth: doubling the capacity makes n push_back() calls cost O(n) copies in total
+    // (each element is copied once on average) instead of O(n^2) when growing by exactly what's needed
+    void grow(int min_capacity)
+    {
+        reallocateKeep(std::max(min_capacity, m_capacity ? 2 * m_capacity : 4));
+    }
+
+public:
+    IntArray() = default;
+    explicit IntArray(const allocator_type &alloc) : m_alloc{alloc} {}
+    IntArray(int length, const allocator_type &alloc = {})
+        : m_length{length}, m_capacity{length}, m_alloc{alloc}
+    {
+        assert(length >= 0);
+        m_data = allocate(length);
+        std::fill_n(m_data, length, 0);
+    }
+    // initializer list constructor
+    IntArray(std::initializer_list<int> list, const allocator_type &alloc = {})
+        : m_length{static_cast<int>(list.size())}, m_capacity{m_length}, m_alloc{alloc}
+    {
+        m_data = allocate(m_length);
+        std::copy(list.begin(), list.end(), m_data);
+    }
+    // initializer list assignement
+    IntArray &operator=(std::initializer_list<int> list)
+    {
+        *this = IntArray{list, m_alloc}; // move assignment: same resource, so no extra copy
+        return *this;
+    }
+
+    // Copy semantics: only copies the used part of the source
+    // like the std::pmr containers, a copy doesn't inherit the source's resource (it may be a short-lived arena):
+    // it uses the default resource unless the caller passes one
+    IntArray(const IntArray &arr, const allocator_type &alloc = {})
+        : m_length{arr.m_length}, m_capacity{arr.m_length}, m_alloc{alloc}
+    {
+        m_data = allocate(m_length);
+        std::copy_n(arr.m_data, m_length, m_data);
+    }
+    IntArray &operator=(const IntArray &arr)
+    {
+        if (&arr == this)
+            return *this;
+        if (arr.m_length > m_capacity) // reuse our buffer when it's big enough
+        {
+            deallocate();
+            m_data = nullptr;
+            m_capacity = 0;
+            m_length = 0;
+            reallocateKeep(arr.m_length);
+        }
+        std::copy_n(arr.m_data, arr.m_length, m_data);
+        m_length = arr.m_length;
+        return *this;
+    }
+
+    // Move semantics: steal the buffer (and the resource that owns it), leave the source empty
+    // noexcept lets std::vector<IntArray> move (instead of copy) its elements when it grows
+    IntArray(IntArray &&arr) noexcept
+        : m_length{std::exchange(arr.m_length, 0)},
+          m_capacity{std::exchange(arr.m_capacity, 0)},
+          m_data{std::exchange(arr.m_data, nullptr)},
+          m_alloc{arr.m_alloc}
+    {
+    }
+    // allocator-extended move: only steals the buffer when both arrays draw from the same resource
+    IntArray(IntArray &&arr, const allocator_type &alloc) : m_alloc{alloc}
+    {
+        *this = std::move(arr);
+    }
+    // the resource stays with the object: when the two resources differ the buffer can't change hands, the elements are copied
+    // (that's why this one can't be noexcept, std::pmr::vector has the same rule)
+    IntArray &operator=(IntArray &&arr)
+    {
+        if (&arr == this)
+            return *this;
+        if (m_alloc != arr.m_alloc)
+        {
+            *this = static_cast<const IntArray &>(arr);
+            arr.erase();
+            return *this;
+        }
+        deallocate();
+        m_length = std::exchange(arr.m_length, 0);
+        m_capacity = std::exchange(arr.m_capacity, 0);
+        m_data = std::exchange(arr.m_data, nullptr);
+        return *this;
+    }
+
+    ~IntArray()
+    {
+        deallocate();
+    }
+
+    allocator_type get_allocator() const { return m_alloc; }
+
+    // frees the memory
+    void erase()
+    {
+        deallocate();
+        m_data = nullptr;
+        m_length = 0;
+        m_capacity = 0;
+    }
+    // keeps the memory for the next elements
+    void clear() { m_length = 0; }
+
+    int size() const { return m_length; }
+    int capacity() const { return m_capacity; }
+    bool empty() const { return m_length == 0; }
+
+    int &operator[](int index)
+    {
+        assert(index >= 0 && index < m_length);
+        return m_data[index];
+    }
+    const int &operator[](int index) const
+    {
+        assert(index >= 0 && index < m_length);
+        return m_data[index];
+    }
+
+    int *data() { return m_data; }
+    const int *data() const { return m_data; }
+    // begin()/end() make range-based for loops and the standard algorithms work
+    int *begin() { return m_data; }
+    int *end() { return m_data + m_length; }
+    const int *begin() const { return m_data; }
+    const int *end() const { return m_data + m_length; }
+
+    // makes room for new_capacity elements without changing the length
+    void reserve(int new_capacity)
+    {
+        if (new_capacity > m_capacity)
+            reallocateKeep(new_capacity);
+    }
+    // gives back the unused capacity
+    void shrink_to_fit()
+    {
+        if (m_capacity > m_length)
+            reallocateKeep(m_length);
+    }
+
+    void push_back(int value)
+    {
+        if (m_length == m_capacity)
+            grow(m_length + 1);
+        m_data[m_length++] = value;
+    }
+    // builds the element in place and returns it (for int this is the same as push_back)
+    template <typename... Args>
+    int &emplace_back(Args &&...args)
+    {
+        if (m_length == m_capacity)
+            grow(m_length + 1);
+        m_data[m_length] = int(std::forward<Args>(args)...);
+        return m_data[m_length++];
+    }
+    void pop_back()
+    {
+        assert(m_length > 0);
+        --m_length;
+    }
+
+    // new elements are zero
+    void resize(int new_length)
+    {
+        int old_length{m_length};
+        resizeUninitialized(new_length);
+        if (new_length > old_length)
+            std::fill(m_data + old_length, m_data + new_length, 0);
+    }
+    // new elements are left uninitialized: for callers that overwrite them right away (no useless zeroing)
+    void resizeUninitialized(int new_length)
+    {
+        assert(new_length >= 0);
+        if (new_length > m_capacity)
+            grow(new_length);
+        m_length = new_length;
+    }
+};
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef INT_ARRAY_OPS_H
+#define INT_ARRAY_OPS_H
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <span>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Bulk operations over a whole IntArray (or any contiguous range of ints, through std::span).
+//
+// The loops are written so the compiler can vectorize them (no early exit, no dependency from one iteration to the next).
+// INT_ARRAY_DISPATCH asks GCC/clang to compile each function once per instruction set and to pick the best version when the
+// program starts (from what the cpu reports): one binary runs the AVX-512 code on recent x86 cpus, AVX2 on older ones and the
+// baseline (SSE2) code everywhere else. Other compilers/targets just get the baseline version.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(INT_ARRAY_NO_DISPATCH)
+#define INT_ARRAY_DISPATCH __attribute__((target_clones("default", "avx2", "avx512f")))
+#else
+#define INT_ARRAY_DISPATCH
+#endif
+
+namespace IntArrayOps
+{
+    // the sums are 64 bit: adding up a few million ints overflows an int
+    INT_ARRAY_DISPATCH inline std::int64_t sum(std::span<const int> values)
+    {
+        std::int64_t total{0};
+        for (int value : values)
+            total += value;
+        return total;
+    }
+
+    struct MinMax
+    {
+        int min{INT_MAX};
+        int max{INT_MIN};
+    };
+    // both in one pass over the memory
+    INT_ARRAY_DISPATCH inline MinMax minMax(std::span<const int> values)
+    {
+        MinMax result{};
+        for (int value : values)
+        {
+            result.min = std::min(result.min, value);
+            result.max = std::max(result.max, value);
+        }
+        return result;
+    }
+
+    INT_ARRAY_DISPATCH inline std::int64_t dot(std::span<const int> a, std::span<const int> b)
+    {
+        assert(a.size() == b.size());
+        std::int64_t total{0};
+        for (std::size_t i{0}; i < a.size(); ++i)
+            total += static_cast<std::int64_t>(a[i]) * b[i];
+        return total;
+    }
+
+    // out[i] = a[i] + b[i] (wraps around on overflow, like the hardware does), out may be a or b
+    INT_ARRAY_DISPATCH inline void add(std::span<const int> a, std::span<const int> b, std::span<int> out)
+    {
+        assert(a.size() == b.size() && out.size() == a.size());
+        for (std::size_t i{0}; i < a.size(); ++i)
+            out[i] = static_cast<int>(static_cast<unsigned>(a[i]) + static_cast<unsigned>(b[i]));
+    }
+    // out[i] = a[i] * b[i] (wraps around on overflow), out may be a or b
+    INT_ARRAY_DISPATCH inline void multiply(std::span<const int> a, std::span<const int> b, std::span<int> out)
+    {
+        assert(a.size() == b.size() && out.size() == a.size());
+        for (std::size_t i{0}; i < a.size(); ++i)
+            out[i] = static_cast<int>(static_cast<unsigned>(a[i]) * static_cast<unsigned>(b[i]));
+    }
+
+    INT_ARRAY_DISPATCH inline std::size_t count(std::span<const int> values, int target)
+    {
+        std::size_t result{0};
+        for (int value : values)
+            result += (value == target);
+        return result;
+    }
+
+    // index of the first element equal to target, -1 if there is none
+    // an early exit stops the vectorizer, so the search goes by blocks: a vectorized "is it in this block?" test, then a scalar scan
+    // of the only block that has it
+    INT_ARRAY_DISPATCH inline int find(std::span<const int> values, int target)
+    {
+        constexpr std::size_t block{64};
+        std::size_t begin{0};
+        for (; begin + block <= values.size(); begin += block)
+        {
+            int found{0};
+            for (std::size_t i{begin}; i < begin + block; ++i)
+                found |= (values[i] == target);
+            if (found)
+                break;
+        }
+        for (std::size_t i{begin}; i < values.size(); ++i)
+            if (values[i] == target)
+                return static_cast<int>(i);
+        return -1;
+    }
+
+    // out[i] = values[0] + ... + values[i] (wraps around on overflow), out may be values
+    // each element depends on the previous one, which the vectorizer can't handle: with SSE2 the 4 lanes of a register are
+    // scanned with two shift + add steps, then the running total of the previous registers is added to all 4 lanes
+    inline void prefixSum(std::span<const int> values, std::span<int> out)
+    {
+        assert(out.size() == values.size());
+        const int *data{values.data()};
+        int *result{out.data()};
+        const std::size_t size{values.size()};
+        std::size_t i{0};
+        unsigned total{0};
+#if defined(__SSE2__)
+        __m128i carry{_mm_setzero_si128()};
+        for (; i < size / 4 * 4; i += 4)
+        {
+            __m128i x{_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i))};
+            x = _mm_add_epi32(x, _mm_slli_si128(x, 4)); // a, a+b, b+c, c+d
+            x = _mm_add_epi32(x, _mm_slli_si128(x, 8)); // a, a+b, a+b+c, a+b+c+d
+            x = _mm_add_epi32(x, carry);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(result + i), x);
+            carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3)); // the last lane in the 4 lanes
+        }
+        total = static_cast<unsigned>(_mm_cvtsi128_si32(carry));
+#endif
+        for (; i < size; ++i)
+        {
+            total += static_cast<unsigned>(data[i]);
+            result[i] = static_cast<int>(total);
+        }
+    }
+}
+
+#endif
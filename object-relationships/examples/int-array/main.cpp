@@ -0,0 +1,432 @@
+#include "int_array.h"
+#include "int_array_ops.h"
+#include "cow_int_array.h"
+#include "timer.h"
+#include <iostream>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory_resource>
+#include <functional>
+#include <cstdint>
+#include <utility>
+
+/*
+    * A growable container class
+    * Length vs capacity
+    * Amortized constant time push_back
+    * Move semantics for container classes
+    * Allocator-aware containers: std::pmr memory resources
+    * Bulk operations: vectorization and runtime dispatch
+    * Copy-on-write
+*/
+
+/*
+The IntArray of object-relationships/main.cpp allocates exactly the number of elements it holds. Appending one element with resize(size() + 1) means
+allocating a new buffer, copying every element and freeing the old buffer: appending n elements one at a time copies 1 + 2 + ... + n = O(n^2) elements.
+
+std::vector avoids that by separating two numbers:
+    the length (size) is the number of elements in use
+    the capacity is the number of elements the buffer can hold
+push_back() only reallocates when length == capacity, and then it multiplies the capacity (here by 2) instead of adding 1. Each element is copied
+at most a few times over the life of the array, so n push_back() calls cost O(n): we say push_back() is amortized constant time.
+reserve() allocates the capacity up front when the final size is known, shrink_to_fit() gives the unused part back.
+
+resize() zeroes the new elements, which is wasted work when the caller is about to overwrite them: resizeUninitialized() skips it.
+
+A container that owns a heap buffer is expensive to copy but cheap to move: the move constructor and move assignment only steal the pointer.
+The move constructor is marked noexcept, otherwise std::vector<IntArray> would copy (not move) its elements when it reallocates, to keep its strong
+exception guarantee.
+
+Memory resources:
+IntArray doesn't call new[]/delete[] itself, it asks its std::pmr::polymorphic_allocator, which forwards to a std::pmr::memory_resource:
+    std::pmr::new_delete_resource()        the default: the general purpose heap (malloc), same behavior as before
+    std::pmr::monotonic_buffer_resource    an arena: allocating bumps a pointer into a buffer, deallocate() does nothing and release() frees
+                                           everything at once. Perfect for short lived objects created while handling one request
+    std::pmr::unsynchronized_pool_resource pools of fixed size blocks, one pool per size class: freed blocks are reused by the next allocation
+                                           of the same size, without going back to malloc (the synchronized_ version is thread safe)
+The resource is a runtime pointer, not a template parameter: arrays using different resources still have the same type.
+The resource belongs to the object: a copy uses the default resource (unless told otherwise) and a move assignment between arrays from two
+different resources copies the elements (the buffer must go back to the resource it came from).
+*/
+
+/*
+Bulk operations (int_array_ops.h):
+A SIMD (single instruction, multiple data) instruction works on a whole vector register at once: 4 ints with SSE2, 8 with AVX2, 16 with AVX-512.
+Compilers turn simple loops into such instructions (auto-vectorization) if each iteration is independent and the loop doesn't exit early.
+An x86-64 binary can only assume SSE2 though. target_clones builds one copy of a function per instruction set and picks one at startup,
+so the same program uses AVX-512 where the cpu has it. IntArray's buffer is 64 byte aligned, so a vector load never spans two cache lines.
+*/
+
+/*
+Copy-on-write (cow_int_array.h):
+Copying an IntArray allocates and copies every element, even when the copy is only read (an IntArray passed by value, a vector of arrays copied
+to take a snapshot). A CowIntArray copy only increments a reference count, the copies share the elements. The first write through an array
+whose elements are shared copies them (the array "detaches"), so the other arrays never see the change.
+The count is an atomic by default (copies may be used by different threads), CowIntArray<Sharing::single_thread> uses a plain int.
+std::string used to be copy-on-write in libstdc++: C++11 forbade it, because operator[] and iterators hand out references that a later copy
+would share. That's why it's an opt-in class with its own rules here.
+*/
+
+template <typename Array>
+std::int64_t firstPlusLast(Array array) // by value on purpose
+{
+    return std::int64_t{std::as_const(array)[0]} + std::as_const(array)[array.size() - 1];
+}
+
+// copies a table of arrays (a snapshot) and changes a single element in the copy
+template <typename Array>
+std::int64_t snapshotAndEdit(const std::vector<Array> &table, int round)
+{
+    std::vector<Array> snapshot{table};
+    Array &row{snapshot[static_cast<std::size_t>(round) % snapshot.size()]};
+    row[0] += round;
+    return row[0];
+}
+
+// wraps a resource and counts what goes through it: shows how many calls actually reach the upstream (general purpose) allocator
+class CountingResource : public std::pmr::memory_resource
+{
+private:
+    std::pmr::memory_resource *m_upstream{};
+
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++allocations;
+        return m_upstream->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override
+    {
+        m_upstream->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+public:
+    long allocations{};
+
+    CountingResource(std::pmr::memory_resource *upstream = std::pmr::new_delete_resource()) : m_upstream{upstream} {}
+};
+
+// what one request does: builds a few short lived arrays, keeps a number out of them and throws them away
+long handleRequest(int request, std::pmr::memory_resource *resource)
+{
+    long result{};
+    for (int i{0}; i < 8; ++i)
+    {
+        IntArray values{resource};
+        int length{(request * 7 + i * 13) % 64 + 1};
+        for (int j{0}; j < length; ++j)
+            values.push_back(j ^ request);
+        IntArray copy{values, resource};
+        result += copy[length / 2] + values.size();
+    }
+    return result;
+}
+
+// what appending looked like with the original class: an exact size buffer for every new element
+void appendExact(int *&data, int &length, int value)
+{
+    int *new_data{new int[static_cast<std::size_t>(length) + 1]};
+    std::copy_n(data, length, new_data);
+    delete[] data;
+    data = new_data;
+    data[length++] = value;
+}
+
+int main()
+{
+    IntArray array{5, 4, 3, 2, 1}; // initializer list
+    array.push_back(0);
+    array.emplace_back(-1);
+    for (int value : array)
+        std::cout << value << ' ';
+    std::cout << "(size " << array.size() << ", capacity " << array.capacity() << ")\n";
+
+    array = {1, 3, 5, 7, 9, 11};
+    array.resize(8); // the two new elements are 0
+    assert(array[6] == 0 && array[7] == 0);
+    array.shrink_to_fit();
+    assert(array.capacity() == 8);
+
+    /* Move semantics */
+    IntArray moved{std::move(array)}; // no allocation, no copy
+    assert(array.size() == 0 && moved.size() == 8);
+    std::vector<IntArray> arrays{};
+    for (int i{0}; i < 100; ++i)
+        arrays.push_back(IntArray(1000)); // the vector moves its IntArrays when it grows
+    IntArray copy{moved};
+    copy[0] = 100;
+    assert(moved[0] == 1); // copies are still deep
+
+    /* Benchmark: appending one element at a time */
+    constexpr int count{10'000'000};
+
+    Timer timer{};
+    IntArray grown{};
+    for (int i{0}; i < count; ++i)
+        grown.push_back(i);
+    double grown_time{timer.elapsed()};
+
+    timer.reset();
+    IntArray reserved{};
+    reserved.reserve(count);
+    for (int i{0}; i < count; ++i)
+        reserved.push_back(i);
+    double reserved_time{timer.elapsed()};
+
+    timer.reset();
+    IntArray uninitialized{};
+    uninitialized.resizeUninitialized(count);
+    std::iota(uninitialized.begin(), uninitialized.end(), 0);
+    double uninitialized_time{timer.elapsed()};
+
+    timer.reset();
+    std::vector<int> vector{};
+    for (int i{0}; i < count; ++i)
+        vector.push_back(i);
+    double vector_time{timer.elapsed()};
+
+    // the original strategy is quadratic: only try a small fraction of the elements
+    constexpr int exact_count{50'000};
+    timer.reset();
+    int *exact{};
+    int exact_length{};
+    for (int i{0}; i < exact_count; ++i)
+        appendExact(exact, exact_length, i);
+    double exact_time{timer.elapsed()};
+    delete[] exact;
+
+    assert(grown.size() == count && std::equal(grown.begin(), grown.end(), vector.begin()));
+    assert(std::equal(reserved.begin(), reserved.end(), uninitialized.begin()));
+
+    std::cout << "appending " << count << " ints:\n";
+    std::cout << "IntArray::push_back           " << grown_time << " s\n";
+    std::cout << "IntArray reserve + push_back  " << reserved_time << " s\n";
+    std::cout << "IntArray resizeUninitialized  " << uninitialized_time << " s\n";
+    std::cout << "std::vector<int>::push_back   " << vector_time << " s\n";
+    std::cout << "exact size growth: " << exact_time << " s for only " << exact_count << " ints\n";
+
+    /* Memory resources */
+    {
+        // an arena on the stack: no heap allocation at all as long as the buffer is big enough
+        std::byte buffer[1024];
+        std::pmr::monotonic_buffer_resource arena{buffer, sizeof(buffer), std::pmr::null_memory_resource()};
+        IntArray small{{1, 2, 3}, &arena};
+        small.push_back(4);
+        assert(small.get_allocator().resource() == &arena);
+        IntArray copy{small}; // a copy goes to the default resource: it may outlive the arena
+        assert(copy.get_allocator().resource() == std::pmr::get_default_resource());
+
+        // std::pmr containers pass their resource to the IntArrays they hold (thanks to IntArray::allocator_type)
+        std::pmr::vector<IntArray> arrays{&arena};
+        arrays.reserve(2);
+        arrays.emplace_back(3);
+        arrays.emplace_back(IntArray{5, 6});
+        assert(arrays[0].get_allocator().resource() == &arena && arrays[1][1] == 6);
+    }
+
+    /* Benchmark: short lived arrays, one batch per request */
+    constexpr int requests{500'000};
+    long results[3]{};
+    long heap_calls[3]{};
+    double times[3]{};
+
+    // 1. the general purpose heap for every array
+    {
+        CountingResource heap{};
+        timer.reset();
+        for (int request{0}; request < requests; ++request)
+            results[0] += handleRequest(request, &heap);
+        times[0] = timer.elapsed();
+        heap_calls[0] = heap.allocations;
+    }
+    // 2. an arena per request: one release() frees all the arrays of the request at once
+    {
+        CountingResource heap{};
+        static std::byte request_buffer[64 * 1024]; // release() rewinds to this buffer, the heap is only used if a request overflows it
+        std::pmr::monotonic_buffer_resource arena{request_buffer, sizeof(request_buffer), &heap};
+        timer.reset();
+        for (int request{0}; request < requests; ++request)
+        {
+            results[1] += handleRequest(request, &arena);
+            arena.release(); // frees every array of the request at once
+        }
+        times[1] = timer.elapsed();
+        heap_calls[1] = heap.allocations;
+    }
+    // 3. a pool: freed blocks are recycled by the next requests
+    {
+        CountingResource heap{};
+        std::pmr::unsynchronized_pool_resource pool{&heap};
+        timer.reset();
+        for (int request{0}; request < requests; ++request)
+            results[2] += handleRequest(request, &pool);
+        times[2] = timer.elapsed();
+        heap_calls[2] = heap.allocations;
+    }
+
+    assert(results[0] == results[1] && results[0] == results[2]);
+    std::cout << requests << " requests, 16 short lived arrays each:\n";
+    std::cout << "new/delete                   " << times[0] << " s, " << heap_calls[0] << " heap allocations\n";
+    std::cout << "monotonic_buffer_resource    " << times[1] << " s, " << heap_calls[1] << " heap allocations\n";
+    std::cout << "unsynchronized_pool_resource " << times[2] << " s, " << heap_calls[2] << " heap allocations\n";
+
+    /* Bulk operations */
+    IntArray a{3, -1, 4, 1, -5, 9, 2, 6};
+    IntArray b{1, 1, 2, 3, 5, 8, 13, 21};
+    assert(IntArrayOps::sum(a) == 19 && IntArrayOps::dot(a, b) == 212);
+    assert(IntArrayOps::minMax(a).min == -5 && IntArrayOps::minMax(a).max == 9);
+    assert(IntArrayOps::find(b, 5) == 4 && IntArrayOps::find(b, 4) == -1 && IntArrayOps::count(b, 1) == 2);
+    IntArrayOps::prefixSum(b, b);
+    assert(b[7] == 54);
+    assert(reinterpret_cast<std::uintptr_t>(a.data()) % IntArray::data_alignment == 0);
+
+    /* Benchmark: bulk operations against the standard algorithms, 64k ints (they stay in the L2 cache) 3200 times */
+    // build with optimizations (g++ -std=c++20 -O3 main.cpp): at -O2 older GCCs only vectorize the cheapest loops
+    constexpr int bulk_count{1 << 16};
+    constexpr int rounds{3200};
+    IntArray x{};
+    IntArray y{};
+    IntArray out{};
+    x.resizeUninitialized(bulk_count);
+    y.resizeUninitialized(bulk_count);
+    out.resizeUninitialized(bulk_count);
+    for (int i{0}; i < bulk_count; ++i)
+    {
+        x[i] = static_cast<int>(i * 7919LL % 1000) - 500;
+        y[i] = static_cast<int>(i * 104729LL % 777) - 300;
+    }
+    // the value searched is near the end: find() has to look at almost everything
+    x[bulk_count - 10] = 12345;
+
+    std::int64_t check{};
+    auto bench{[&](const char *name, auto &&with_std, auto &&with_ops)
+               {
+                   Timer bench_timer{};
+                   std::int64_t std_result{};
+                   for (int round{0}; round < rounds; ++round)
+                       std_result += with_std();
+                   double std_time{bench_timer.elapsed()};
+                   bench_timer.reset();
+                   std::int64_t ops_result{};
+                   for (int round{0}; round < rounds; ++round)
+                       ops_result += with_ops();
+                   double ops_time{bench_timer.elapsed()};
+                   assert(std_result == ops_result);
+                   check += ops_result;
+                   std::cout << name << "std " << std_time << " s, IntArrayOps " << ops_time << " s (x" << std_time / ops_time << ")\n";
+               }};
+
+    std::cout << "bulk operations (" << rounds << " x " << bulk_count << " ints):\n";
+    bench("sum         ", [&]
+          { return std::accumulate(x.begin(), x.end(), std::int64_t{0}); },
+          [&]
+          { return IntArrayOps::sum(x); });
+    bench("min/max     ", [&]
+          { auto [min, max]{std::minmax_element(x.begin(), x.end())}; return std::int64_t{*min} + *max; },
+          [&]
+          { auto [min, max]{IntArrayOps::minMax(x)}; return std::int64_t{min} + max; });
+    bench("dot         ", [&]
+          { return std::inner_product(x.begin(), x.end(), y.begin(), std::int64_t{0}); },
+          [&]
+          { return IntArrayOps::dot(x, y); });
+    bench("add         ", [&]
+          { std::transform(x.begin(), x.end(), y.begin(), out.begin(), std::plus<>{}); return std::int64_t{out[bulk_count / 2]}; },
+          [&]
+          { IntArrayOps::add(x, y, out); return std::int64_t{out[bulk_count / 2]}; });
+    bench("multiply    ", [&]
+          { std::transform(x.begin(), x.end(), y.begin(), out.begin(), std::multiplies<>{}); return std::int64_t{out[bulk_count / 2]}; },
+          [&]
+          { IntArrayOps::multiply(x, y, out); return std::int64_t{out[bulk_count / 2]}; });
+    bench("count       ", [&]
+          { return static_cast<std::int64_t>(std::count(x.begin(), x.end(), 7)); },
+          [&]
+          { return static_cast<std::int64_t>(IntArrayOps::count(x, 7)); });
+    bench("find        ", [&]
+          { return static_cast<std::int64_t>(std::find(x.begin(), x.end(), 12345) - x.begin()); },
+          [&]
+          { return static_cast<std::int64_t>(IntArrayOps::find(x, 12345)); });
+    bench("prefix sum  ", [&]
+          { std::partial_sum(y.begin(), y.end(), out.begin()); return std::int64_t{out[bulk_count - 1]}; },
+          [&]
+          { IntArrayOps::prefixSum(y, out); return std::int64_t{out[bulk_count - 1]}; });
+    std::cout << "(checksum " << check << ")\n";
+
+    /* Copy-on-write */
+    CowIntArray<> original{1, 2, 3};
+    CowIntArray<> shared{original};
+    assert(shared.useCount() == 2 && shared.data() == original.data()); // no copy yet
+    shared[0] = 10;                                                      // the first write detaches
+    assert(original[0] == 1 && shared[0] == 10 && original.useCount() == 1);
+    shared.push_back(4);
+    assert(shared.size() == 4 && original.size() == 3);
+
+    /* Benchmark: pass-by-value and container of arrays */
+    {
+        constexpr int cow_length{16 * 1024};
+        constexpr int calls{20'000};
+        IntArray plain(cow_length);
+        CowIntArray<Sharing::atomic> cow(cow_length);
+        CowIntArray<Sharing::single_thread> cow_single(cow_length);
+        std::int64_t results[3]{};
+
+        timer.reset();
+        for (int call{0}; call < calls; ++call)
+            results[0] += firstPlusLast(plain);
+        double plain_time{timer.elapsed()};
+        timer.reset();
+        for (int call{0}; call < calls; ++call)
+            results[1] += firstPlusLast(cow);
+        double cow_time{timer.elapsed()};
+        timer.reset();
+        for (int call{0}; call < calls; ++call)
+            results[2] += firstPlusLast(cow_single);
+        double single_time{timer.elapsed()};
+        assert(results[0] == results[1] && results[0] == results[2]);
+
+        std::cout << calls << " calls passing " << cow_length << " ints by value:\n";
+        std::cout << "IntArray                            " << plain_time << " s\n";
+        std::cout << "CowIntArray<Sharing::atomic>        " << cow_time << " s\n";
+        std::cout << "CowIntArray<Sharing::single_thread> " << single_time << " s\n";
+    }
+    {
+        constexpr int rows{1000};
+        constexpr int row_length{1000};
+        constexpr int snapshots{500};
+        std::vector<IntArray> plain_table(rows, IntArray(row_length));
+        std::vector<CowIntArray<Sharing::atomic>> cow_table{};
+        std::vector<CowIntArray<Sharing::single_thread>> single_table{};
+        for (int row{0}; row < rows; ++row)
+        {
+            cow_table.emplace_back(row_length);
+            single_table.emplace_back(row_length);
+        }
+        std::int64_t results[3]{};
+
+        timer.reset();
+        for (int round{0}; round < snapshots; ++round)
+            results[0] += snapshotAndEdit(plain_table, round);
+        double plain_time{timer.elapsed()};
+        timer.reset();
+        for (int round{0}; round < snapshots; ++round)
+            results[1] += snapshotAndEdit(cow_table, round);
+        double cow_time{timer.elapsed()};
+        timer.reset();
+        for (int round{0}; round < snapshots; ++round)
+            results[2] += snapshotAndEdit(single_table, round);
+        double single_time{timer.elapsed()};
+        assert(results[0] == results[1] && results[0] == results[2]);
+
+        std::cout << snapshots << " snapshots of " << rows << " arrays of " << row_length << " ints, one element edited:\n";
+        std::cout << "IntArray                            " << plain_time << " s\n";
+        std::cout << "CowIntArray<Sharing::atomic>        " << cow_time << " s\n";
+        std::cout << "CowIntArray<Sharing::single_thread> " << single_time << " s\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+#ifndef SHARED_BUFFER_H
+#define SHARED_BUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// who may share a buffer: objects used by several threads need an atomic reference count, objects that stay in one thread
+// can use a plain int (an atomic increment is a locked instruction, several times slower than ++)
+enum class Sharing
+{
+    atomic,
+    single_thread,
+};
+
+// A reference counted heap buffer of T, the building block of the copy-on-write containers.
+// One allocation holds the header (count, length, capacity) followed by the elements.
+// Copying a SharedBuffer only increments the count, the elements are copied by mutableData() when the buffer is shared:
+// that's copy-on-write, the copy is paid for by the first write, not by the copy itself (and never if nobody writes).
+template <typename T, Sharing S>
+class SharedBuffer
+{
+    static_assert(std::is_trivially_copyable_v<T>, "the elements are copied with std::copy_n and never destroyed");
+
+private:
+    using Count = std::conditional_t<S == Sharing::atomic, std::atomic<int>, int>;
+
+    struct Header
+    {
+        Count count{1};
+        int length{};
+        int capacity{};
+    };
+    static constexpr std::size_t elements_offset{(sizeof(Header) + alignof(T) - 1) / alignof(T) * alignof(T)};
+
+    Header *m_header{};
+
+    static Header *allocate(int capacity)
+    {
+        void *memory{::operator new(elements_offset + sizeof(T) * static_cast<std::size_t>(capacity))};
+        return new (memory) Header{1, 0, capacity};
+    }
+    static T *elements(Header *header)
+    {
+        return reinterpret_cast<T *>(reinterpret_cast<std::byte *>(header) + elements_offset);
+    }
+
+    void acquire()
+    {
+        if (!m_header)
+            return;
+        if constexpr (S == Sharing::atomic)
+            m_header->count.fetch_add(1, std::memory_order_relaxed); // like std::shared_ptr: nothing to synchronize on a new owner
+        else
+            ++m_header->count;
+    }
+    void release()
+    {
+        if (!m_header)
+            return;
+        bool last{};
+        if constexpr (S == Sharing::atomic)
+            last = m_header->count.fetch_sub(1, std::memory_order_acq_rel) == 1; // the last owner must see all the other owners' writes
+        else
+            last = --m_header->count == 0;
+        if (last)
+        {
+            m_header->~Header();
+            ::operator delete(m_header);
+        }
+        m_header = nullptr;
+    }
+
+public:
+    SharedBuffer() = default;
+    explicit SharedBuffer(int capacity)
+    {
+        assert(capacity >= 0);
+        if (capacity)
+            m_header = allocate(capacity);
+    }
+
+    // copies share the buffer
+    SharedBuffer(const SharedBuffer &buffer) : m_header{buffer.m_header}
+    {
+        acquire();
+    }
+    SharedBuffer &operator=(const SharedBuffer &buffer)
+    {
+        if (m_header != buffer.m_header)
+        {
+            release();
+            m_header = buffer.m_header;
+            acquire();
+        }
+        return *this;
+    }
+    SharedBuffer(SharedBuffer &&buffer) noexcept : m_header{std::exchange(buffer.m_header, nullptr)} {}
+    SharedBuffer &operator=(SharedBuffer &&buffer) noexcept
+    {
+        if (this != &buffer)
+        {
+            release();
+            m_header = std::exchange(buffer.m_header, nullptr);
+        }
+        return *this;
+    }
+    ~SharedBuffer()
+    {
+        release();
+    }
+
+    int length() const { return m_header ? m_header->length : 0; }
+    int capacity() const { return m_header ? m_header->capacity : 0; }
+    int useCount() const
+    {
+        if (!m_header)
+            return 0;
+        if constexpr (S == Sharing::atomic)
+            return m_header->count.load(std::memory_order_acquire);
+        else
+            return m_header->count;
+    }
+    bool shared() const { return useCount() > 1; }
+
+    // read access never copies
+    const T *data() const { return m_header ? elements(m_header) : nullptr; }
+
+    // write access: gets a buffer of its own first (capacity at least min_capacity), keeping the elements
+    T *mutableData(int min_capacity = 0)
+    {
+        if (!shared() && min_capacity <= capacity())
+            return m_header ? elements(m_header) : nullptr;
+        int new_capacity{std::max(min_capacity, capacity())};
+        if (new_capacity == 0)
+            return nullptr;
+        Header *header{allocate(new_capacity)};
+        header->length = length();
+        std::copy_n(data(), length(), elements(header));
+        release();
+        m_header = header;
+        return elements(m_header);
+    }
+    // only on a buffer mutableData() was called on (one owner)
+    void setLength(int length)
+    {
+        assert(!shared() && length >= 0 && length <= capacity());
+        if (m_header)
+            m_header->length = length;
+    }
+};
+
+#endif
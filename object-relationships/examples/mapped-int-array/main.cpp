@@ -0,0 +1,97 @@
+#include "mapped_int_array.h"
+#include "timer.h"
+#include <iostream>
+#include <filesystem>
+#include <string>
+#include <cstdint>
+#include <charconv>
+#include <string_view>
+#include <system_error>
+#include <cassert>
+
+/*
+    * Memory-mapped files
+    * Arrays bigger than the physical memory
+    * Access pattern hints (madvise), huge pages
+*/
+
+/*
+new int[length] (see object-relationships/main.cpp) asks for memory that must exist now: with more elements than RAM the allocation fails, or
+the system starts swapping the whole array in and out.
+mmap() maps a file into the address space instead: the array is the file. Touching an element that isn't in memory yet triggers a page fault,
+the kernel reads that page from the file and the program continues. Pages that weren't modified can be dropped at any time (they are still in
+the file), modified pages are written back first. The program only pays RAM for the pages it is working on.
+
+    sync()         msync(): writes the modified pages now (the kernel does it eventually anyway), to make the data durable
+    advise()       madvise(): sequential read ahead more and drop pages behind, random stops reading ahead (it would only waste IO)
+    useHugePages() 2 MiB pages instead of 4 KiB: fewer TLB misses, when the filesystem supports them for files
+    growing        ftruncate() extends the file, mremap() extends the mapping (and may move it, like a reallocation)
+
+usage: mapped-int-array [number of elements, at least 1] [file]
+*/
+
+int main(int argc, char *argv[])
+{
+    // 64M elements (256 MiB) by default: pass a count bigger than the RAM to see the kernel page the file in and out
+    std::int64_t count{std::int64_t{64} * 1024 * 1024};
+    if (argc > 1)
+    {
+        std::string_view argument{argv[1]};
+        auto [end, error]{std::from_chars(argument.data(), argument.data() + argument.size(), count)};
+        if (error != std::errc{} || end != argument.data() + argument.size() || count < 1)
+        {
+            std::cerr << "mapped-int-array: the number of elements must be a positive integer, not \"" << argument << "\"\n";
+            return 1;
+        }
+    }
+    std::string path{argc > 2 ? argv[2] : (std::filesystem::temp_directory_path() / "mapped-int-array.bin").string()};
+
+    Timer timer{};
+    {
+        MappedIntArray array{path, MappedIntArray::Mode::create};
+        for (std::int64_t i{0}; i < count; ++i)
+            array.push_back(static_cast<int>(i % 1000));
+        std::cout << "push_back " << count << " ints: " << timer.elapsed() << " s (capacity " << array.capacity() << ")\n";
+
+        timer.reset();
+        array.sync();
+        std::cout << "sync: " << timer.elapsed() << " s\n";
+    } // the destructor trims the file to the used size
+
+    assert(std::filesystem::file_size(path) == 64 + sizeof(int) * static_cast<std::size_t>(count));
+
+    {
+        // the elements are still there after reopening the file
+        MappedIntArray array{path, MappedIntArray::Mode::open};
+        assert(array.size() == count);
+        std::cout << "huge pages " << (array.useHugePages() ? "accepted" : "not supported for this file") << '\n';
+
+        timer.reset();
+        array.advise(MappedIntArray::Access::sequential);
+        std::int64_t sum{0};
+        for (int value : array)
+            sum += value;
+        std::cout << "sequential sum: " << timer.elapsed() << " s (" << sum << ")\n";
+
+        timer.reset();
+        array.advise(MappedIntArray::Access::random);
+        std::int64_t random_sum{0};
+        std::uint64_t state{12345};
+        constexpr int reads{10'000'000};
+        for (int i{0}; i < reads; ++i)
+        {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL; // a small LCG: cheaper than <random> in the timed loop
+            random_sum += array[static_cast<std::int64_t>((state >> 33) % static_cast<std::uint64_t>(count))];
+        }
+        std::cout << reads << " random reads: " << timer.elapsed() << " s (" << random_sum << ")\n";
+
+        // grow an existing file: the new elements are zero
+        array.resize(count + 10);
+        assert(array[count + 9] == 0 && array[count - 1] == static_cast<int>((count - 1) % 1000));
+        array.resize(count);
+    }
+
+    std::filesystem::remove(path);
+
+    return 0;
+}
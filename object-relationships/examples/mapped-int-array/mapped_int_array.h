@@ -0,0 +1,277 @@
+#ifndef MAPPED_INT_ARRAY_H
+#define MAPPED_INT_ARRAY_H
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <sys/mman.h> // POSIX only: mmap()/msync()/madvise()
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// An IntArray whose elements live in a file mapped into memory instead of on the heap.
+//
+// new int[length] needs the whole array in RAM (or in swap) before the first element is used. A mapping only reserves addresses:
+// the kernel reads a page (4 KiB) of the file the first time it is touched and can drop clean pages again when memory runs low,
+// so the array can be bigger than the physical memory and only the part that is used costs RAM. It also persists: reopening
+// the file gives the elements back.
+//
+// The file starts with a small header (a tag and the length), the elements follow it. The file (and the mapping) grows
+// geometrically like IntArray's buffer does, the destructor truncates it back to the used size.
+// As with IntArray, growing may move the mapping: pointers and references into the array are invalidated.
+class MappedIntArray
+{
+public:
+    enum class Mode
+    {
+        open,   // the file must exist and be a MappedIntArray file
+        create, // the file is created, or truncated to an empty array if it exists
+    };
+    // hints about how the elements are going to be read (madvise)
+    enum class Access
+    {
+        normal,
+        sequential, // read ahead aggressively, drop pages soon after they were read
+        random,     // don't read ahead: every fault only brings the page that is needed
+        will_need,  // start reading the whole file now, in the background
+    };
+
+private:
+    struct Header
+    {
+        char tag[8];
+        std::int64_t length;
+    };
+    static constexpr char file_tag[8]{'I', 'N', 'T', 'A', 'R', 'R', '1', '\0'};
+    // the elements start on a cache line (and a 64 byte vector load never straddles two)
+    static constexpr std::size_t data_offset{64};
+    static_assert(sizeof(Header) <= data_offset);
+
+    std::string m_path{};
+    int m_fd{-1};
+    std::byte *m_map{};
+    std::size_t m_map_size{};
+    std::int64_t m_length{};
+    std::int64_t m_capacity{};
+
+    [[noreturn]] void fail(const char *what) const
+    {
+        throw std::runtime_error{std::string{"MappedIntArray: "} + what + " " + m_path + ": " + std::strerror(errno)};
+    }
+
+    Header *header() const { return reinterpret_cast<Header *>(m_map); }
+    int *elements() const { return reinterpret_cast<int *>(m_map + data_offset); }
+
+    static std::size_t fileSize(std::int64_t capacity)
+    {
+        return data_offset + sizeof(int) * static_cast<std::size_t>(capacity);
+    }
+
+    // grows (or shrinks) the file, then makes the mapping cover it
+    void remap(std::int64_t new_capacity)
+    {
+        std::size_t new_size{fileSize(new_capacity)};
+        if (::ftruncate(m_fd, static_cast<off_t>(new_size)) < 0)
+            fail("can't resize");
+#if defined(__linux__)
+        // Linux can grow a mapping in place, or move it without unmapping the pages that are already loaded
+        void *addr{::mremap(m_map, m_map_size, new_size, MREMAP_MAYMOVE)};
+#else
+        // the new mapping before the old one is unmapped: if it fails, the array is still there
+        void *addr{::mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0)};
+#endif
+        if (addr == MAP_FAILED)
+        {
+            // the old mapping is untouched (mremap() leaves it too): give the file its old size back, and the array is as it was
+            int error{errno};
+            [[maybe_unused]] int result{::ftruncate(m_fd, static_cast<off_t>(m_map_size))};
+            errno = error;
+            fail("can't map");
+        }
+#if !defined(__linux__)
+        ::munmap(m_map, m_map_size);
+#endif
+        m_map = static_cast<std::byte *>(addr);
+        m_map_size = new_size;
+        m_capacity = new_capacity;
+    }
+
+    void grow(std::int64_t min_capacity)
+    {
+        // at least 1 MiB of elements: every remap is a system call, no need to make many small ones
+        remap(std::max({min_capacity, 2 * m_capacity, std::int64_t{256 * 1024}}));
+    }
+
+public:
+    MappedIntArray(const std::string &path, Mode mode) : m_path{path}
+    {
+        m_fd = ::open(path.c_str(), mode == Mode::create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+        if (m_fd < 0)
+            fail("can't open");
+
+        struct stat info{};
+        if (::fstat(m_fd, &info) < 0)
+        {
+            ::close(m_fd);
+            fail("can't stat");
+        }
+        std::size_t size{static_cast<std::size_t>(info.st_size)};
+        if (mode == Mode::create)
+        {
+            size = data_offset;
+            if (::ftruncate(m_fd, static_cast<off_t>(size)) < 0)
+            {
+                ::close(m_fd);
+                fail("can't resize");
+            }
+        }
+        else if (size < data_offset)
+        {
+            ::close(m_fd);
+            throw std::runtime_error{"MappedIntArray: " + path + " is not a MappedIntArray file"};
+        }
+
+        void *addr{::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0)};
+        if (addr == MAP_FAILED)
+        {
+            ::close(m_fd);
+            fail("can't map");
+        }
+        m_map = static_cast<std::byte *>(addr);
+        m_map_size = size;
+        m_capacity = static_cast<std::int64_t>((size - data_offset) / sizeof(int));
+
+        if (mode == Mode::create)
+        {
+            std::memcpy(header()->tag, file_tag, sizeof(file_tag));
+            header()->length = 0;
+        }
+        else if (std::memcmp(header()->tag, file_tag, sizeof(file_tag)) != 0 || header()->length < 0 || header()->length > m_capacity)
+        {
+            ::munmap(m_map, m_map_size);
+            ::close(m_fd);
+            throw std::runtime_error{"MappedIntArray: " + path + " is not a MappedIntArray file"};
+        }
+        m_length = header()->length;
+    }
+
+    // one mapping, one owner
+    MappedIntArray(const MappedIntArray &) = delete;
+    MappedIntArray &operator=(const MappedIntArray &) = delete;
+    MappedIntArray(MappedIntArray &&array) noexcept
+        : m_path{std::move(array.m_path)},
+          m_fd{std::exchange(array.m_fd, -1)},
+          m_map{std::exchange(array.m_map, nullptr)},
+          m_map_size{std::exchange(array.m_map_size, 0)},
+          m_length{std::exchange(array.m_length, 0)},
+          m_capacity{std::exchange(array.m_capacity, 0)}
+    {
+    }
+
+    // the unused capacity is cut off the file, the kernel writes the dirty pages back on its own schedule (call sync() to wait for it)
+    ~MappedIntArray()
+    {
+        if (!m_map)
+            return;
+        header()->length = m_length;
+        ::munmap(m_map, m_map_size);
+        [[maybe_unused]] int result{::ftruncate(m_fd, static_cast<off_t>(fileSize(m_length)))};
+        ::close(m_fd);
+    }
+
+    std::int64_t size() const { return m_length; }
+    std::int64_t capacity() const { return m_capacity; }
+    bool empty() const { return m_length == 0; }
+
+    int &operator[](std::int64_t index)
+    {
+        assert(index >= 0 && index < m_length);
+        return elements()[index];
+    }
+    const int &operator[](std::int64_t index) const
+    {
+        assert(index >= 0 && index < m_length);
+        return elements()[index];
+    }
+
+    int *data() { return elements(); }
+    const int *data() const { return elements(); }
+    int *begin() { return elements(); }
+    int *end() { return elements() + m_length; }
+    const int *begin() const { return elements(); }
+    const int *end() const { return elements() + m_length; }
+
+    void reserve(std::int64_t new_capacity)
+    {
+        if (new_capacity > m_capacity)
+            remap(new_capacity);
+    }
+    void push_back(int value)
+    {
+        if (m_length == m_capacity)
+            grow(m_length + 1);
+        elements()[m_length++] = value;
+    }
+    // new elements are zero: the file grows with holes, which read as zeros and take no disk space until they are written
+    void resize(std::int64_t new_length)
+    {
+        assert(new_length >= 0);
+        std::int64_t old_capacity{m_capacity};
+        if (new_length > m_capacity)
+            grow(new_length);
+        // the part past the old capacity is new file space (zeros), only the old unused capacity may hold stale values
+        if (new_length > m_length)
+            std::fill(elements() + m_length, elements() + std::min(new_length, old_capacity), 0);
+        m_length = new_length;
+    }
+
+    // writes the length and the modified pages to the file: with wait, returns once they are on the disk (the data survives a crash)
+    void sync(bool wait = true)
+    {
+        header()->length = m_length;
+        if (::msync(m_map, m_map_size, wait ? MS_SYNC : MS_ASYNC) < 0)
+            fail("can't sync");
+    }
+
+    // a hint only: the kernel may ignore it, the results are the same either way
+    void advise(Access access)
+    {
+        int advice{MADV_NORMAL};
+        switch (access)
+        {
+        case Access::normal:
+            advice = MADV_NORMAL;
+            break;
+        case Access::sequential:
+            advice = MADV_SEQUENTIAL;
+            break;
+        case Access::random:
+            advice = MADV_RANDOM;
+            break;
+        case Access::will_need:
+            advice = MADV_WILLNEED;
+            break;
+        }
+        ::madvise(m_map, m_map_size, advice);
+    }
+
+    // asks for 2 MiB pages (transparent huge pages): one TLB entry covers 512 times more memory, which helps random access over
+    // big arrays. For a file mapping the kernel only does it on some filesystems (tmpfs mounted with huge=, or read-only THP
+    // for files): returns false when the hint was refused. Call it again after the array grew (the mapping may have moved).
+    bool useHugePages()
+    {
+#if defined(MADV_HUGEPAGE)
+        return ::madvise(m_map, m_map_size, MADV_HUGEPAGE) == 0;
+#else
+        return false;
+#endif
+    }
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <chrono>
+
+// A small stopwatch built on std::chrono::steady_clock
+// Used to time sections of code, courtesy of learncpp.com
+class Timer
+{
+private:
+    // Type aliases to make accessing nested type easier
+    using Clock = std::chrono::steady_clock;
+    using Second = std::chrono::duration<double, std::ratio<1>>;
+
+    std::chrono::time_point<Clock> m_beg{Clock::now()};
+
+public:
+    void reset()
+    {
+        m_beg = Clock::now();
+    }
+
+    // Returns the time since construction (or the last reset) in seconds
+    double elapsed() const
+    {
+        return std::chrono::duration_cast<Second>(Clock::now() - m_beg).count();
+    }
+};
+
+#endif
@@ -0,0 +1,130 @@
+#include "segmented_array.h"
+#include "timer.h"
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <string>
+#include <numeric>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+
+/*
+    * A segmented (chunked) array
+    * Stable references: growing without moving the elements
+    * Power of two chunks: indexing with a shift and a mask
+*/
+
+/*
+A contiguous array (IntArray, std::vector) that runs out of capacity allocates a bigger buffer and moves every element into it: every pointer,
+reference and iterator to the elements is invalidated (see the iterator invalidation notes of STL-algorithms/main.cpp), and the move costs O(n).
+Amortized it's cheap, but one push_back out of many copies the whole array, and code that keeps pointers into the array can't use it.
+
+SegmentedArray keeps its elements in chunks of a fixed size that are never reallocated, and a small directory of chunk pointers:
+    growing allocates one more chunk (only the directory of pointers is reallocated, now and then)
+    element i is at chunks[i >> shift][i & mask]: the chunk size is a power of two, so no division is needed
+std::deque is built the same way, but its chunk size is fixed by the library (512 bytes in libstdc++: only 128 ints per chunk).
+
+The price is a second memory access per element (the directory) and a non-contiguous layout: loops that need speed go chunk by chunk
+(forEachChunk()), each chunk is a plain array.
+*/
+
+struct Row
+{
+    int id{};
+    std::string name{};
+};
+
+int main()
+{
+    /* Stable references */
+    SegmentedArray<Row, 4> rows{}; // chunks of 16 rows, to grow often
+    Row &first{rows.emplace_back(1, "first")};
+    const Row *pointer{&first};
+    for (int i{2}; i <= 1000; ++i)
+        rows.push_back({i, "row " + std::to_string(i)});
+    assert(&rows[0] == pointer && first.name == "first"); // still valid after 62 chunks were added
+    assert(rows.size() == 1000 && rows.back().id == 1000 && rows.chunkCount() == 63);
+
+    SegmentedArray<int> numbers{1, 2, 3};
+    std::iota(numbers.begin(), numbers.end(), 10); // random access iterators: the standard algorithms work
+    assert(numbers[2] == 12 && std::find(numbers.begin(), numbers.end(), 11) - numbers.begin() == 1);
+
+    /* Benchmark: appending */
+    constexpr int count{20'000'000};
+    Timer timer{};
+    SegmentedArray<int> segmented{};
+    for (int i{0}; i < count; ++i)
+        segmented.push_back(i);
+    double segmented_time{timer.elapsed()};
+
+    timer.reset();
+    std::vector<int> vector{};
+    for (int i{0}; i < count; ++i)
+        vector.push_back(i);
+    double vector_time{timer.elapsed()};
+
+    timer.reset();
+    std::deque<int> deque{};
+    for (int i{0}; i < count; ++i)
+        deque.push_back(i);
+    double deque_time{timer.elapsed()};
+
+    // the worst single push_back: for the vector it's the one that moves all the elements
+    auto slowestAppend{[](auto &container)
+                       {
+                           double slowest{0};
+                           for (int i{0}; i < count; ++i)
+                           {
+                               Timer append_timer{};
+                               container.push_back(i);
+                               slowest = std::max(slowest, append_timer.elapsed());
+                           }
+                           return slowest;
+                       }};
+    SegmentedArray<int> segmented_latency{};
+    std::vector<int> vector_latency{};
+    double segmented_slowest{slowestAppend(segmented_latency)};
+    double vector_slowest{slowestAppend(vector_latency)};
+
+    std::cout << "appending " << count << " ints:\n";
+    std::cout << "SegmentedArray<int> " << segmented_time << " s (slowest push_back " << segmented_slowest * 1e6 << " us)\n";
+    std::cout << "std::vector<int>    " << vector_time << " s (slowest push_back " << vector_slowest * 1e6 << " us)\n";
+    std::cout << "std::deque<int>     " << deque_time << " s\n";
+
+    /* Benchmark: reading */
+    timer.reset();
+    std::int64_t indexed_sum{0};
+    for (std::size_t i{0}; i < segmented.size(); ++i)
+        indexed_sum += segmented[i];
+    double indexed_time{timer.elapsed()};
+
+    timer.reset();
+    std::int64_t chunk_sum{0};
+    segmented.forEachChunk([&](const int *chunk, std::size_t length)
+                           {
+                               for (std::size_t i{0}; i < length; ++i)
+                                   chunk_sum += chunk[i]; });
+    double chunk_time{timer.elapsed()};
+
+    timer.reset();
+    std::int64_t vector_sum{0};
+    for (std::size_t i{0}; i < vector.size(); ++i)
+        vector_sum += vector[i];
+    double vector_sum_time{timer.elapsed()};
+
+    timer.reset();
+    std::int64_t deque_sum{0};
+    for (std::size_t i{0}; i < deque.size(); ++i)
+        deque_sum += deque[i];
+    double deque_sum_time{timer.elapsed()};
+
+    assert(indexed_sum == vector_sum && chunk_sum == vector_sum && deque_sum == vector_sum);
+    std::cout << "sum of " << count << " ints:\n";
+    std::cout << "SegmentedArray operator[]     " << indexed_time << " s\n";
+    std::cout << "SegmentedArray forEachChunk() " << chunk_time << " s\n";
+    std::cout << "std::vector operator[]        " << vector_sum_time << " s\n";
+    std::cout << "std::deque operator[]         " << deque_sum_time << " s\n";
+
+    return 0;
+}
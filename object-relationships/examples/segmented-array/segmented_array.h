@@ -0,0 +1,255 @@
+#ifndef SEGMENTED_ARRAY_H
+#define SEGMENTED_ARRAY_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// A dynamic array made of fixed size chunks of 2^ChunkShift elements, and a directory of pointers to the chunks.
+//
+// Growing adds a chunk: the elements never move, so pointers and references to them stay valid until the element is removed
+// (IntArray::resize and std::vector::push_back move everything to a new buffer, and invalidate them all).
+// Element i is in chunk i >> ChunkShift at position i & (chunk size - 1): a shift, a mask and two loads, whatever the size.
+// Only the directory is reallocated when it's full, and it only holds one pointer per chunk (a 4096 element chunk of ints
+// is 16 KiB, its directory entry is 8 bytes).
+// Chunks are not freed when the array shrinks (clear(), pop_back()), the next elements reuse them.
+template <typename T, int ChunkShift = 12>
+class SegmentedArray
+{
+    static_assert(ChunkShift > 0 && ChunkShift < 31);
+
+public:
+    static constexpr std::size_t chunk_size{std::size_t{1} << ChunkShift};
+    static constexpr std::size_t chunk_mask{chunk_size - 1};
+
+private:
+    std::vector<T *> m_chunks{}; // the directory
+    std::size_t m_size{};
+
+    static T *allocateChunk()
+    {
+        return static_cast<T *>(::operator new(sizeof(T) * chunk_size, std::align_val_t{alignof(T)}));
+    }
+    static void freeChunk(T *chunk)
+    {
+        ::operator delete(chunk, std::align_val_t{alignof(T)});
+    }
+
+    struct ChunkDeleter
+    {
+        void operator()(T *chunk) const { freeChunk(chunk); }
+    };
+    // a new chunk at the end of the directory: if the directory can't grow, the chunk is freed instead of leaked
+    void addChunk()
+    {
+        std::unique_ptr<T, ChunkDeleter> chunk{allocateChunk()};
+        m_chunks.push_back(chunk.get());
+        chunk.release();
+    }
+
+    T *slot(std::size_t index) const
+    {
+        return m_chunks[index >> ChunkShift] + (index & chunk_mask);
+    }
+
+    // where the next element goes, adding a chunk when the last one is full
+    T *nextSlot()
+    {
+        if (m_size == m_chunks.size() * chunk_size)
+            addChunk();
+        return slot(m_size);
+    }
+
+public:
+    template <bool Const>
+    class Iterator
+    {
+    private:
+        using Array = std::conditional_t<Const, const SegmentedArray, SegmentedArray>;
+        Array *m_array{};
+        std::size_t m_index{};
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T *, T *>;
+        using reference = std::conditional_t<Const, const T &, T &>;
+
+        Iterator() = default;
+        Iterator(Array *array, std::size_t index) : m_array{array}, m_index{index} {}
+        // an iterator converts to a const_iterator
+        operator Iterator<true>() const { return {m_array, m_index}; }
+
+        reference operator*() const { return (*m_array)[m_index]; }
+        pointer operator->() const { return &(*m_array)[m_index]; }
+        reference operator[](difference_type n) const { return (*m_array)[m_index + static_cast<std::size_t>(n)]; }
+
+        Iterator &operator++()
+        {
+            ++m_index;
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            Iterator old{*this};
+            ++m_index;
+            return old;
+        }
+        Iterator &operator--()
+        {
+            --m_index;
+            return *this;
+        }
+        Iterator operator--(int)
+        {
+            Iterator old{*this};
+            --m_index;
+            return old;
+        }
+        Iterator &operator+=(difference_type n)
+        {
+            m_index += static_cast<std::size_t>(n);
+            return *this;
+        }
+        Iterator &operator-=(difference_type n)
+        {
+            m_index -= static_cast<std::size_t>(n);
+            return *this;
+        }
+        friend Iterator operator+(Iterator it, difference_type n) { return it += n; }
+        friend Iterator operator+(difference_type n, Iterator it) { return it += n; }
+        friend Iterator operator-(Iterator it, difference_type n) { return it -= n; }
+        friend difference_type operator-(const Iterator &a, const Iterator &b)
+        {
+            return static_cast<difference_type>(a.m_index) - static_cast<difference_type>(b.m_index);
+        }
+        friend bool operator==(const Iterator &a, const Iterator &b) { return a.m_index == b.m_index; }
+        friend auto operator<=>(const Iterator &a, const Iterator &b) { return a.m_index <=> b.m_index; }
+    };
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    SegmentedArray() = default;
+    SegmentedArray(std::initializer_list<T> list)
+    {
+        for (const T &value : list)
+            push_back(value);
+    }
+
+    SegmentedArray(const SegmentedArray &array)
+    {
+        reserve(array.size());
+        for (const T &value : array)
+            push_back(value);
+    }
+    SegmentedArray &operator=(const SegmentedArray &array)
+    {
+        if (this != &array)
+        {
+            SegmentedArray copy{array};
+            swap(copy);
+        }
+        return *this;
+    }
+    // moving the array moves the directory, the chunks (and the elements) stay where they are
+    SegmentedArray(SegmentedArray &&array) noexcept
+        : m_chunks{std::move(array.m_chunks)}, m_size{std::exchange(array.m_size, 0)}
+    {
+    }
+    SegmentedArray &operator=(SegmentedArray &&array) noexcept
+    {
+        SegmentedArray moved{std::move(array)};
+        swap(moved);
+        return *this;
+    }
+    ~SegmentedArray()
+    {
+        clear();
+        for (T *chunk : m_chunks)
+            freeChunk(chunk);
+    }
+
+    void swap(SegmentedArray &array) noexcept
+    {
+        m_chunks.swap(array.m_chunks);
+        std::swap(m_size, array.m_size);
+    }
+
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    std::size_t capacity() const { return m_chunks.size() * chunk_size; }
+    std::size_t chunkCount() const { return m_chunks.size(); }
+
+    T &operator[](std::size_t index)
+    {
+        assert(index < m_size);
+        return *slot(index);
+    }
+    const T &operator[](std::size_t index) const
+    {
+        assert(index < m_size);
+        return *slot(index);
+    }
+    T &back() { return (*this)[m_size - 1]; }
+    const T &back() const { return (*this)[m_size - 1]; }
+
+    iterator begin() { return {this, 0}; }
+    iterator end() { return {this, m_size}; }
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, m_size}; }
+
+    // calls function(chunk pointer, number of elements) for each run of contiguous elements: loops over whole chunks
+    // are as fast as loops over an array (no shift and mask per element), and the compiler can vectorize them
+    template <typename Function>
+    void forEachChunk(Function function) const
+    {
+        for (std::size_t first{0}; first < m_size; first += chunk_size)
+            function(static_cast<const T *>(m_chunks[first >> ChunkShift]), std::min(chunk_size, m_size - first));
+    }
+
+    // allocates the chunks for capacity elements up front
+    void reserve(std::size_t new_capacity)
+    {
+        std::size_t chunks{(new_capacity + chunk_mask) >> ChunkShift};
+        m_chunks.reserve(chunks);
+        while (m_chunks.size() < chunks)
+            addChunk();
+    }
+
+    void push_back(const T &value)
+    {
+        emplace_back(value);
+    }
+    void push_back(T &&value)
+    {
+        emplace_back(std::move(value));
+    }
+    template <typename... Args>
+    T &emplace_back(Args &&...args)
+    {
+        T *element{::new (static_cast<void *>(nextSlot())) T(std::forward<Args>(args)...)};
+        ++m_size;
+        return *element;
+    }
+    void pop_back()
+    {
+        assert(m_size > 0);
+        std::destroy_at(slot(--m_size));
+    }
+    // destroys the elements, keeps the chunks
+    void clear()
+    {
+        while (m_size > 0)
+            pop_back();
+    }
+};
+
+#endif
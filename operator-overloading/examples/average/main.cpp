@@ -1,11 +1,57 @@
+#include "statistics.h"
+#include "sliding_window.h"
+#include "timer.h"
 #include <cstdint>
 #include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <cmath>
+#include <cassert>
+#include <sstream>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+/*
+    * Overloading operator+= and operator<< for an accumulator class
+    * Streaming statistics: Welford's mean and variance, mergeable accumulators
+    * Approximate quantiles in a fixed amount of memory (KLL sketch)
+    * Vectorized batches of values (SSE2, AVX2)
+    * Sliding windows: ring buffers and a queue made of two stacks
+*/
+
+/*
+Average keeps the sum and the number of values: with an std::int8_t count, the 128th value makes the count wrap to -128, and an
+std::int32_t sum overflows after a few thousand values of a million. Both are std::int64_t here.
+
+A program measuring its latencies wants more than a mean: how spread they are (the standard deviation), the worst one, and the
+percentiles (half the requests are faster than the median, 99% faster than the 99th percentile). Statistics (statistics.h) keeps them
+for any number of values in a few kilobytes:
+    the mean and the variance with Welford's method, which stays exact when the values are big and close together, unlike a sum of
+    squares (see the first example below)
+    the min and the max
+    the quantiles with a KLL sketch (quantile_sketch.h): a few hundred of the values, each standing for a power of two of them,
+    which answers any percentile with an error of about 1.7% of the ranks
+Statistics can be added together (operator+=(const Statistics&)): each thread keeps its own, with no lock and no shared cache line,
+and a report adds them up. add(std::span<const double>) adds a batch of values with SIMD instructions, chosen for the cpu it runs on.
+
+A moving average (the last 100 values) or the max latency of the last minute only looks at the recent values (sliding_window.h):
+MovingWindow and TimeWindow keep the values of the window in a ring buffer allocated once, and update the mean and the variance
+when a value enters and when one leaves, instead of going over the whole window. The min and the max can't be "un-added" like a
+sum: the window is split in two stacks, the older values each with the min and the max of the values from it to the split, and
+the newer ones with only the min and the max of them all; when the older stack is empty, the split moves to the newest value and
+its mins and maxes are computed once. Both cost O(1) per value (amortized), whatever the size of the window, and never allocate
+after the constructor.
+*/
 
 class Average
 {
 private:
-    std::int32_t sum_numbers{0};
-    std::int8_t cout_numbers{0};
+    std::int64_t sum_numbers{0};
+    std::int64_t cout_numbers{0};
 
 public:
     Average() = default;
@@ -13,9 +59,22 @@ public:
     Average &operator+=(int num);
 };
 
+// counts the allocations of the program: the sliding windows must make none after their constructor
+std::size_t allocations{0};
+
+void *operator new(std::size_t size)
+{
+    ++allocations;
+    if (void *memory{std::malloc(size ? size : 1)})
+        return memory;
+    throw std::bad_alloc{};
+}
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+
 std::ostream &operator<<(std::ostream &out, const Average &avg)
 {
-    out << avg.sum_numbers << '/' << static_cast<int>(avg.cout_numbers) << '=' << static_cast<float>(avg.sum_numbers) / avg.cout_numbers << '\n';
+    out << avg.sum_numbers << '/' << avg.cout_numbers << '=' << static_cast<float>(avg.sum_numbers) / avg.cout_numbers << '\n';
     return out;
 }
 
@@ -48,5 +107,192 @@ int main()
     Average copy{avg};
     std::cout << copy << '\n';
 
+    for (int i{0}; i < 1000; ++i) // 1006 values: an std::int8_t count would be -18
+        copy += 7;
+    std::cout << copy << '\n';
+
+    /* Streaming statistics */
+    Statistics stats{};
+    for (int value : {4, 8, 24, -10, 6, 10})
+        stats += value;
+    std::cout << stats << '\n';
+    assert(stats.count() == 6 && stats.mean() == 7 && stats.min() == -10 && stats.max() == 24 && stats.sum() == 42);
+    assert(std::abs(stats.sampleVariance() - 119.6) < 1e-9);
+    {
+        Statistics twice{stats};
+        twice += twice; // every value twice: the same mean and median
+        assert(twice.count() == 12 && twice.mean() == 7 && twice.median() == stats.median() && twice.max() == 24);
+    }
+
+    {
+        // big values close together: the sum of the squares loses the variance, Welford keeps it
+        Statistics latencies{};
+        double sum{0}, sum_squares{0};
+        for (int i{0}; i < 1000; ++i)
+        {
+            double value{1e9 + i % 2}; // a variance of 0.25
+            latencies += value;
+            sum += value;
+            sum_squares += value * value;
+        }
+        double naive{sum_squares / 1000 - (sum / 1000) * (sum / 1000)};
+        std::cout << "variance of 1e9 and 1e9 + 1: Welford " << latencies.variance() << ", sum of squares " << naive << '\n';
+        assert(latencies.variance() == 0.25);
+    }
+
+    std::mt19937 random{42};
+    std::lognormal_distribution<double> latency{std::log(200'000.0), 0.5}; // nanoseconds: a long tail, like real latencies
+
+    {
+        // add(span) and adding the values one by one, merged per thread or not: the same results
+        std::vector<double> values(100'003);
+        for (double &value : values)
+            value = latency(random);
+        Statistics one_by_one{}, batch{}, parts[4]{};
+        for (double value : values)
+            one_by_one += value;
+        batch.add(values);
+        for (std::size_t i{0}; i < values.size(); ++i)
+            parts[i * 4 / values.size()] += values[i];
+        Statistics merged{parts[0] + parts[1] + parts[2] + parts[3]};
+        for (const Statistics &other : {batch, merged})
+        {
+            assert(other.count() == one_by_one.count() && other.min() == one_by_one.min() && other.max() == one_by_one.max());
+            assert(std::abs(other.mean() - one_by_one.mean()) < 1e-9 * one_by_one.mean());
+            assert(std::abs(other.variance() - one_by_one.variance()) < 1e-9 * one_by_one.variance());
+        }
+    }
+
+    /* Benchmark: quantiles */
+    std::cout << "add(span) uses " << Statistics::implementation() << '\n';
+    std::cout << "quantiles of 10M latencies (exact, Statistics, its error in % of the ranks):\n";
+    {
+        std::vector<double> values(10'000'000);
+        for (double &value : values)
+            value = latency(random);
+        Statistics stats_10m{};
+        stats_10m.add(values);
+        std::vector<double> sorted{values};
+        std::sort(sorted.begin(), sorted.end());
+        for (double q : {0.01, 0.25, 0.5, 0.9, 0.99, 0.999})
+        {
+            double estimate{stats_10m.quantile(q)};
+            double rank{static_cast<double>(std::lower_bound(sorted.begin(), sorted.end(), estimate) - sorted.begin()) / static_cast<double>(sorted.size())};
+            std::cout << std::left << std::setw(8) << q << std::setw(12) << sorted[static_cast<std::size_t>(q * static_cast<double>(sorted.size()))]
+                      << std::setw(12) << estimate << std::showpos << (rank - q) * 100 << std::noshowpos << "%\n";
+            assert(std::abs(rank - q) < 0.03);
+        }
+    }
+
+    /* Benchmark: adding values */
+    std::cout << "ns per value:\n";
+    std::cout << "values      Average  Statistics +=  add(span)\n";
+    for (std::size_t count : {std::size_t{10'000}, std::size_t{1'000'000}, std::size_t{10'000'000}})
+    {
+        std::vector<double> values(count);
+        for (double &value : values)
+            value = latency(random);
+        std::vector<int> integers(values.begin(), values.end());
+        const double per_value{1e9 / static_cast<double>(count)};
+
+        Timer timer{};
+        Average average{};
+        for (int value : integers)
+            average += value;
+        double average_time{timer.elapsed()};
+        std::ostringstream text{};
+        text << average; // uses the result: the loop isn't optimized away
+
+        timer.reset();
+        Statistics one_by_one{};
+        for (double value : values)
+            one_by_one += value;
+        double one_by_one_time{timer.elapsed()};
+
+        timer.reset();
+        Statistics batch{};
+        batch.add(values);
+        double batch_time{timer.elapsed()};
+        assert(batch.count() == one_by_one.count() && !text.str().empty());
+
+        std::cout << std::left << std::setw(12) << count << std::setw(9) << average_time * per_value << std::setw(15)
+                  << one_by_one_time * per_value << batch_time * per_value << '\n';
+    }
+
+    /* Sliding windows */
+    {
+        MovingWindow last3{3};
+        for (int value : {4, 8, 24, -10, 6})
+            last3 += value;
+        std::cout << "last 3 values: " << last3 << '\n'; // 24, -10, 6
+        assert(last3.count() == 3 && std::abs(last3.mean() - 20.0 / 3) < 1e-12 && last3.min() == -10 && last3.max() == 24 && last3.median() == 6);
+
+        using namespace std::chrono_literals;
+        TimeWindow last_second{1s, 1000};
+        const TimeWindow::Clock::time_point start{};
+        last_second.add(start, 5).add(start + 400ms, 1).add(start + 900ms, 3);
+        assert(last_second.count() == 3 && last_second.max() == 5);
+        last_second.add(start + 1200ms, 2); // the value of start has left
+        assert(last_second.count() == 3 && last_second.max() == 3 && last_second.min() == 1);
+        last_second.expire(start + 2200ms);
+        assert(last_second.empty());
+
+        // against recomputing everything over the last values, and without allocating
+        std::vector<double> values(20'000);
+        for (double &value : values)
+            value = latency(random);
+        MovingWindow window{500};
+        std::size_t allocations_before{allocations};
+        for (std::size_t i{0}; i < values.size(); ++i)
+        {
+            window += values[i];
+            if (i % 97 != 0)
+                continue;
+            auto first{values.begin() + static_cast<std::ptrdiff_t>(i + 1 - window.count())}, last{values.begin() + static_cast<std::ptrdiff_t>(i + 1)};
+            double mean{std::accumulate(first, last, 0.0) / static_cast<double>(window.count())};
+            double m2{0};
+            for (auto it{first}; it != last; ++it)
+                m2 += (*it - mean) * (*it - mean);
+            assert(window.min() == *std::min_element(first, last) && window.max() == *std::max_element(first, last));
+            assert(std::abs(window.mean() - mean) <= 1e-9 * mean && std::abs(window.variance() - m2 / static_cast<double>(window.count())) <= 1e-6 * m2 / static_cast<double>(window.count()));
+            window.median();
+        }
+        assert(allocations == allocations_before);
+    }
+
+    /* Benchmark: sliding windows */
+    std::cout << "ns per value, mean, min and max of the last values after each one (recomputed, then MovingWindow):\n";
+    std::cout << "window    recomputed  MovingWindow\n";
+    {
+        std::vector<double> values(2'000'000);
+        for (double &value : values)
+            value = latency(random);
+        for (std::size_t size : {std::size_t{10}, std::size_t{100}, std::size_t{1'000}, std::size_t{10'000}})
+        {
+            // recomputing over the window: O(size) per value, on fewer values for the big windows
+            const std::size_t recomputed_count{std::min(values.size(), 200'000'000 / size)};
+            double check[2]{};
+            Timer timer{};
+            for (std::size_t i{size}; i < recomputed_count; ++i)
+            {
+                auto first{values.begin() + static_cast<std::ptrdiff_t>(i - size)}, last{values.begin() + static_cast<std::ptrdiff_t>(i)};
+                check[0] += std::accumulate(first, last, 0.0) / static_cast<double>(size) + *std::min_element(first, last) + *std::max_element(first, last);
+            }
+            double recomputed_time{timer.elapsed() / static_cast<double>(recomputed_count - size)};
+
+            MovingWindow window{size};
+            timer.reset();
+            for (double value : values)
+            {
+                window += value;
+                check[1] += window.mean() + window.min() + window.max();
+            }
+            double window_time{timer.elapsed() / static_cast<double>(values.size())};
+            assert(check[0] > 0 && check[1] > 0);
+
+            std::cout << std::setw(10) << size << std::setw(12) << recomputed_time * 1e9 << window_time * 1e9 << '\n';
+        }
+    }
+
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,176 @@
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Approximate quantiles (median, 99th percentile...) of a stream in a few kilobytes: a KLL sketch (Karnin, Lang, Liberty,
+// "Optimal quantile approximation in streams").
+//
+// The exact median of a billion latencies needs the billion values. The sketch keeps a few hundred of them, each standing for
+// 2^level values of the stream: new values go to level 0; when the sketch is full, the lowest full level is sorted and every
+// other value of it (the odd or the even positions, at random) moves up a level with twice the weight, the others are dropped.
+// The lower levels, where the dropped values would weigh little, are kept shorter than the top ones (each level is 2/3 of the
+// one above it, at least 8): the memory grows with the logarithm of the stream, and a quantile is off by about 1.7% of the
+// ranks with k = 200 (quantile(0.5) returns a value between the 48.3th and the 51.7th percentile, most of the time).
+//
+// Two sketches merge into one that summarizes both streams with the same accuracy: one per thread, merged when reporting.
+class QuantileSketch
+{
+private:
+    static constexpr std::size_t min_width{8};
+
+    std::size_t m_k{};
+    std::uint64_t m_count{};                     // the values added, the total weight of the levels
+    std::size_t m_retained{};                    // the values kept, in all the levels
+    std::size_t m_capacity{};                    // the values the levels can keep before compress()
+    std::vector<std::size_t> m_capacities{};     // of each level
+    std::vector<std::vector<double>> m_levels{}; // a value of level h stands for 2^h values; the levels above 0 are sorted
+    std::vector<double> m_promoted{};            // the values compress() moves up
+    std::vector<double> m_scratch{};             // for merging two levels without allocating each time
+    std::uint64_t m_random{0x9e3779b97f4a7c15};  // xorshift: which half of a level moves up
+
+    // the capacity of each level, with the top level the widest: computed when a level is added, compress() uses them often
+    void updateCapacity()
+    {
+        m_capacities.resize(m_levels.size());
+        m_capacity = 0;
+        for (std::size_t level{0}; level < m_levels.size(); ++level)
+        {
+            double depth{static_cast<double>(m_levels.size() - 1 - level)};
+            m_capacities[level] = std::max(min_width, static_cast<std::size_t>(std::ceil(static_cast<double>(m_k) * std::pow(2.0 / 3.0, depth))));
+            m_capacity += m_capacities[level];
+        }
+    }
+
+    bool randomBit()
+    {
+        m_random ^= m_random << 13;
+        m_random ^= m_random >> 7;
+        m_random ^= m_random << 17;
+        return m_random >> 63;
+    }
+
+    // merges the sorted values into level (sorted as well)
+    void mergeInto(std::size_t level, std::span<const double> values)
+    {
+        std::vector<double> &target{m_levels[level]};
+        m_scratch.resize(target.size() + values.size());
+        std::merge(target.begin(), target.end(), values.begin(), values.end(), m_scratch.begin());
+        std::swap(target, m_scratch);
+    }
+
+    // halves the lowest full level until the values fit in the capacity: only called when the sketch is full, so each value
+    // is sorted and moved a few times over its life, O(log) amortized
+    void compress()
+    {
+        while (m_retained >= m_capacity)
+        {
+            std::size_t level{0};
+            while (m_levels[level].size() < m_capacities[level]) // one exists: the levels together are over their capacity
+                ++level;
+            if (level + 1 == m_levels.size())
+            {
+                m_levels.emplace_back();
+                updateCapacity();
+            }
+            std::vector<double> &values{m_levels[level]};
+            if (level == 0)
+                std::sort(values.begin(), values.end());
+            // an odd value out stays at this level (the smallest), so that the total weight stays m_count
+            std::size_t first{values.size() % 2};
+            m_promoted.clear();
+            for (std::size_t i{first + randomBit()}; i < values.size(); i += 2)
+                m_promoted.push_back(values[i]);
+            m_retained -= values.size() - first - m_promoted.size();
+            values.resize(first);
+            mergeInto(level + 1, m_promoted);
+        }
+    }
+
+public:
+    // k sets the accuracy: the rank error is about 1.7% * 200 / k, the memory about 3k values
+    explicit QuantileSketch(std::size_t k = 200) : m_k{std::max(k, min_width)}, m_levels(1)
+    {
+        updateCapacity();
+    }
+
+    void add(double value)
+    {
+        m_levels[0].push_back(value);
+        ++m_count;
+        if (++m_retained >= m_capacity)
+            compress();
+    }
+    void add(std::span<const double> values)
+    {
+        while (!values.empty())
+        {
+            std::size_t room{m_capacity - m_retained}; // compress() leaves at least 1
+            std::size_t taken{std::min(room, values.size())};
+            m_levels[0].insert(m_levels[0].end(), values.begin(), values.begin() + static_cast<std::ptrdiff_t>(taken));
+            m_count += taken;
+            m_retained += taken;
+            values = values.subspan(taken);
+            if (m_retained >= m_capacity)
+                compress();
+        }
+    }
+
+    // adds the values other summarizes; the sketches should have the same k
+    void merge(const QuantileSketch &other)
+    {
+        if (&other == this)
+        {
+            // inserting a vector into itself isn't allowed: merge a copy
+            const QuantileSketch copy{other};
+            merge(copy);
+            return;
+        }
+        while (m_levels.size() < other.m_levels.size())
+            m_levels.emplace_back();
+        m_levels[0].insert(m_levels[0].end(), other.m_levels[0].begin(), other.m_levels[0].end());
+        for (std::size_t level{1}; level < other.m_levels.size(); ++level)
+            mergeInto(level, other.m_levels[level]);
+        m_count += other.m_count;
+        m_retained += other.m_retained;
+        updateCapacity();
+        if (m_retained >= m_capacity)
+            compress();
+    }
+
+    std::uint64_t count() const { return m_count; }
+    // the values kept: the memory used is about 8 bytes each
+    std::size_t retained() const { return m_retained; }
+
+    // a value of the stream with about q * count() values below it (q from 0 to 1), NaN for an empty sketch
+    // sorts the values kept: microseconds, for reports rather than for each value
+    double quantile(double q) const
+    {
+        if (m_count == 0)
+            return std::numeric_limits<double>::quiet_NaN();
+        std::vector<std::pair<double, std::uint64_t>> weighted{};
+        weighted.reserve(m_retained);
+        for (std::size_t level{0}; level < m_levels.size(); ++level)
+            for (double value : m_levels[level])
+                weighted.emplace_back(value, std::uint64_t{1} << level);
+        std::sort(weighted.begin(), weighted.end());
+        double rank{std::clamp(q, 0.0, 1.0) * static_cast<double>(m_count)};
+        std::uint64_t below{0};
+        for (const auto &[value, weight] : weighted)
+        {
+            below += weight;
+            if (static_cast<double>(below) >= rank)
+                return value;
+        }
+        return weighted.back().first;
+    }
+};
+
+#endif
@@ -0,0 +1,247 @@
+#ifndef SLIDING_WINDOW_H
+#define SLIDING_WINDOW_H
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+// The statistics of the values in a window that slides over a stream: the values enter at one end and leave at the other.
+// MovingWindow keeps the last N values, TimeWindow the values of the last T seconds.
+//
+// Every operation is O(1) (amortized) and allocates nothing after the constructor, except quantile(), O(n). The values are kept in
+// an array used as a ring (the positions wrap around its end), allocated by the constructor.
+//   the mean and the variance come from the sum of the values and the sum of their squares, updated when a value enters and
+//   when one leaves; not of the values themselves but of their distance to a shift, a value close to the mean: the sum of the
+//   squares of values like 1'000'000 +- 10 would lose the variance (see Statistics). Unlike Welford's update (Statistics),
+//   nothing is divided: a division takes 15 cycles, and each update would wait for the previous one. The shift is set to the
+//   mean and the sums recomputed from the window once per capacity() values that entered (O(1) amortized), which also
+//   drops the rounding errors the removals add up
+//   the min and the max can't be "un-added" when a value leaves. The window is split in two stacks: the older values, each with
+//   the min and the max of itself and the values after it up to the split (the values leave from this end), and the newer
+//   values, with only the min and the max of them all (the values enter at this end). The min of the window is the min of the
+//   two. When the older part is empty, the split moves to the newest value and the mins and maxes of the values are computed
+//   from the newest to the oldest: each value is part of that once, O(1) amortized. A monotonic queue (the candidates to be the
+//   min, popped from the back while greater than the new value) is O(1) amortized too, but its loop exits at an unpredictable
+//   point for each value: with random values, the mispredicted branches made it 4 times slower
+//   quantile() copies the window to a buffer allocated by the constructor and partially sorts it (std::nth_element)
+class WindowStatistics
+{
+private:
+    struct Sample
+    {
+        std::int64_t time{}; // for TimeWindow
+        double value{};
+    };
+    struct Extremes
+    {
+        double min{std::numeric_limits<double>::infinity()};
+        double max{-std::numeric_limits<double>::infinity()};
+    };
+
+    std::size_t m_capacity{};
+    std::size_t m_mask{}; // the arrays have a power of two size: position & m_mask is the index of a position
+    std::unique_ptr<Sample[]> m_samples{};
+    std::unique_ptr<Extremes[]> m_suffix{};  // of the values from this one to m_split (excluded)
+    std::unique_ptr<double[]> m_scratch{};   // for quantile(): two threads can't call it at the same time, even on a const window
+    // positions, never wrapped: the older values are [m_front, m_split), the newer ones [m_split, m_back)
+    std::uint64_t m_front{};
+    std::uint64_t m_split{};
+    std::uint64_t m_back{};
+    Extremes m_newer{}; // of the newer values
+    std::size_t m_since_recompute{};
+    double m_shift{};
+    double m_sum{};         // of value - m_shift
+    double m_sum_squares{}; // of (value - m_shift)^2
+
+    const Sample &sample(std::uint64_t position) const { return m_samples[position & m_mask]; }
+
+    void recompute()
+    {
+        double sum{0};
+        for (std::uint64_t i{m_front}; i != m_back; ++i)
+            sum += sample(i).value;
+        m_shift = sum / static_cast<double>(count());
+        m_sum = 0;
+        m_sum_squares = 0;
+        for (std::uint64_t i{m_front}; i != m_back; ++i)
+        {
+            double distance{sample(i).value - m_shift};
+            m_sum += distance;
+            m_sum_squares += distance * distance;
+        }
+        m_since_recompute = 0;
+    }
+
+    // the newer values become the older ones
+    void moveSplit()
+    {
+        Extremes extremes{};
+        for (std::uint64_t i{m_back}; i != m_front; --i)
+        {
+            extremes.min = std::min(extremes.min, sample(i - 1).value);
+            extremes.max = std::max(extremes.max, sample(i - 1).value);
+            m_suffix[(i - 1) & m_mask] = extremes;
+        }
+        m_split = m_back;
+        m_newer = Extremes{};
+    }
+
+    Extremes extremes() const
+    {
+        if (m_front == m_split)
+            return m_newer;
+        const Extremes &older{m_suffix[m_front & m_mask]};
+        return Extremes{std::min(older.min, m_newer.min), std::max(older.max, m_newer.max)};
+    }
+
+protected:
+    explicit WindowStatistics(std::size_t capacity) : m_capacity{capacity}
+    {
+        if (capacity == 0)
+            throw std::length_error{"WindowStatistics: a window of 0 values"};
+        std::size_t size{std::bit_ceil(capacity)};
+        m_mask = size - 1;
+        m_samples = std::make_unique<Sample[]>(size);
+        m_suffix = std::make_unique<Extremes[]>(size);
+        m_scratch = std::make_unique<double[]>(capacity);
+    }
+
+    // the window must not be full
+    void push(double value, std::int64_t time = 0)
+    {
+        assert(!full());
+        m_samples[m_back & m_mask] = Sample{time, value};
+        ++m_back;
+        m_newer.min = std::min(m_newer.min, value);
+        m_newer.max = std::max(m_newer.max, value);
+
+        if (++m_since_recompute >= m_capacity)
+        {
+            recompute();
+            return;
+        }
+        double distance{value - m_shift};
+        m_sum += distance;
+        m_sum_squares += distance * distance;
+    }
+
+    // removes the oldest value; the window must not be empty
+    void popOldest()
+    {
+        assert(!empty());
+        if (m_front == m_split)
+            moveSplit();
+        double distance{sample(m_front).value - m_shift};
+        m_sum -= distance;
+        m_sum_squares -= distance * distance;
+        ++m_front;
+    }
+
+    bool full() const { return count() == m_capacity; }
+    // the time of the oldest value; the window must not be empty
+    std::int64_t oldestTime() const { return sample(m_front).time; }
+
+public:
+    // the number of values in the window
+    std::size_t count() const { return static_cast<std::size_t>(m_back - m_front); }
+    std::size_t capacity() const { return m_capacity; }
+    bool empty() const { return m_front == m_back; }
+
+    // the next functions return NaN for an empty window
+    double mean() const { return empty() ? std::numeric_limits<double>::quiet_NaN() : m_shift + m_sum / static_cast<double>(count()); }
+    double sum() const { return m_shift * static_cast<double>(count()) + m_sum; }
+    // divided by count(); can be a rounding error below 0 after removals
+    double variance() const
+    {
+        if (empty())
+            return std::numeric_limits<double>::quiet_NaN();
+        double n{static_cast<double>(count())};
+        return std::max(0.0, (m_sum_squares - m_sum * m_sum / n) / n);
+    }
+    double standardDeviation() const { return std::sqrt(variance()); }
+    double min() const { return empty() ? std::numeric_limits<double>::quiet_NaN() : extremes().min; }
+    double max() const { return empty() ? std::numeric_limits<double>::quiet_NaN() : extremes().max; }
+    // the value with q * count() values of the window below it (q from 0 to 1), exact; O(count())
+    double quantile(double q) const
+    {
+        if (empty())
+            return std::numeric_limits<double>::quiet_NaN();
+        for (std::uint64_t i{m_front}; i != m_back; ++i)
+            m_scratch[i - m_front] = sample(i).value;
+        std::size_t rank{static_cast<std::size_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(count() - 1) + 0.5)};
+        std::nth_element(m_scratch.get(), m_scratch.get() + rank, m_scratch.get() + count());
+        return m_scratch[rank];
+    }
+    double median() const { return quantile(0.5); }
+
+    friend std::ostream &operator<<(std::ostream &out, const WindowStatistics &window)
+    {
+        out << "count " << window.count() << ", mean " << window.mean() << ", standard deviation " << window.standardDeviation()
+            << ", min " << window.min() << ", median " << window.median() << ", max " << window.max();
+        return out;
+    }
+};
+
+// the statistics of the last size values added: window += value drops the oldest value once size values are in the window
+class MovingWindow : public WindowStatistics
+{
+public:
+    explicit MovingWindow(std::size_t size) : WindowStatistics{size} {}
+
+    MovingWindow &operator+=(double value)
+    {
+        if (full())
+            popOldest();
+        push(value);
+        return *this;
+    }
+};
+
+// the statistics of the values added during the last span of time
+// At most capacity values are kept: when more are added during one span, the oldest leave early (the window then covers less
+// than span). The times must not go backwards: std::chrono::steady_clock, not the system clock that can be set back.
+class TimeWindow : public WindowStatistics
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    Clock::duration m_span{};
+
+    static std::int64_t ticks(Clock::time_point time) { return time.time_since_epoch().count(); }
+
+public:
+    TimeWindow(Clock::duration span, std::size_t capacity) : WindowStatistics{capacity}, m_span{span} {}
+
+    // a value measured at time
+    TimeWindow &add(Clock::time_point time, double value)
+    {
+        expire(time);
+        if (full())
+            popOldest();
+        push(value, ticks(time));
+        return *this;
+    }
+    // a value measured now
+    TimeWindow &operator+=(double value) { return add(Clock::now(), value); }
+
+    // drops the values older than now - span: call it before reading the statistics when no value was added for a while
+    void expire(Clock::time_point now)
+    {
+        const std::int64_t oldest_kept{ticks(now - m_span)};
+        while (!empty() && oldestTime() <= oldest_kept)
+            popOldest();
+    }
+
+    Clock::duration span() const { return m_span; }
+};
+
+#endif
@@ -0,0 +1,263 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include "quantile_sketch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <span>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(STATISTICS_NO_DISPATCH)
+#define STATISTICS_X86
+#include <immintrin.h>
+#endif
+
+// count, mean, variance, min, max and quantiles of a stream of values, without keeping the values: what Average of main.cpp
+// does for the mean, for any number of values.
+//
+// The mean and the variance are updated with Welford's method: the mean moves by (value - mean) / count, and the sum of the
+// squared distances to the mean (m_m2) by (value - old mean) * (value - new mean). Summing the values and their squares, then
+// computing sum_squares / n - mean^2 at the end, loses every digit of the variance when the values are large and close
+// together (latencies of 1'000'000 +- 10 ns): two nearly equal numbers are subtracted.
+//
+// Two Statistics merge into one with the formula of Chan, Golub and LeVeque (operator+=(const Statistics&)): a thread can keep
+// its own, without sharing a cache line with the other threads, and they are added together when reporting.
+// add(span) adds values by blocks: the sum, min and max of the block in one vectorized pass, the squared distances to the block's
+// mean in a second one (the block is still in the cache), then the block is merged like another Statistics. The kernel (AVX2 or
+// SSE2) is chosen once from what the cpu supports, like StringSearch::find(). An AVX-512 kernel wouldn't be faster: the moments
+// of a block cost about 1 ns per value with AVX2, the quantile sketch takes most of the time.
+//
+// NaN values aren't supported: they would make the mean NaN, and min() and max() depend on where they are.
+class Statistics
+{
+private:
+    struct Moments
+    {
+        std::uint64_t count{};
+        double mean{};
+        double m2{};
+        double min{std::numeric_limits<double>::infinity()};
+        double max{-std::numeric_limits<double>::infinity()};
+    };
+    using BlockFunction = Moments (*)(const double *values, std::size_t count);
+
+    // small enough to stay in the L1 cache between the two passes
+    static constexpr std::size_t block_size{2048};
+
+    Moments m_moments{};
+    QuantileSketch m_quantiles{};
+
+    static Moments momentsScalar(const double *values, std::size_t count)
+    {
+        Moments block{count};
+        double sum{0};
+        for (std::size_t i{0}; i < count; ++i)
+        {
+            sum += values[i];
+            block.min = std::min(block.min, values[i]);
+            block.max = std::max(block.max, values[i]);
+        }
+        block.mean = sum / static_cast<double>(count);
+        for (std::size_t i{0}; i < count; ++i)
+            block.m2 += (values[i] - block.mean) * (values[i] - block.mean);
+        return block;
+    }
+
+#if defined(STATISTICS_X86)
+    static double horizontalSum(__m128d v) { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+    static double horizontalMin(__m128d v) { return _mm_cvtsd_f64(_mm_min_sd(v, _mm_unpackhi_pd(v, v))); }
+    static double horizontalMax(__m128d v) { return _mm_cvtsd_f64(_mm_max_sd(v, _mm_unpackhi_pd(v, v))); }
+    // the two halves of an AVX register
+    __attribute__((target("avx"))) static __m128d low128(__m256d v) { return _mm256_castpd256_pd128(v); }
+    __attribute__((target("avx"))) static __m128d high128(__m256d v) { return _mm256_extractf128_pd(v, 1); }
+
+    // 2 accumulators of 2 values: the additions of one don't wait for the other's (an addition takes 4 cycles)
+    static Moments momentsSse2(const double *values, std::size_t count)
+    {
+        __m128d sum[2]{_mm_setzero_pd(), _mm_setzero_pd()};
+        __m128d low{_mm_set1_pd(std::numeric_limits<double>::infinity())};
+        __m128d high{_mm_set1_pd(-std::numeric_limits<double>::infinity())};
+        std::size_t i{0};
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128d a{_mm_loadu_pd(values + i)}, b{_mm_loadu_pd(values + i + 2)};
+            sum[0] = _mm_add_pd(sum[0], a);
+            sum[1] = _mm_add_pd(sum[1], b);
+            low = _mm_min_pd(low, _mm_min_pd(a, b));
+            high = _mm_max_pd(high, _mm_max_pd(a, b));
+        }
+        Moments block{count, 0, 0, horizontalMin(low), horizontalMax(high)};
+        double total{horizontalSum(_mm_add_pd(sum[0], sum[1]))};
+        for (std::size_t j{i}; j < count; ++j)
+        {
+            total += values[j];
+            block.min = std::min(block.min, values[j]);
+            block.max = std::max(block.max, values[j]);
+        }
+        block.mean = total / static_cast<double>(count);
+
+        __m128d mean{_mm_set1_pd(block.mean)};
+        __m128d m2[2]{_mm_setzero_pd(), _mm_setzero_pd()};
+        for (i = 0; i + 4 <= count; i += 4)
+        {
+            __m128d a{_mm_sub_pd(_mm_loadu_pd(values + i), mean)}, b{_mm_sub_pd(_mm_loadu_pd(values + i + 2), mean)};
+            m2[0] = _mm_add_pd(m2[0], _mm_mul_pd(a, a));
+            m2[1] = _mm_add_pd(m2[1], _mm_mul_pd(b, b));
+        }
+        block.m2 = horizontalSum(_mm_add_pd(m2[0], m2[1]));
+        for (; i < count; ++i)
+            block.m2 += (values[i] - block.mean) * (values[i] - block.mean);
+        return block;
+    }
+
+    __attribute__((target("avx2,fma"))) static Moments momentsAvx2(const double *values, std::size_t count)
+    {
+        __m256d sum[2]{_mm256_setzero_pd(), _mm256_setzero_pd()};
+        __m256d low{_mm256_set1_pd(std::numeric_limits<double>::infinity())};
+        __m256d high{_mm256_set1_pd(-std::numeric_limits<double>::infinity())};
+        std::size_t i{0};
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256d a{_mm256_loadu_pd(values + i)}, b{_mm256_loadu_pd(values + i + 4)};
+            sum[0] = _mm256_add_pd(sum[0], a);
+            sum[1] = _mm256_add_pd(sum[1], b);
+            low = _mm256_min_pd(low, _mm256_min_pd(a, b));
+            high = _mm256_max_pd(high, _mm256_max_pd(a, b));
+        }
+        __m256d total4{_mm256_add_pd(sum[0], sum[1])};
+        Moments block{count, 0, 0, horizontalMin(_mm_min_pd(low128(low), high128(low))), horizontalMax(_mm_max_pd(low128(high), high128(high)))};
+        double total{horizontalSum(_mm_add_pd(low128(total4), high128(total4)))};
+        for (std::size_t j{i}; j < count; ++j)
+        {
+            total += values[j];
+            block.min = std::min(block.min, values[j]);
+            block.max = std::max(block.max, values[j]);
+        }
+        block.mean = total / static_cast<double>(count);
+
+        __m256d mean{_mm256_set1_pd(block.mean)};
+        __m256d m2[2]{_mm256_setzero_pd(), _mm256_setzero_pd()};
+        for (i = 0; i + 8 <= count; i += 8)
+        {
+            __m256d a{_mm256_sub_pd(_mm256_loadu_pd(values + i), mean)}, b{_mm256_sub_pd(_mm256_loadu_pd(values + i + 4), mean)};
+            m2[0] = _mm256_fmadd_pd(a, a, m2[0]);
+            m2[1] = _mm256_fmadd_pd(b, b, m2[1]);
+        }
+        __m256d m2_4{_mm256_add_pd(m2[0], m2[1])};
+        block.m2 = horizontalSum(_mm_add_pd(low128(m2_4), high128(m2_4)));
+        for (; i < count; ++i)
+            block.m2 += (values[i] - block.mean) * (values[i] - block.mean);
+        return block;
+    }
+
+    static BlockFunction selectBlock()
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return momentsAvx2;
+        return momentsSse2;
+    }
+    static const char *selectName()
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return "avx2";
+        return "sse2";
+    }
+#else
+    static BlockFunction selectBlock() { return momentsScalar; }
+    static const char *selectName() { return "scalar"; }
+#endif
+
+    // Chan et al.: the moments of the values of a and b together
+    static void merge(Moments &a, const Moments &b)
+    {
+        if (b.count == 0)
+            return;
+        std::uint64_t count{a.count + b.count};
+        double delta{b.mean - a.mean};
+        double share{static_cast<double>(b.count) / static_cast<double>(count)};
+        a.mean += delta * share;
+        a.m2 += b.m2 + delta * delta * static_cast<double>(a.count) * share;
+        a.count = count;
+        a.min = std::min(a.min, b.min);
+        a.max = std::max(a.max, b.max);
+    }
+
+public:
+    Statistics() = default;
+
+    Statistics &operator+=(double value)
+    {
+        ++m_moments.count;
+        double delta{value - m_moments.mean};
+        m_moments.mean += delta / static_cast<double>(m_moments.count);
+        m_moments.m2 += delta * (value - m_moments.mean);
+        m_moments.min = std::min(m_moments.min, value);
+        m_moments.max = std::max(m_moments.max, value);
+        m_quantiles.add(value);
+        return *this;
+    }
+    // the values of other too: for statistics kept per thread
+    Statistics &operator+=(const Statistics &other)
+    {
+        merge(m_moments, other.m_moments);
+        m_quantiles.merge(other.m_quantiles);
+        return *this;
+    }
+    friend Statistics operator+(Statistics a, const Statistics &b) { return a += b; }
+
+    // the same as adding the values one by one; only a little faster: the moments are vectorized, but the quantile sketch,
+    // which sorts and merges the values, takes most of the time either way
+    Statistics &add(std::span<const double> values)
+    {
+        static const BlockFunction block{selectBlock()}; // chosen on the first call
+        for (std::size_t first{0}; first < values.size(); first += block_size)
+        {
+            std::size_t count{std::min(block_size, values.size() - first)};
+            merge(m_moments, block(values.data() + first, count));
+        }
+        m_quantiles.add(values);
+        return *this;
+    }
+
+    std::uint64_t count() const { return m_moments.count; }
+    // the next functions return NaN when no value was added
+    double mean() const { return m_moments.count ? m_moments.mean : std::numeric_limits<double>::quiet_NaN(); }
+    double sum() const { return mean() * static_cast<double>(m_moments.count); }
+    // the variance of the values (divided by count), and of the population they are a sample of (divided by count - 1)
+    double variance() const { return m_moments.count ? m_moments.m2 / static_cast<double>(m_moments.count) : std::numeric_limits<double>::quiet_NaN(); }
+    double sampleVariance() const { return m_moments.count > 1 ? m_moments.m2 / static_cast<double>(m_moments.count - 1) : std::numeric_limits<double>::quiet_NaN(); }
+    double standardDeviation() const { return std::sqrt(variance()); }
+    double min() const { return m_moments.count ? m_moments.min : std::numeric_limits<double>::quiet_NaN(); }
+    double max() const { return m_moments.count ? m_moments.max : std::numeric_limits<double>::quiet_NaN(); }
+    // approximate, see QuantileSketch; the 0 and 1 quantiles are the exact min() and max()
+    double quantile(double q) const
+    {
+        if (q <= 0)
+            return min();
+        if (q >= 1)
+            return max();
+        return m_quantiles.quantile(q);
+    }
+    double median() const { return quantile(0.5); }
+
+    // the name of the instruction set add(span) uses on this cpu
+    static const char *implementation()
+    {
+        static const char *name{selectName()};
+        return name;
+    }
+
+    friend std::ostream &operator<<(std::ostream &out, const Statistics &stats)
+    {
+        out << "count " << stats.count() << ", mean " << stats.mean() << ", standard deviation " << stats.standardDeviation()
+            << ", min " << stats.min() << ", median " << stats.median() << ", 99% " << stats.quantile(0.99) << ", max " << stats.max();
+        return out;
+    }
+};
+
+#endif
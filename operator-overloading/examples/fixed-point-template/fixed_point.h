@@ -0,0 +1,265 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <type_traits>
+
+// What to do with the bits that don't fit after a multiplication, a division or a conversion from double
+enum class Rounding
+{
+    truncate, // toward zero, like integer division
+    nearest,  // to the nearest value, halfway cases away from zero (like std::round)
+};
+
+// What to do when a result doesn't fit in the format
+enum class Overflow
+{
+    wrap,     // keep the low bits, like unsigned integers do (cheapest)
+    saturate, // clamp to the largest/smallest value (what DSP code usually wants)
+};
+
+namespace FixedPointDetail
+{
+    __extension__ typedef __int128 int128; // GCC/Clang extension: only used for the 64-bit formats
+
+    // smallest signed integer holding Bits bits
+    template <int Bits>
+    using Storage = std::conditional_t<Bits <= 8, std::int8_t,
+                                       std::conditional_t<Bits <= 16, std::int16_t,
+                                                          std::conditional_t<Bits <= 32, std::int32_t, std::int64_t>>>;
+
+    // an integer twice as wide as Storage<Bits>: holds any product of two values without overflowing
+    template <int Bits>
+    using Wide = std::conditional_t<Bits <= 16, std::int32_t,
+                                    std::conditional_t<Bits <= 32, std::int64_t, int128>>;
+}
+
+// A signed binary fixed-point number stored in a single integer.
+// IntBits counts the integer bits including the sign bit, FracBits the bits after the binary point:
+// FixedPoint<16, 16> covers [-32768, 32768) with steps of 1/65536 in an int32_t.
+// Everything is constexpr and only uses integer arithmetic: doubles are only involved when converting from/to double.
+template <int IntBits, int FracBits, Rounding R = Rounding::nearest, Overflow O = Overflow::saturate>
+class FixedPoint
+{
+public:
+    static constexpr int integer_bits{IntBits};
+    static constexpr int fraction_bits{FracBits};
+    static constexpr int total_bits{IntBits + FracBits};
+
+    static_assert(IntBits >= 1, "FixedPoint needs at least the sign bit");
+    static_assert(FracBits >= 0, "FixedPoint can't have a negative number of fraction bits");
+    static_assert(total_bits <= 64, "FixedPoint is limited to 64 bits");
+
+    using Raw = FixedPointDetail::Storage<total_bits>;
+    using Wide = FixedPointDetail::Wide<total_bits>;
+
+private:
+    static constexpr Wide raw_max{(Wide{1} << (total_bits - 1)) - 1};
+    static constexpr Wide raw_min{-raw_max - 1};
+    static constexpr Wide raw_one{Wide{1} << FracBits};
+
+    Raw m_raw{};
+
+    // brings a wide intermediate result back into total_bits according to the overflow policy
+    // (written without branches so that loops over FixedPoint values can be vectorized)
+    static constexpr Raw narrow(Wide value)
+    {
+        if constexpr (O == Overflow::saturate)
+        {
+            value = value > raw_max ? raw_max : value;
+            value = value < raw_min ? raw_min : value;
+            return static_cast<Raw>(value);
+        }
+        else
+        {
+            // keep the low total_bits bits and sign extend them (well defined since C++20)
+            constexpr int unused_bits{static_cast<int>(sizeof(Wide) * 8) - total_bits};
+            return static_cast<Raw>(static_cast<Wide>(value << unused_bits) >> unused_bits);
+        }
+    }
+
+    // value / 2^FracBits according to the rounding policy
+    // >> on a negative value rounds toward -infinity, so negative values get a small correction first
+    static constexpr Wide shiftOutFraction(Wide value)
+    {
+        if constexpr (FracBits == 0)
+            return value;
+        else if constexpr (R == Rounding::nearest)
+        {
+            constexpr Wide half{Wide{1} << (FracBits - 1)};
+            return (value + half - (value < 0)) >> FracBits;
+        }
+        else
+        {
+            constexpr Wide fraction_mask{(Wide{1} << FracBits) - 1};
+            return (value + (value < 0 ? fraction_mask : 0)) >> FracBits;
+        }
+    }
+
+    // value * 2^FracBits, then the overflow policy: an int times raw_one doesn't fit in the 32-bit Wide of the formats of 16 bits
+    // or less, so the product is computed in 64 bits there
+    static constexpr Raw fromInteger(int value)
+    {
+        using Product = std::conditional_t<(sizeof(Wide) < sizeof(std::int64_t)), std::int64_t, Wide>;
+        Product product{static_cast<Product>(value) * raw_one};
+        if constexpr (O == Overflow::saturate)
+        {
+            product = product > raw_max ? raw_max : product;
+            product = product < raw_min ? raw_min : product;
+        }
+        return narrow(static_cast<Wide>(product)); // wrap: the conversion keeps the low bits (well defined since C++20)
+    }
+
+public:
+    constexpr FixedPoint() = default;
+    constexpr FixedPoint(int value) : m_raw{fromInteger(value)} {}
+    constexpr explicit FixedPoint(double value)
+    {
+        double scaled{value * static_cast<double>(raw_one)};
+        if constexpr (R == Rounding::nearest)
+            scaled += scaled >= 0 ? 0.5 : -0.5;
+        // converting an out of range double to an integer is undefined behavior: clamp first
+        if (scaled >= static_cast<double>(raw_max))
+            m_raw = static_cast<Raw>(raw_max);
+        else if (scaled <= static_cast<double>(raw_min))
+            m_raw = static_cast<Raw>(raw_min);
+        else
+            m_raw = static_cast<Raw>(scaled);
+    }
+
+    // builds a value directly from its integer representation
+    static constexpr FixedPoint fromRaw(Raw raw)
+    {
+        FixedPoint result{};
+        result.m_raw = raw;
+        return result;
+    }
+    constexpr Raw raw() const { return m_raw; }
+
+    // builds a value from a product (or a sum of products) of raw values, which has 2 * FracBits fraction bits
+    static constexpr FixedPoint fromProduct(Wide product)
+    {
+        return fromRaw(narrow(shiftOutFraction(product)));
+    }
+
+    static constexpr FixedPoint max() { return fromRaw(static_cast<Raw>(raw_max)); }
+    static constexpr FixedPoint min() { return fromRaw(static_cast<Raw>(raw_min)); }
+    static constexpr FixedPoint epsilon() { return fromRaw(1); } // smallest positive step
+
+    explicit constexpr operator double() const { return static_cast<double>(m_raw) / static_cast<double>(raw_one); }
+
+    constexpr FixedPoint operator-() const { return fromRaw(narrow(-static_cast<Wide>(m_raw))); }
+    constexpr FixedPoint operator+() const { return *this; }
+
+    friend constexpr FixedPoint operator+(FixedPoint a, FixedPoint b)
+    {
+        return fromRaw(narrow(static_cast<Wide>(a.m_raw) + b.m_raw));
+    }
+    friend constexpr FixedPoint operator-(FixedPoint a, FixedPoint b)
+    {
+        return fromRaw(narrow(static_cast<Wide>(a.m_raw) - b.m_raw));
+    }
+    // the product of two raw values has 2 * FracBits fraction bits: shift half of them out
+    friend constexpr FixedPoint operator*(FixedPoint a, FixedPoint b)
+    {
+        return fromProduct(static_cast<Wide>(a.m_raw) * b.m_raw);
+    }
+    // pre-shift the dividend so the quotient keeps FracBits fraction bits
+    friend constexpr FixedPoint operator/(FixedPoint a, FixedPoint b)
+    {
+        assert(b.m_raw != 0 && "FixedPoint: division by zero");
+        Wide dividend{static_cast<Wide>(a.m_raw) * raw_one};
+        Wide quotient{dividend / b.m_raw};
+        if constexpr (R == Rounding::nearest)
+        {
+            Wide remainder{dividend % b.m_raw};
+            Wide twice{remainder < 0 ? -2 * remainder : 2 * remainder};
+            if (twice >= (b.m_raw < 0 ? -static_cast<Wide>(b.m_raw) : static_cast<Wide>(b.m_raw)))
+                quotient += (dividend < 0) == (b.m_raw < 0) ? 1 : -1;
+        }
+        return fromRaw(narrow(quotient));
+    }
+
+    constexpr FixedPoint &operator+=(FixedPoint other) { return *this = *this + other; }
+    constexpr FixedPoint &operator-=(FixedPoint other) { return *this = *this - other; }
+    constexpr FixedPoint &operator*=(FixedPoint other) { return *this = *this * other; }
+    constexpr FixedPoint &operator/=(FixedPoint other) { return *this = *this / other; }
+
+    // comparisons are plain integer comparisons of the raw values
+    friend constexpr bool operator==(FixedPoint a, FixedPoint b) { return a.m_raw == b.m_raw; }
+    friend constexpr bool operator!=(FixedPoint a, FixedPoint b) { return !(a == b); }
+    friend constexpr bool operator<(FixedPoint a, FixedPoint b) { return a.m_raw < b.m_raw; }
+    friend constexpr bool operator>(FixedPoint a, FixedPoint b) { return b < a; }
+    friend constexpr bool operator<=(FixedPoint a, FixedPoint b) { return !(b < a); }
+    friend constexpr bool operator>=(FixedPoint a, FixedPoint b) { return !(a < b); }
+
+    friend std::ostream &operator<<(std::ostream &out, FixedPoint f)
+    {
+        out << static_cast<double>(f);
+        return out;
+    }
+};
+
+// number of bits (sign included) needed to hold the integer part of any value in [-magnitude, magnitude]
+constexpr int integerBitsFor(long long magnitude)
+{
+    int bits{1};
+    for (; magnitude > 0; magnitude >>= 1)
+        ++bits;
+    return bits;
+}
+
+// Picks the format at compile time from the largest magnitude we need to represent:
+// FixedPointFor<1000, 10> is FixedPoint<11, 10>, stored in an int32_t
+template <long long MaxMagnitude, int FracBits, Rounding R = Rounding::nearest, Overflow O = Overflow::saturate>
+using FixedPointFor = FixedPoint<integerBitsFor(MaxMagnitude), FracBits, R, O>;
+
+// common formats
+using Q8_8 = FixedPoint<8, 8>;
+using Q16_16 = FixedPoint<16, 16>;
+using Q32_32 = FixedPoint<32, 32>;
+
+// Batch kernels: plain loops over contiguous values.
+// FixedPoint is a single integer with inlined operators, so the compiler turns these into vector instructions
+// (packed adds, multiplies and min/max for saturation) just like it does for loops over int.
+template <typename FP>
+void addBatch(std::span<const FP> a, std::span<const FP> b, std::span<FP> out)
+{
+    assert(a.size() == b.size() && a.size() <= out.size());
+    for (std::size_t i{0}; i < a.size(); ++i)
+        out[i] = a[i] + b[i];
+}
+
+template <typename FP>
+void multiplyBatch(std::span<const FP> a, std::span<const FP> b, std::span<FP> out)
+{
+    assert(a.size() == b.size() && a.size() <= out.size());
+    for (std::size_t i{0}; i < a.size(); ++i)
+        out[i] = a[i] * b[i];
+}
+
+// out[i] = a[i] * scale + offset
+template <typename FP>
+void scaleBatch(std::span<const FP> a, FP scale, FP offset, std::span<FP> out)
+{
+    assert(a.size() <= out.size());
+    for (std::size_t i{0}; i < a.size(); ++i)
+        out[i] = a[i] * scale + offset;
+}
+
+// accumulates the exact products in the wide type and rounds only once at the end
+// (the caller must keep the sum within the wide type: 2 * total_bits bits)
+template <typename FP>
+FP dotProduct(std::span<const FP> a, std::span<const FP> b)
+{
+    assert(a.size() == b.size());
+    typename FP::Wide sum{};
+    for (std::size_t i{0}; i < a.size(); ++i)
+        sum += static_cast<typename FP::Wide>(a[i].raw()) * b[i].raw();
+    return FP::fromProduct(sum);
+}
+
+#endif
@@ -0,0 +1,353 @@
+#ifndef FIXED_POINT_MATH_H
+#define FIXED_POINT_MATH_H
+
+#include "fixed_point.h"
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <utility>
+
+// Integer-only sqrt, exp, log, sin and cos for FixedPoint formats of up to 32 bits (with at most 30 fraction bits).
+// Every function works internally on int64_t values with 32 fraction bits (Q32) and rounds once when converting back.
+//
+// Measured maximum errors for FixedPoint<16, 16> (see main.cpp), in steps of 1/65536:
+//     sqrt        0.5  (correctly rounded: checked on every input of FixedPoint<12, 12>, sampled for FixedPoint<16, 16>)
+//     exp         0.67 (for x in [-12, 11], larger results saturate)
+//     log         0.5
+//     sin, cos    0.62 (for |x| < 1000: the reduction modulo 2 * pi slowly loses precision for huge angles)
+// The internal rounding errors are around 2^-31, so formats with close to 32 fraction bits lose a little:
+// sin/cos reach 1.4 steps for FixedPoint<4, 28>.
+//
+// Domain errors don't throw (this is meant for hot loops): sqrt of a negative value returns 0, log of a value <= 0 returns min(),
+// and results that don't fit in the format saturate.
+namespace FixedPointMath
+{
+    namespace Detail
+    {
+        using Q32 = std::int64_t; // 32 fraction bits
+        using FixedPointDetail::int128;
+
+        constexpr Q32 q32_one{Q32{1} << 32};
+
+        constexpr Q32 fromDouble(double d)
+        {
+            return static_cast<Q32>(d * 4294967296.0 + (d >= 0 ? 0.5 : -0.5));
+        }
+        constexpr Q32 mulQ32(Q32 a, Q32 b)
+        {
+            return static_cast<Q32>((static_cast<int128>(a) * b) >> 32);
+        }
+
+        // Newton's method: std::sqrt isn't constexpr
+        constexpr double constexprSqrt(double x)
+        {
+            double guess{x > 1 ? x : 1.0};
+            for (int i{0}; i < 64; ++i)
+                guess = 0.5 * (guess + x / guess);
+            return guess;
+        }
+
+        // log(y) for y in [0.5, 2] with the atanh series: std::log isn't constexpr either
+        constexpr double constexprLog(double y)
+        {
+            double s{(y - 1) / (y + 1)};
+            double term{s};
+            double sum{};
+            for (int n{1}; n < 80; n += 2)
+            {
+                sum += term / n;
+                term *= s * s;
+            }
+            return 2 * sum;
+        }
+
+        constexpr Q32 ln2{fromDouble(0.69314718055994530942)};
+        constexpr int128 ln2_q64{static_cast<int128>(12786308645202655659ull)}; // 64 fraction bits: k * ln2 must stay exact for large k
+        constexpr Q32 inv_ln2{fromDouble(1.44269504088896340736)};
+        constexpr Q32 pi{fromDouble(3.14159265358979323846)};
+        constexpr Q32 half_pi{fromDouble(1.57079632679489661923)};
+        constexpr Q32 two_pi{fromDouble(6.28318530717958647692)};
+
+        constexpr int cordic_iterations{32};
+
+        // atan(2^-i): the angles CORDIC rotates by, computed at compile time with the atan series
+        constexpr std::array<Q32, cordic_iterations> cordic_angles{[]
+                                                                   {
+                                                                       std::array<Q32, cordic_iterations> angles{};
+                                                                       angles[0] = fromDouble(0.78539816339744830962); // atan(1) = pi / 4
+                                                                       for (int i{1}; i < cordic_iterations; ++i)
+                                                                       {
+                                                                           double t{1.0 / static_cast<double>(Q32{1} << i)};
+                                                                           double term{t};
+                                                                           double sum{};
+                                                                           for (int n{1}; n < 60; n += 2)
+                                                                           {
+                                                                               sum += (n % 4 == 1 ? term : -term) / n;
+                                                                               term *= t * t;
+                                                                           }
+                                                                           angles[static_cast<std::size_t>(i)] = fromDouble(sum);
+                                                                       }
+                                                                       return angles;
+                                                                   }()};
+
+        // every CORDIC rotation also scales the vector by sqrt(1 + 2^-2i): start from 1 / (product of all the scales)
+        constexpr Q32 cordic_gain{[]
+                                  {
+                                      double product{1.0};
+                                      for (int i{0}; i < cordic_iterations; ++i)
+                                          product *= 1.0 + 1.0 / static_cast<double>(Q32{1} << (2 * i));
+                                      return fromDouble(1.0 / constexprSqrt(product));
+                                  }()};
+
+        // 1/n for the polynomial coefficients: a multiplication is much cheaper than a division
+        constexpr std::array<Q32, 14> reciprocals{[]
+                                                  {
+                                                      std::array<Q32, 14> table{};
+                                                      for (int n{1}; n < 14; ++n)
+                                                          table[static_cast<std::size_t>(n)] = q32_one / n;
+                                                      return table;
+                                                  }()};
+
+        // log: m in [1, 2) is split by its 6 highest fraction bits into 64 intervals.
+        // log_reciprocals[i] is about 1 / (middle of the interval i), so m * log_reciprocals[i] is close to 1,
+        // and log_offsets[i] = -log(log_reciprocals[i]) is computed from the rounded reciprocal so the two tables agree exactly.
+        constexpr int log_table_bits{6};
+        constexpr std::size_t log_table_size{std::size_t{1} << log_table_bits};
+        constexpr std::array<Q32, log_table_size> log_reciprocals{[]
+                                                                  {
+                                                                      std::array<Q32, log_table_size> table{};
+                                                                      for (std::size_t i{0}; i < log_table_size; ++i)
+                                                                          table[i] = fromDouble(1.0 / (1.0 + (static_cast<double>(i) + 0.5) / log_table_size));
+                                                                      return table;
+                                                                  }()};
+        constexpr std::array<Q32, log_table_size> log_offsets{[]
+                                                              {
+                                                                  std::array<Q32, log_table_size> table{};
+                                                                  for (std::size_t i{0}; i < log_table_size; ++i)
+                                                                      table[i] = fromDouble(-constexprLog(static_cast<double>(log_reciprocals[i]) / 4294967296.0));
+                                                                  return table;
+                                                              }()};
+
+        // sqrt: first guess from the 8 highest bits, sqrt_guesses[i] = ceil(sqrt(i + 1) * 16)
+        constexpr std::array<std::uint64_t, 256> sqrt_guesses{[]
+                                                             {
+                                                                 std::array<std::uint64_t, 256> table{};
+                                                                 for (std::size_t i{0}; i < 256; ++i)
+                                                                 {
+                                                                     auto guess{static_cast<std::uint64_t>(constexprSqrt(static_cast<double>(i + 1)) * 16)};
+                                                                     while (guess * guess < (i + 1) * 256)
+                                                                         ++guess;
+                                                                     table[i] = guess;
+                                                                 }
+                                                                 return table;
+                                                             }()};
+
+        template <typename FP>
+        constexpr void checkFormat()
+        {
+            static_assert(FP::total_bits <= 32, "FixedPointMath supports formats of up to 32 bits");
+            static_assert(FP::fraction_bits <= 30, "FixedPointMath supports up to 30 fraction bits");
+        }
+
+        template <typename FP>
+        constexpr Q32 toQ32(FP x)
+        {
+            return static_cast<Q32>(x.raw()) << (32 - FP::fraction_bits);
+        }
+
+        // rounds to the nearest value of the format and saturates
+        template <typename FP>
+        constexpr FP fromQ32(Q32 value)
+        {
+            constexpr int shift{32 - FP::fraction_bits};
+            constexpr Q32 half{Q32{1} << (shift - 1)};
+            Q32 raw{(value + half - (value < 0)) >> shift};
+            raw = raw > FP::max().raw() ? FP::max().raw() : raw;
+            raw = raw < FP::min().raw() ? FP::min().raw() : raw;
+            return FP::fromRaw(static_cast<typename FP::Raw>(raw));
+        }
+
+        // -x if mask is all ones, x if mask is 0 (no branch)
+        constexpr Q32 negateIf(Q32 x, Q32 mask)
+        {
+            return (x ^ mask) - mask;
+        }
+
+        // CORDIC in rotation mode for |angle| <= pi / 2: returns {cos, sin}
+        // each iteration adds about one correct bit, so formats with fewer fraction bits can stop earlier
+        constexpr std::pair<Q32, Q32> cordic(Q32 angle, int iterations)
+        {
+            Q32 x{cordic_gain};
+            Q32 y{0};
+            for (int i{0}; i < iterations; ++i)
+            {
+                // rotate toward the remaining angle: by +atan(2^-i) if it's positive, -atan(2^-i) otherwise
+                Q32 direction{angle >> 63}; // 0 or -1
+                Q32 dx{negateIf(y >> i, direction)};
+                Q32 dy{negateIf(x >> i, direction)};
+                x -= dx;
+                y += dy;
+                angle -= negateIf(cordic_angles[static_cast<std::size_t>(i)], direction);
+            }
+            return {x, y};
+        }
+    }
+
+    // correctly rounded square root: integer Newton iterations from a table guess
+    template <typename FP>
+    constexpr FP sqrt(FP x)
+    {
+        Detail::checkFormat<FP>();
+        if (x.raw() <= 0)
+            return FP{0};
+        // sqrt(raw / 2^F) * 2^F = sqrt(raw * 2^F)
+        const std::uint64_t n{static_cast<std::uint64_t>(x.raw()) << FP::fraction_bits};
+        // n = top * 4^half_shift with top in [0, 256): sqrt(n) <= sqrt(top + 1) * 2^half_shift
+        const int bits{static_cast<int>(std::bit_width(n))};
+        const int half_shift{bits > 8 ? (bits - 7) / 2 : 0};
+        const std::uint64_t top{n >> (2 * half_shift)};
+        std::uint64_t root{((Detail::sqrt_guesses[top] << half_shift) + 15) >> 4};
+
+        // Newton's method from above: decreases until it reaches floor(sqrt(n)), the guess is good to 8 bits so this takes 2 or 3 steps
+        while (true)
+        {
+            std::uint64_t next{(root + n / root) / 2};
+            if (next >= root)
+                break;
+            root = next;
+        }
+        if (n - root * root > root) // round to nearest: sqrt(n) >= root + 0.5
+            ++root;
+        return FP::fromRaw(static_cast<typename FP::Raw>(root));
+    }
+
+    // exp(x) = 2^k * exp(r) with x = k * ln2 + r and 0 <= r < ln2, exp(r) with its Taylor polynomial
+    template <typename FP>
+    constexpr FP exp(FP x)
+    {
+        using namespace Detail;
+        checkFormat<FP>();
+        const Q32 value{toQ32(x)};
+        const int k{static_cast<int>((static_cast<int128>(value) * inv_ln2) >> 64)}; // floor(x / ln2)
+        if (k >= FP::integer_bits - 1)
+            return FP::max();
+        if (k < -FP::fraction_bits - 2)
+            return FP{0};
+
+        Q32 r{value - static_cast<Q32>((k * ln2_q64) >> 32)};
+        r = r < 0 ? 0 : r;
+        // Horner: 1 + r(1 + r/2(1 + r/3(1 + ...))), r^13 / 13! is below 2^-32
+        Q32 result{q32_one};
+        for (std::size_t n{12}; n >= 1; --n)
+            result = q32_one + mulQ32(mulQ32(result, r), reciprocals[n]);
+
+        if (k >= 0)
+            return fromQ32<FP>(result << k);
+        return fromQ32<FP>(result >> -k);
+    }
+
+    // log(x) = e * ln2 + log(m) with x = m * 2^e and m in [1, 2),
+    // log(m) = log(m * c) - log(c) with c from a 64 entry table so that t = m * c - 1 is tiny (|t| < 1/128),
+    // and log(1 + t) = t - t^2/2 + t^3/3 - t^4/4 + t^5/5 (the next term is below 2^-40)
+    template <typename FP>
+    constexpr FP log(FP x)
+    {
+        using namespace Detail;
+        checkFormat<FP>();
+        if (x.raw() <= 0)
+            return FP::min();
+
+        const auto raw{static_cast<std::uint64_t>(x.raw())};
+        const int top_bit{static_cast<int>(std::bit_width(raw)) - 1};
+        const int exponent{top_bit - FP::fraction_bits};
+        const Q32 m{static_cast<Q32>(raw << (32 - top_bit))}; // in [1, 2)
+
+        const auto index{static_cast<std::size_t>((m - q32_one) >> (32 - log_table_bits))};
+        const Q32 t{mulQ32(m, log_reciprocals[index]) - q32_one};
+        Q32 series{reciprocals[5]};
+        series = reciprocals[4] - mulQ32(t, series);
+        series = reciprocals[3] - mulQ32(t, series);
+        series = reciprocals[2] - mulQ32(t, series);
+        series = q32_one - mulQ32(t, series);
+
+        return fromQ32<FP>(exponent * ln2 + log_offsets[index] + mulQ32(t, series));
+    }
+
+    // {cos(x), sin(x)} in one CORDIC pass
+    template <typename FP>
+    constexpr std::pair<FP, FP> cosSin(FP x)
+    {
+        using namespace Detail;
+        checkFormat<FP>();
+        // bring the angle into [-pi, pi], then into [-pi/2, pi/2] where CORDIC converges
+        Q32 angle{toQ32(x) % two_pi};
+        if (angle > pi)
+            angle -= two_pi;
+        else if (angle < -pi)
+            angle += two_pi;
+
+        bool negate_cos{false};
+        if (angle > half_pi)
+        {
+            angle = pi - angle; // sin(pi - a) = sin(a), cos(pi - a) = -cos(a)
+            negate_cos = true;
+        }
+        else if (angle < -half_pi)
+        {
+            angle = -pi - angle;
+            negate_cos = true;
+        }
+
+        constexpr int iterations{FP::fraction_bits + 4 < cordic_iterations ? FP::fraction_bits + 4 : cordic_iterations};
+        auto [c, s]{cordic(angle, iterations)};
+        return {fromQ32<FP>(negate_cos ? -c : c), fromQ32<FP>(s)};
+    }
+
+    template <typename FP>
+    constexpr FP sin(FP x) { return cosSin(x).second; }
+
+    template <typename FP>
+    constexpr FP cos(FP x) { return cosSin(x).first; }
+
+    // Batch versions: one call for a whole array. The loops have no data dependent branches in their hot parts
+    // (CORDIC picks its rotation direction with masks), so the compiler is free to unroll and vectorize them.
+    template <typename FP>
+    void sqrtBatch(std::span<const FP> in, std::span<FP> out)
+    {
+        assert(in.size() <= out.size());
+        for (std::size_t i{0}; i < in.size(); ++i)
+            out[i] = sqrt(in[i]);
+    }
+
+    template <typename FP>
+    void expBatch(std::span<const FP> in, std::span<FP> out)
+    {
+        assert(in.size() <= out.size());
+        for (std::size_t i{0}; i < in.size(); ++i)
+            out[i] = exp(in[i]);
+    }
+
+    template <typename FP>
+    void logBatch(std::span<const FP> in, std::span<FP> out)
+    {
+        assert(in.size() <= out.size());
+        for (std::size_t i{0}; i < in.size(); ++i)
+            out[i] = log(in[i]);
+    }
+
+    template <typename FP>
+    void cosSinBatch(std::span<const FP> in, std::span<FP> cos_out, std::span<FP> sin_out)
+    {
+        assert(in.size() <= cos_out.size() && in.size() <= sin_out.size());
+        for (std::size_t i{0}; i < in.size(); ++i)
+        {
+            auto [c, s]{cosSin(in[i])};
+            cos_out[i] = c;
+            sin_out[i] = s;
+        }
+    }
+}
+
+#endif
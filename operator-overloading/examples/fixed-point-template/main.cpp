@@ -0,0 +1,271 @@
+#include "fixed_point.h"
+#include "fixed_point_math.h"
+#include "timer.h"
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+
+/*
+    * Fixed-point numbers as a class template
+    * Non-type template parameters to choose the format
+    * Policies (rounding, overflow) as template parameters
+    * constexpr arithmetic
+    * Batch kernels
+    * Math functions with integers only (CORDIC, polynomials, lookup tables)
+*/
+
+/*
+The FixedPoint2 class of the fixed-point-float example stores its value in two members (an int16_t and an int8_t) and adds two values by converting
+both of them to double, adding the doubles and rounding the result back. It works, but every addition pays two conversions and a std::round().
+
+A binary fixed-point number is just an integer with an implied scale: with 16 fraction bits, the integer 98304 means 98304 / 2^16 = 1.5.
+Storing the whole value in one integer makes the arithmetic plain integer arithmetic:
+    a + b is raw_a + raw_b (both have the same scale)
+    a * b is (raw_a * raw_b) >> FracBits (the product has twice the fraction bits, computed in an integer twice as wide)
+    a / b is (raw_a << FracBits) / raw_b
+Only the extra bits that must be dropped (rounding) and the results that don't fit (overflow) need a decision, and different programs want different
+decisions. Instead of picking one, FixedPoint takes them as template arguments (Rounding and Overflow): the choice is made at compile time with
+if constexpr, so the unused branch costs nothing.
+
+The format itself (integer bits, fraction bits) is given with non-type template parameters, so FixedPoint<16, 16> and FixedPoint<8, 8> are two
+different types: mixing them by accident is a compile error. The storage type is picked from the total number of bits with std::conditional_t.
+Because every operation is constexpr, constants like FixedPoint<16, 16>{1.5} * 2 can be computed by the compiler (see the static_asserts below).
+
+The batch kernels (addBatch, multiplyBatch, scaleBatch, dotProduct) are simple loops over std::span. FixedPoint is a single integer and all its operators are
+inline, so the compiler vectorizes these loops like it would vectorize a loop over int.
+Saturation needs 64-bit min/max and a product needs a 32 x 32 -> 64 bit multiply: plain SSE2 has neither, so build with -O3 -march=native (AVX2 or better)
+to get the fast versions. With only SSE2, double is still faster for these loops.
+
+Converting back to double for every std::sqrt() or std::sin() would throw all of that away, so fixed_point_math.h implements them with integers:
+    sqrt: a first guess from a small table (the 8 highest bits), then 2 or 3 integer Newton steps (exact, then rounded)
+    exp:  exp(x) = 2^k * exp(r), where 2^k is a shift and exp(r) a short polynomial because r is small (range reduction)
+    log:  log(x) = e * ln(2) + log(m), where e is the position of the highest bit (std::bit_width) and log(m) a short series
+    sin/cos: CORDIC rotates the vector (1, 0) by a sequence of angles atan(2^-i) (a small lookup table computed at compile time), each rotation
+             only needs shifts and additions
+Precision and speed are both measured below against <cmath>. On a desktop CPU <cmath> still wins (sqrt and the polynomials run on the FPU, which is
+very fast): the integer versions are for targets without an FPU, or for code that needs bit-identical results on every machine.
+*/
+
+// constants are computed at compile time
+static_assert(Q16_16{1.5} * 2 == Q16_16{3});
+static_assert(Q16_16{1} / 4 == Q16_16{0.25});
+static_assert(sizeof(Q8_8) == 2 && sizeof(Q16_16) == 4 && sizeof(Q32_32) == 8);
+static_assert(sizeof(FixedPointFor<1000, 10>) == 4);           // 11 integer bits + 10 fraction bits fit in an int32_t
+static_assert(FixedPointFor<100, 8>::integer_bits == 8);       // 100 needs 7 bits + the sign bit
+
+// largest error (in steps of 1/2^F) of a fixed-point function against its <cmath> version, over count inputs in [low, high]
+template <typename FP>
+double maxErrorSteps(const std::function<FP(FP)> &fixed, const std::function<double(double)> &exact, double low, double high, int count)
+{
+    double max_error{};
+    for (int i{0}; i < count; ++i)
+    {
+        FP x{low + (high - low) * i / (count - 1)};
+        double expected{exact(static_cast<double>(x))};
+        // results that don't fit in the format are expected to saturate
+        expected = std::clamp(expected, static_cast<double>(FP::min()), static_cast<double>(FP::max()));
+        double error{std::abs(static_cast<double>(fixed(x)) - expected) / static_cast<double>(FP::epsilon())};
+        max_error = std::max(max_error, error);
+    }
+    return max_error;
+}
+
+// millions of results per second for a fixed-point batch function and for the same <cmath> function on doubles
+template <typename FP, typename FixedBatch, typename DoubleFunction>
+void compareThroughput(const char *name, const std::vector<FP> &inputs, FixedBatch fixed_batch, DoubleFunction function)
+{
+    constexpr int repeat{20};
+    std::vector<FP> fixed_out(inputs.size());
+    std::vector<double> double_in(inputs.size()), double_out(inputs.size());
+    for (std::size_t i{0}; i < inputs.size(); ++i)
+        double_in[i] = static_cast<double>(inputs[i]);
+
+    Timer timer{};
+    for (int r{0}; r < repeat; ++r)
+        fixed_batch(std::span<const FP>{inputs}, std::span<FP>{fixed_out});
+    double fixed_time{timer.elapsed()};
+
+    timer.reset();
+    for (int r{0}; r < repeat; ++r)
+    {
+        for (std::size_t i{0}; i < double_in.size(); ++i)
+            double_out[i] = function(double_in[i]);
+    }
+    double double_time{timer.elapsed()};
+
+    // keep the results alive so the loops can't be removed
+    double checksum{};
+    for (std::size_t i{0}; i < inputs.size(); ++i)
+        checksum += double_out[i] - static_cast<double>(fixed_out[i]);
+
+    const double results{static_cast<double>(inputs.size()) * repeat / 1e6};
+    std::cout << name << "\tfixed: " << results / fixed_time << " M/s\t<cmath>: " << results / double_time << " M/s\t(checksum " << checksum << ")\n";
+}
+
+int main()
+{
+    /* The tests of the FixedPoint2 example, with a binary format */
+    using Fixed = FixedPoint<16, 16>;
+    assert(Fixed{0.75} == Fixed{0.75});
+    assert(!(Fixed{0.75} == Fixed{0.76}));
+    assert(Fixed{0.75} + Fixed{1.50} == Fixed{2.25});
+    assert(Fixed{-0.75} + Fixed{-1.50} == Fixed{-2.25});
+    assert(Fixed{0.75} + Fixed{-1.50} == Fixed{-0.75});
+    assert(Fixed{-0.75} + Fixed{1.50} == Fixed{0.75});
+    std::cout << Fixed{0.75} << " + " << Fixed{1.23} << " = " << Fixed{0.75} + Fixed{1.23} << '\n';
+
+    /* Rounding policies */
+    using Truncated = FixedPoint<8, 4, Rounding::truncate>;
+    using Rounded = FixedPoint<8, 4, Rounding::nearest>;
+    // 1/3 is 5.33 steps of 1/16: both policies give 5/16 = 0.3125
+    std::cout << "1/3 truncated: " << Truncated{1} / Truncated{3} << ", rounded: " << Rounded{1} / Rounded{3} << '\n';
+    // 2/3: 10/16 when truncated, 11/16 when rounded
+    assert(Truncated{2} / Truncated{3} == Truncated::fromRaw(10));
+    assert(Rounded{2} / Rounded{3} == Rounded::fromRaw(11));
+    assert(Truncated{-2} / Truncated{3} == Truncated::fromRaw(-10)); // toward zero
+    assert(Rounded{-2} / Rounded{3} == Rounded::fromRaw(-11));
+    assert(Truncated{-1.5} * Truncated{0.25} == Truncated::fromRaw(-6)); // -0.375 = -6/16 exactly
+    assert(Rounded{-0.0625} * Rounded{0.5} == Rounded::fromRaw(-1));     // -1/32 is halfway: away from zero
+    assert(Truncated{-0.0625} * Truncated{0.5} == Truncated{0});
+
+    /* Overflow policies */
+    using Saturated = FixedPoint<8, 8, Rounding::nearest, Overflow::saturate>;
+    using Wrapped = FixedPoint<8, 8, Rounding::nearest, Overflow::wrap>;
+    assert(Saturated{100} + Saturated{100} == Saturated::max()); // clamped to 127.99609375
+    assert(Wrapped{100} + Wrapped{100} == Wrapped{-56});          // 200 - 256
+    // from an int that doesn't fit: 10'000'000 * 256 doesn't even fit in the int32_t that Q8_8 computes in
+    assert(Saturated{10'000'000} == Saturated::max() && Saturated{-10'000'000} == Saturated::min());
+    assert(Wrapped{300} == Wrapped{44}); // 300 - 256
+    static_assert(Q8_8{10'000'000} == Q8_8::max());
+    std::cout << "100 + 100 saturated: " << Saturated{100} + Saturated{100} << ", wrapped: " << Wrapped{100} + Wrapped{100} << '\n';
+
+    /* 64-bit format: products are computed in 128 bits */
+    assert(Q32_32{1'000'000} * Q32_32{0.5} == Q32_32{500'000});
+    assert(Q32_32{100'000} * Q32_32{100'000} == Q32_32::max()); // 10^10 doesn't fit in 32 integer bits
+
+    /* Batch kernels vs double */
+    constexpr std::size_t count{1 << 16};
+    constexpr int repeat{2000};
+    std::mt19937 mt{7};
+    std::uniform_real_distribution values{-100.0, 100.0};
+
+    std::vector<double> da(count), db(count), dout(count);
+    std::vector<Fixed> fa(count), fb(count), fout(count);
+    for (std::size_t i{0}; i < count; ++i)
+    {
+        da[i] = values(mt);
+        db[i] = values(mt);
+        fa[i] = Fixed{da[i]};
+        fb[i] = Fixed{db[i]};
+    }
+
+    // each pass reads the results of the previous one (ping-pong between two buffers),
+    // so the compiler can't skip the repeated passes
+    std::vector<double> dnext(count);
+    std::vector<Fixed> fnext(count);
+    dout = db;
+    fout = fb;
+    Timer timer{};
+    for (int r{0}; r < repeat; ++r)
+    {
+        for (std::size_t i{0}; i < count; ++i)
+            dnext[i] = da[i] + dout[i];
+        std::swap(dout, dnext);
+    }
+    double double_add{timer.elapsed()};
+
+    timer.reset();
+    for (int r{0}; r < repeat; ++r)
+    {
+        addBatch<Fixed>(fa, fout, fnext);
+        std::swap(fout, fnext);
+    }
+    double fixed_add{timer.elapsed()};
+
+    timer.reset();
+    for (int r{0}; r < repeat; ++r)
+    {
+        for (std::size_t i{0}; i < count; ++i)
+            dnext[i] = dout[i] * 0.5 + 1.25;
+        std::swap(dout, dnext);
+    }
+    double double_scale{timer.elapsed()};
+
+    timer.reset();
+    for (int r{0}; r < repeat; ++r)
+    {
+        scaleBatch<Fixed>(fout, Fixed{0.5}, Fixed{1.25}, fnext);
+        std::swap(fout, fnext);
+    }
+    double fixed_scale{timer.elapsed()};
+
+    // the batch kernels give the same results as the scalar operators
+    std::vector<Fixed> batch(count);
+    multiplyBatch<Fixed>(fa, fb, batch);
+    for (std::size_t i{0}; i < count; ++i)
+        assert(batch[i] == fa[i] * fb[i]);
+
+    const std::vector<Fixed> x{1, 2, 3}, y{Fixed{0.5}, Fixed{0.25}, Fixed{-1.0}};
+    assert(dotProduct<Fixed>(x, y) == Fixed{-2.0});
+
+    // use the double results so the compiler can't drop the loops
+    double checksum{};
+    for (std::size_t i{0}; i < count; ++i)
+        checksum += dout[i] - static_cast<double>(fout[i]);
+    std::cout << "difference between double and fixed-point results: " << checksum / count << '\n';
+
+    const double elements{static_cast<double>(count) * repeat / 1e6};
+    std::cout << "add    double: " << elements / double_add << " M/s, FixedPoint<16, 16>: " << elements / fixed_add << " M/s\n";
+    std::cout << "a*x+b  double: " << elements / double_scale << " M/s, FixedPoint<16, 16>: " << elements / fixed_scale << " M/s\n";
+
+    /* Math functions */
+    static_assert(FixedPointMath::sqrt(Fixed{4}) == Fixed{2}); // also constexpr
+    std::cout << "sqrt(2) = " << FixedPointMath::sqrt(Fixed{2}) << ", exp(1) = " << FixedPointMath::exp(Fixed{1})
+              << ", log(10) = " << FixedPointMath::log(Fixed{10}) << ", sin(pi/6) = " << FixedPointMath::sin(Fixed{0.5235987756}) << '\n';
+
+    // sqrt is correctly rounded: checked on every input of a 24-bit format (2^23 values); the sampled error below is for Fixed
+    using Q12_12 = FixedPoint<12, 12>;
+    for (std::int32_t raw{0}; raw < (std::int32_t{1} << 23); ++raw)
+        assert(FixedPointMath::sqrt(Q12_12::fromRaw(raw)).raw() == std::llround(std::sqrt(static_cast<double>(raw) * 4096.0)));
+
+    constexpr int samples{200'000};
+    std::cout << "max error in steps of 1/65536:\n";
+    std::cout << "sqrt\t" << maxErrorSteps<Fixed>(FixedPointMath::sqrt<Fixed>, [](double v)
+                                                   { return std::sqrt(v); }, 0.0, 32767.0, samples)
+              << '\n';
+    std::cout << "exp\t" << maxErrorSteps<Fixed>(FixedPointMath::exp<Fixed>, [](double v)
+                                                  { return std::exp(v); }, -12.0, 11.0, samples)
+              << '\n';
+    std::cout << "log\t" << maxErrorSteps<Fixed>(FixedPointMath::log<Fixed>, [](double v)
+                                                  { return std::log(v); }, 0.0001, 32767.0, samples)
+              << '\n';
+    std::cout << "sin\t" << maxErrorSteps<Fixed>(FixedPointMath::sin<Fixed>, [](double v)
+                                                  { return std::sin(v); }, -1000.0, 1000.0, samples)
+              << '\n';
+    std::cout << "cos\t" << maxErrorSteps<Fixed>(FixedPointMath::cos<Fixed>, [](double v)
+                                                  { return std::cos(v); }, -1000.0, 1000.0, samples)
+              << '\n';
+
+    std::vector<Fixed> positive(count), angles(count);
+    for (std::size_t i{0}; i < count; ++i)
+    {
+        positive[i] = Fixed{std::abs(da[i]) + 0.001};
+        angles[i] = Fixed{da[i] / 10};
+    }
+    compareThroughput("sqrt", positive, FixedPointMath::sqrtBatch<Fixed>, [](double v)
+                      { return std::sqrt(v); });
+    compareThroughput("exp", angles, FixedPointMath::expBatch<Fixed>, [](double v)
+                      { return std::exp(v); });
+    compareThroughput("log", positive, FixedPointMath::logBatch<Fixed>, [](double v)
+                      { return std::log(v); });
+    std::vector<Fixed> sines(count);
+    compareThroughput("cos+sin", angles, [&sines](std::span<const Fixed> in, std::span<Fixed> out)
+                      { FixedPointMath::cosSinBatch<Fixed>(in, out, sines); }, [](double v)
+                      { return std::cos(v) + std::sin(v); });
+
+    return 0;
+}
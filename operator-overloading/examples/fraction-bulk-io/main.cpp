@@ -0,0 +1,335 @@
+#include "timer.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <charconv>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <numeric>
+#include <random>
+#include <cassert>
+#include <sys/mman.h> // POSIX only: mmap()/munmap()
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+    * Bulk text parsing with std::from_chars
+    * Bulk text formatting with std::to_chars
+    * Memory-mapped input files
+*/
+
+/*
+operator>> is perfect for reading a couple of fractions from the console, but it is a poor fit for files holding millions of "a/b" records:
+every call goes through the stream machinery (sentry, locale, virtual calls into the streambuf), and the in.ignore() after each record scans the line
+a second time.
+C++17 added std::from_chars and std::to_chars (in <charconv>). They are the lowest level number conversions the standard library offers:
+    They never allocate, never throw and never look at the locale.
+    They work on a [first, last) range of chars and report where they stopped (ptr) and whether they failed (ec).
+So the fast way to read a big file is to get all of its bytes in memory in one go, and then walk over them with from_chars.
+
+A memory-mapped file (mmap() on POSIX systems) makes the file itself look like an array of chars: the kernel pages it in on demand, so we don't even
+need to copy it into a buffer first. The mapping is a resource, so it is wrapped into a RAII class (MappedFile) like any other resource.
+
+For the other direction, to_chars writes the digits into a buffer we own. Reusing one growing buffer (FractionWriter) means we only pay for
+allocations while the buffer grows, and we write the whole text out with a single call.
+Skipping to the end of a line is done with std::memchr: the C library implements it with vector instructions (16/32 bytes per step), so we don't
+have to write SIMD code ourselves to scan for the '\n' delimiters.
+*/
+
+class Fraction
+{
+private:
+    int m_numerator{};
+    int m_denominator{1};
+
+public:
+    Fraction() = default;
+    Fraction(int numerator, int denominator = 1)
+        : m_numerator{numerator},
+          m_denominator{denominator}
+    {
+        reduce();
+    }
+
+    int getNumerator() const { return m_numerator; }
+    int getDenominator() const { return m_denominator; }
+
+    void reduce()
+    {
+        int gcd{std::gcd(m_numerator, m_denominator)};
+        if (gcd)
+        {
+            m_numerator /= gcd;
+            m_denominator /= gcd;
+        }
+    }
+
+    friend std::ostream &operator<<(std::ostream &out, const Fraction &f);
+    friend std::istream &operator>>(std::istream &in, Fraction &f);
+
+    friend bool operator==(const Fraction &f1, const Fraction &f2) { return f1.m_numerator == f2.m_numerator && f1.m_denominator == f2.m_denominator; }
+    friend bool operator!=(const Fraction &f1, const Fraction &f2) { return !(f1 == f2); }
+};
+
+std::ostream &operator<<(std::ostream &out, const Fraction &f)
+{
+    out << f.m_numerator << '/' << f.m_denominator;
+    return out;
+}
+
+std::istream &operator>>(std::istream &in, Fraction &f)
+{
+    char ignore{};
+    in >> f.m_numerator >> ignore >> f.m_denominator;
+    in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    f.reduce();
+    return in;
+}
+
+// RAII wrapper around a read-only memory mapping of a whole file
+class MappedFile
+{
+private:
+    const char *m_data{};
+    std::size_t m_size{};
+
+public:
+    explicit MappedFile(const std::string &path)
+    {
+        int fd{::open(path.c_str(), O_RDONLY)};
+        if (fd < 0)
+            throw std::runtime_error{"MappedFile: can't open " + path};
+
+        struct stat info{};
+        if (::fstat(fd, &info) < 0)
+        {
+            ::close(fd);
+            throw std::runtime_error{"MappedFile: can't stat " + path};
+        }
+        m_size = static_cast<std::size_t>(info.st_size);
+        if (m_size)
+        {
+            void *addr{::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0)};
+            if (addr == MAP_FAILED)
+            {
+                ::close(fd);
+                throw std::runtime_error{"MappedFile: can't map " + path};
+            }
+            ::madvise(addr, m_size, MADV_SEQUENTIAL); // we read it front to back: ask the kernel to read ahead
+            m_data = static_cast<const char *>(addr);
+        }
+        ::close(fd); // the mapping stays valid after the descriptor is closed
+    }
+
+    // a mapping can't be shared by two owners
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile()
+    {
+        if (m_data)
+            ::munmap(const_cast<char *>(m_data), m_size);
+    }
+
+    std::string_view view() const { return {m_data, m_size}; }
+};
+
+struct FractionParseResult
+{
+    std::size_t count{};     // number of fractions appended to the output
+    const char *ptr{};       // where the parser stopped
+    std::errc ec{std::errc{}}; // std::errc{} on success, like std::from_chars
+};
+
+// Parses every "a/b" record of text (one per line) and appends them to out.
+// Like operator>>, anything following the denominator on the same line is ignored.
+FractionParseResult parseFractions(std::string_view text, std::vector<Fraction> &out)
+{
+    const char *first{text.data()};
+    const char *const last{text.data() + text.size()};
+    std::size_t count{};
+
+    while (true)
+    {
+        // skip blank lines and leading spaces
+        while (first != last && (*first == '\n' || *first == '\r' || *first == ' ' || *first == '\t'))
+            ++first;
+        if (first == last)
+            break;
+
+        int numerator{};
+        int denominator{};
+        auto [num_end, num_ec]{std::from_chars(first, last, numerator)};
+        if (num_ec != std::errc{})
+            return {count, first, num_ec};
+        if (num_end == last || *num_end != '/')
+            return {count, num_end, std::errc::invalid_argument};
+
+        auto [den_end, den_ec]{std::from_chars(num_end + 1, last, denominator)};
+        if (den_ec != std::errc{})
+            return {count, num_end + 1, den_ec};
+
+        out.emplace_back(numerator, denominator);
+        ++count;
+
+        // common case: the record ends right after the denominator
+        first = den_end;
+        if (first != last && *first == '\n')
+        {
+            ++first;
+            continue;
+        }
+        // otherwise ignore the rest of the line (vectorized scan)
+        const void *eol{std::memchr(first, '\n', static_cast<std::size_t>(last - first))};
+        first = eol ? static_cast<const char *>(eol) + 1 : last;
+    }
+    return {count, first, std::errc{}};
+}
+
+// Formats fractions into a reusable buffer: call clear() between batches to keep the memory
+class FractionWriter
+{
+private:
+    std::vector<char> m_buffer{};
+    std::size_t m_used{};
+
+    // longest record: "-2147483648/-2147483648\n"
+    static constexpr std::size_t max_record_size{24};
+
+    void ensureRoom(std::size_t bytes)
+    {
+        if (m_used + bytes > m_buffer.size())
+            m_buffer.resize(std::max(m_buffer.size() * 2, m_used + bytes));
+    }
+
+public:
+    FractionWriter() = default;
+    explicit FractionWriter(std::size_t capacity) : m_buffer(capacity) {}
+
+    FractionWriter &operator<<(const Fraction &f)
+    {
+        ensureRoom(max_record_size);
+        char *first{m_buffer.data() + m_used};
+        char *const last{m_buffer.data() + m_buffer.size()};
+
+        first = std::to_chars(first, last, f.getNumerator()).ptr;
+        *first++ = '/';
+        first = std::to_chars(first, last, f.getDenominator()).ptr;
+        *first++ = '\n';
+
+        m_used = static_cast<std::size_t>(first - m_buffer.data());
+        return *this;
+    }
+
+    void clear() { m_used = 0; } // keeps the capacity
+    std::size_t capacity() const { return m_buffer.size(); }
+    std::string_view view() const { return {m_buffer.data(), m_used}; }
+};
+
+std::vector<Fraction> makeRandomFractions(std::size_t count)
+{
+    std::mt19937 mt{42};
+    std::uniform_int_distribution numerators{-1'000'000, 1'000'000};
+    std::uniform_int_distribution denominators{1, 1'000'000};
+
+    std::vector<Fraction> fractions{};
+    fractions.reserve(count);
+    for (std::size_t i{0}; i < count; ++i)
+        fractions.emplace_back(numerators(mt), denominators(mt));
+    return fractions;
+}
+
+double megabytesPerSecond(std::size_t bytes, double seconds)
+{
+    return static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds;
+}
+
+int main()
+{
+    /* from_chars on a small in-memory text */
+    std::vector<Fraction> small{};
+    auto result{parseFractions("1/2\n  6/8 trailing comment\n\n-3/9\n", small)};
+    assert(result.ec == std::errc{});
+    assert(result.count == 3);
+    assert(small[0] == Fraction(1, 2));
+    assert(small[1] == Fraction(3, 4)); // reduced, like operator>>
+    assert(small[2] == Fraction(-1, 3));
+
+    // errors are reported the same way from_chars reports them
+    std::vector<Fraction> broken{};
+    std::string_view bad_text{"1/2\n3x4\n"};
+    result = parseFractions(bad_text, broken);
+    assert(result.ec == std::errc::invalid_argument);
+    assert(result.count == 1);
+    std::cout << "parse error at offset " << result.ptr - bad_text.data() << '\n';
+
+    /* to_chars into a reusable buffer */
+    FractionWriter writer{};
+    writer << Fraction{1, 2} << Fraction{-6, 8};
+    assert(writer.view() == "1/2\n-3/4\n");
+    writer.clear(); // memory is kept for the next batch
+
+    /* Benchmark: write a big file, map it and parse it back */
+    constexpr std::size_t count{2'000'000};
+    const std::vector<Fraction> fractions{makeRandomFractions(count)};
+
+    Timer timer{};
+    for (const auto &f : fractions)
+        writer << f;
+    double format_time{timer.elapsed()};
+
+    std::ostringstream stream_out{};
+    timer.reset();
+    for (const auto &f : fractions)
+        stream_out << f << '\n';
+    double stream_format_time{timer.elapsed()};
+    assert(stream_out.view() == writer.view());
+
+    const std::string path{"fractions.txt"};
+    {
+        std::ofstream file{path, std::ios::binary};
+        file.write(writer.view().data(), static_cast<std::streamsize>(writer.view().size()));
+    }
+
+    std::vector<Fraction> parsed{};
+    parsed.reserve(count);
+    double parse_time{};
+    std::size_t bytes{};
+    {
+        MappedFile mapped{path};
+        bytes = mapped.view().size();
+        timer.reset();
+        result = parseFractions(mapped.view(), parsed);
+        parse_time = timer.elapsed();
+    }
+    assert(result.ec == std::errc{});
+    assert(parsed == fractions);
+
+    std::vector<Fraction> streamed{};
+    streamed.reserve(count);
+    {
+        std::ifstream file{path};
+        timer.reset();
+        Fraction f{};
+        while (file >> f)
+            streamed.push_back(f);
+    }
+    double stream_parse_time{timer.elapsed()};
+    assert(streamed == fractions);
+    std::remove(path.c_str());
+
+    std::cout << count << " fractions, " << bytes / (1024 * 1024) << " MB\n";
+    std::cout << "format  to_chars:   " << megabytesPerSecond(bytes, format_time) << " MB/s\n";
+    std::cout << "format  operator<<: " << megabytesPerSecond(bytes, stream_format_time) << " MB/s\n";
+    std::cout << "parse   from_chars: " << megabytesPerSecond(bytes, parse_time) << " MB/s\n";
+    std::cout << "parse   operator>>: " << megabytesPerSecond(bytes, stream_parse_time) << " MB/s\n";
+
+    return 0;
+}
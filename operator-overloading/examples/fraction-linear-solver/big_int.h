@@ -0,0 +1,335 @@
+#ifndef BIG_INT_H
+#define BIG_INT_H
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// A minimal arbitrary precision integer: just enough for exact linear algebra.
+// The magnitude is stored as base 2^32 limbs (least significant first) next to a sign flag.
+// The value 0 always has no limbs and a positive sign.
+class BigInt
+{
+private:
+    using Limb = std::uint32_t;
+    using Wide = std::uint64_t;
+
+    std::vector<Limb> m_limbs{};
+    bool m_negative{false};
+
+    void trim()
+    {
+        while (!m_limbs.empty() && m_limbs.back() == 0)
+            m_limbs.pop_back();
+        if (m_limbs.empty())
+            m_negative = false;
+    }
+
+    // -1, 0 or 1 depending on |a| compared to |b|
+    static int compareMagnitude(const std::vector<Limb> &a, const std::vector<Limb> &b)
+    {
+        if (a.size() != b.size())
+            return a.size() < b.size() ? -1 : 1;
+        for (std::size_t i{a.size()}; i-- > 0;)
+        {
+            if (a[i] != b[i])
+                return a[i] < b[i] ? -1 : 1;
+        }
+        return 0;
+    }
+
+    static std::vector<Limb> addMagnitude(const std::vector<Limb> &a, const std::vector<Limb> &b)
+    {
+        const std::vector<Limb> &longer{a.size() >= b.size() ? a : b};
+        const std::vector<Limb> &shorter{a.size() >= b.size() ? b : a};
+        std::vector<Limb> result(longer.size() + 1);
+        Wide carry{};
+        for (std::size_t i{0}; i < longer.size(); ++i)
+        {
+            Wide sum{carry + longer[i] + (i < shorter.size() ? shorter[i] : 0)};
+            result[i] = static_cast<Limb>(sum);
+            carry = sum >> 32;
+        }
+        result.back() = static_cast<Limb>(carry);
+        return result;
+    }
+
+    // |a| - |b|, requires |a| >= |b|
+    static std::vector<Limb> subMagnitude(const std::vector<Limb> &a, const std::vector<Limb> &b)
+    {
+        std::vector<Limb> result(a.size());
+        Limb borrow{};
+        for (std::size_t i{0}; i < a.size(); ++i)
+        {
+            Wide rhs{static_cast<Wide>(i < b.size() ? b[i] : 0) + borrow};
+            result[i] = static_cast<Limb>(a[i] - rhs);
+            borrow = a[i] < rhs;
+        }
+        return result;
+    }
+
+    // adds (or subtracts) two signed values given as magnitude + sign
+    static BigInt addSigned(const BigInt &a, const BigInt &b, bool negate_b)
+    {
+        bool b_negative{negate_b ? !b.m_negative : b.m_negative};
+        BigInt result{};
+        if (a.m_negative == b_negative)
+        {
+            result.m_limbs = addMagnitude(a.m_limbs, b.m_limbs);
+            result.m_negative = a.m_negative;
+        }
+        else if (compareMagnitude(a.m_limbs, b.m_limbs) >= 0)
+        {
+            result.m_limbs = subMagnitude(a.m_limbs, b.m_limbs);
+            result.m_negative = a.m_negative;
+        }
+        else
+        {
+            result.m_limbs = subMagnitude(b.m_limbs, a.m_limbs);
+            result.m_negative = b_negative;
+        }
+        result.trim();
+        return result;
+    }
+
+    int countTrailingZeroBits() const
+    {
+        int bits{};
+        for (Limb limb : m_limbs)
+        {
+            if (limb)
+                return bits + std::countr_zero(limb);
+            bits += 32;
+        }
+        return bits;
+    }
+
+    // divides |this| by a small value in place and returns the remainder
+    Limb divideSmall(Limb divisor)
+    {
+        Wide remainder{};
+        for (std::size_t i{m_limbs.size()}; i-- > 0;)
+        {
+            Wide current{(remainder << 32) | m_limbs[i]};
+            m_limbs[i] = static_cast<Limb>(current / divisor);
+            remainder = current % divisor;
+        }
+        trim();
+        return static_cast<Limb>(remainder);
+    }
+
+public:
+    BigInt() = default;
+    BigInt(long long value) : m_negative{value < 0}
+    {
+        // go through unsigned to handle the most negative value
+        unsigned long long magnitude{m_negative ? 0ull - static_cast<unsigned long long>(value) : static_cast<unsigned long long>(value)};
+        while (magnitude)
+        {
+            m_limbs.push_back(static_cast<Limb>(magnitude));
+            magnitude >>= 32;
+        }
+    }
+
+    bool isZero() const { return m_limbs.empty(); }
+    bool isNegative() const { return m_negative; }
+    std::size_t limbCount() const { return m_limbs.size(); }
+
+    BigInt operator-() const
+    {
+        BigInt result{*this};
+        if (!result.isZero())
+            result.m_negative = !result.m_negative;
+        return result;
+    }
+    BigInt abs() const
+    {
+        BigInt result{*this};
+        result.m_negative = false;
+        return result;
+    }
+
+    friend BigInt operator+(const BigInt &a, const BigInt &b) { return addSigned(a, b, false); }
+    friend BigInt operator-(const BigInt &a, const BigInt &b) { return addSigned(a, b, true); }
+
+    // schoolbook multiplication: O(n * m)
+    friend BigInt operator*(const BigInt &a, const BigInt &b)
+    {
+        BigInt result{};
+        if (a.isZero() || b.isZero())
+            return result;
+        result.m_limbs.assign(a.m_limbs.size() + b.m_limbs.size(), 0);
+        for (std::size_t i{0}; i < a.m_limbs.size(); ++i)
+        {
+            Wide carry{};
+            const Wide ai{a.m_limbs[i]};
+            for (std::size_t j{0}; j < b.m_limbs.size(); ++j)
+            {
+                Wide current{ai * b.m_limbs[j] + result.m_limbs[i + j] + carry};
+                result.m_limbs[i + j] = static_cast<Limb>(current);
+                carry = current >> 32;
+            }
+            result.m_limbs[i + b.m_limbs.size()] = static_cast<Limb>(carry);
+        }
+        result.m_negative = a.m_negative != b.m_negative;
+        result.trim();
+        return result;
+    }
+
+    BigInt &operator+=(const BigInt &b) { return *this = *this + b; }
+    BigInt &operator-=(const BigInt &b) { return *this = *this - b; }
+    BigInt &operator*=(const BigInt &b) { return *this = *this * b; }
+
+    friend bool operator==(const BigInt &a, const BigInt &b) { return a.m_negative == b.m_negative && a.m_limbs == b.m_limbs; }
+    friend bool operator!=(const BigInt &a, const BigInt &b) { return !(a == b); }
+
+    BigInt &operator>>=(int bits)
+    {
+        std::size_t limbs{static_cast<std::size_t>(bits / 32)};
+        int shift{bits % 32};
+        if (limbs >= m_limbs.size())
+        {
+            *this = BigInt{};
+            return *this;
+        }
+        m_limbs.erase(m_limbs.begin(), m_limbs.begin() + static_cast<std::ptrdiff_t>(limbs));
+        if (shift)
+        {
+            for (std::size_t i{0}; i < m_limbs.size(); ++i)
+            {
+                Limb high{i + 1 < m_limbs.size() ? m_limbs[i + 1] : 0};
+                m_limbs[i] = (m_limbs[i] >> shift) | (high << (32 - shift));
+            }
+        }
+        trim();
+        return *this;
+    }
+    BigInt &operator<<=(int bits)
+    {
+        if (isZero())
+            return *this;
+        std::size_t limbs{static_cast<std::size_t>(bits / 32)};
+        int shift{bits % 32};
+        if (shift)
+        {
+            m_limbs.push_back(0);
+            for (std::size_t i{m_limbs.size()}; i-- > 0;)
+            {
+                Limb low{i > 0 ? m_limbs[i - 1] : 0};
+                m_limbs[i] = (m_limbs[i] << shift) | (low >> (32 - shift));
+            }
+        }
+        m_limbs.insert(m_limbs.begin(), limbs, 0);
+        trim();
+        return *this;
+    }
+
+    // Division that is known to leave no remainder (Jebelean's exact division).
+    // It works from the least significant limb up, so it never needs to guess a quotient digit,
+    // which makes it much simpler (and faster) than general long division.
+    friend BigInt exactDivide(BigInt a, BigInt b)
+    {
+        assert(!b.isZero() && "exactDivide: division by zero");
+        bool negative{a.m_negative != b.m_negative};
+        // make the divisor odd so its lowest limb is invertible modulo 2^32
+        int zeros{b.countTrailingZeroBits()};
+        a >>= zeros;
+        b >>= zeros;
+        if (a.isZero())
+            return a;
+        if (a.m_limbs.size() < b.m_limbs.size())
+        {
+            assert(false && "exactDivide: the division is not exact");
+            return BigInt{};
+        }
+
+        // inverse of b[0] modulo 2^32 by Newton's iteration (each step doubles the correct bits)
+        Limb inverse{b.m_limbs[0]};
+        for (int i{0}; i < 4; ++i)
+            inverse *= 2 - b.m_limbs[0] * inverse;
+
+        const std::size_t quotient_size{a.m_limbs.size() - b.m_limbs.size() + 1};
+        std::vector<Limb> remainder(a.m_limbs.begin(), a.m_limbs.begin() + static_cast<std::ptrdiff_t>(quotient_size));
+        BigInt quotient{};
+        quotient.m_limbs.resize(quotient_size);
+        for (std::size_t i{0}; i < quotient_size; ++i)
+        {
+            Limb q{remainder[i] * inverse};
+            quotient.m_limbs[i] = q;
+            // remainder -= q * b << (32 * i), only the limbs that still matter for the quotient
+            Wide borrow{};
+            for (std::size_t j{0}; i + j < quotient_size; ++j)
+            {
+                Wide product{static_cast<Wide>(q) * (j < b.m_limbs.size() ? b.m_limbs[j] : 0) + borrow};
+                Limb low{static_cast<Limb>(product)};
+                borrow = (product >> 32) + (remainder[i + j] < low);
+                remainder[i + j] -= low;
+            }
+        }
+        quotient.m_negative = negative;
+        quotient.trim();
+        return quotient;
+    }
+
+    // binary gcd: only shifts and subtractions, always non negative
+    friend BigInt gcd(BigInt a, BigInt b)
+    {
+        a.m_negative = false;
+        b.m_negative = false;
+        if (a.isZero())
+            return b;
+        if (b.isZero())
+            return a;
+        int a_zeros{a.countTrailingZeroBits()};
+        int b_zeros{b.countTrailingZeroBits()};
+        int common{std::min(a_zeros, b_zeros)};
+        a >>= a_zeros;
+        while (true)
+        {
+            b >>= b.countTrailingZeroBits();
+            if (compareMagnitude(a.m_limbs, b.m_limbs) > 0)
+                std::swap(a, b);
+            b.m_limbs = subMagnitude(b.m_limbs, a.m_limbs);
+            b.trim();
+            if (b.isZero())
+                break;
+        }
+        a <<= common;
+        return a;
+    }
+
+    std::string toString() const
+    {
+        if (isZero())
+            return "0";
+        BigInt copy{*this};
+        std::string digits{};
+        while (!copy.isZero())
+        {
+            Limb chunk{copy.divideSmall(1'000'000'000)};
+            for (int i{0}; i < 9; ++i)
+            {
+                digits.push_back(static_cast<char>('0' + chunk % 10));
+                chunk /= 10;
+                if (copy.isZero() && chunk == 0)
+                    break;
+            }
+        }
+        if (m_negative)
+            digits.push_back('-');
+        std::reverse(digits.begin(), digits.end());
+        return digits;
+    }
+
+    friend std::ostream &operator<<(std::ostream &out, const BigInt &b)
+    {
+        out << b.toString();
+        return out;
+    }
+};
+
+#endif
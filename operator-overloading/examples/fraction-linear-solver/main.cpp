@@ -0,0 +1,313 @@
+#include "big_int.h"
+#include "timer.h"
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <random>
+#include <algorithm>
+#include <cassert>
+
+/*
+    * Solving linear systems exactly with rational numbers
+    * Naive Gaussian elimination over Fraction
+    * Fraction-free (Bareiss) elimination
+    * Splitting the elimination rows across threads
+*/
+
+/*
+A system A * x = b with integer (or rational) coefficients has a rational solution, so it can be solved exactly: no rounding errors at all.
+The textbook way is Gaussian elimination where every entry is a Fraction. Every step does a few multiplications, an addition and a reduce(),
+and reduce() needs a gcd. Even with the gcd, the numerators and denominators keep growing, so int quickly overflows: we need a BigInt.
+Gcd on big numbers is the expensive part, and it runs for every single entry of every single step.
+
+Bareiss' algorithm (fraction-free elimination) stays in integers. At step k every entry below and right of the pivot becomes:
+    a[i][j] = (a[k][k] * a[i][j] - a[i][k] * a[k][j]) / previous_pivot
+The division is always exact (Sylvester's identity), so there is no remainder and no fraction: each entry at step k is the determinant of a
+k x k minor of A, so its size only grows linearly with k (instead of doubling like the products of the naive version).
+At the end the last pivot D is the determinant (up to the sign of the row swaps), and back substitution gives the integers X = D * x.
+The solution is then x[i] = X[i] / D, and only those n fractions need a gcd.
+
+For a given step k, every row i > k is updated independently from the others, so the rows can be split between threads.
+Each thread only writes its own rows and reads the pivot row, so no locking is needed: we only wait (join) for all threads before the next step.
+*/
+
+// Fraction over BigInt, reduced after every operation like the int version of the Fraction example
+class Fraction
+{
+private:
+    BigInt m_numerator{};
+    BigInt m_denominator{1};
+
+public:
+    Fraction() = default;
+    Fraction(BigInt numerator, BigInt denominator = 1)
+        : m_numerator{std::move(numerator)},
+          m_denominator{std::move(denominator)}
+    {
+        reduce();
+    }
+
+    void reduce()
+    {
+        assert(!m_denominator.isZero());
+        if (m_denominator.isNegative())
+        {
+            m_numerator = -m_numerator;
+            m_denominator = -m_denominator;
+        }
+        BigInt divisor{gcd(m_numerator, m_denominator)};
+        if (divisor != BigInt{1})
+        {
+            m_numerator = exactDivide(m_numerator, divisor);
+            m_denominator = exactDivide(m_denominator, divisor);
+        }
+    }
+
+    bool isZero() const { return m_numerator.isZero(); }
+
+    friend Fraction operator+(const Fraction &f1, const Fraction &f2)
+    {
+        return {f1.m_numerator * f2.m_denominator + f2.m_numerator * f1.m_denominator, f1.m_denominator * f2.m_denominator};
+    }
+    friend Fraction operator-(const Fraction &f1, const Fraction &f2)
+    {
+        return {f1.m_numerator * f2.m_denominator - f2.m_numerator * f1.m_denominator, f1.m_denominator * f2.m_denominator};
+    }
+    friend Fraction operator*(const Fraction &f1, const Fraction &f2)
+    {
+        return {f1.m_numerator * f2.m_numerator, f1.m_denominator * f2.m_denominator};
+    }
+    friend Fraction operator/(const Fraction &f1, const Fraction &f2)
+    {
+        assert(!f2.isZero());
+        return {f1.m_numerator * f2.m_denominator, f1.m_denominator * f2.m_numerator};
+    }
+
+    friend bool operator==(const Fraction &f1, const Fraction &f2) { return f1.m_numerator == f2.m_numerator && f1.m_denominator == f2.m_denominator; }
+    friend bool operator!=(const Fraction &f1, const Fraction &f2) { return !(f1 == f2); }
+
+    friend std::ostream &operator<<(std::ostream &out, const Fraction &f)
+    {
+        out << f.m_numerator;
+        if (f.m_denominator != BigInt{1})
+            out << '/' << f.m_denominator;
+        return out;
+    }
+};
+
+// n rows of n + 1 columns: the last column holds b
+using Matrix = std::vector<std::vector<long long>>;
+
+// Textbook Gaussian elimination: every entry is a reduced Fraction.
+// Returns an empty vector if the system has no unique solution.
+std::vector<Fraction> solveNaive(const Matrix &system)
+{
+    const std::size_t n{system.size()};
+    std::vector<std::vector<Fraction>> a(n);
+    for (std::size_t i{0}; i < n; ++i)
+    {
+        for (long long value : system[i])
+            a[i].emplace_back(BigInt{value});
+    }
+
+    for (std::size_t k{0}; k < n; ++k)
+    {
+        auto pivot{std::find_if(a.begin() + static_cast<std::ptrdiff_t>(k), a.end(), [k](const auto &row)
+                                { return !row[k].isZero(); })};
+        if (pivot == a.end())
+            return {};
+        std::swap(a[k], *pivot);
+
+        for (std::size_t i{k + 1}; i < n; ++i)
+        {
+            Fraction factor{a[i][k] / a[k][k]};
+            for (std::size_t j{k}; j <= n; ++j)
+                a[i][j] = a[i][j] - factor * a[k][j];
+        }
+    }
+
+    std::vector<Fraction> x(n);
+    for (std::size_t i{n}; i-- > 0;)
+    {
+        Fraction sum{a[i][n]};
+        for (std::size_t j{i + 1}; j < n; ++j)
+            sum = sum - a[i][j] * x[j];
+        x[i] = sum / a[i][i];
+    }
+    return x;
+}
+
+// Result of the fraction-free solver: x[i] = numerators[i] / denominator
+struct BareissSolution
+{
+    std::vector<BigInt> numerators{};
+    BigInt denominator{};
+
+    bool isValid() const { return !denominator.isZero(); }
+
+    std::vector<Fraction> toFractions() const
+    {
+        std::vector<Fraction> x{};
+        for (const auto &numerator : numerators)
+            x.emplace_back(numerator, denominator);
+        return x;
+    }
+};
+
+// One Bareiss step on rows [first, last): eliminates column k using the pivot row k
+void bareissRows(std::vector<std::vector<BigInt>> &a, std::size_t k, const BigInt &previous_pivot, std::size_t first, std::size_t last)
+{
+    const std::size_t columns{a[k].size()};
+    for (std::size_t i{first}; i < last; ++i)
+    {
+        for (std::size_t j{k + 1}; j < columns; ++j)
+            a[i][j] = exactDivide(a[k][k] * a[i][j] - a[i][k] * a[k][j], previous_pivot);
+        a[i][k] = 0;
+    }
+}
+
+// Fraction-free Gaussian elimination, the rows below the pivot are split across thread_count threads
+BareissSolution solveBareiss(const Matrix &system, unsigned thread_count = 1)
+{
+    const std::size_t n{system.size()};
+    std::vector<std::vector<BigInt>> a(n);
+    for (std::size_t i{0}; i < n; ++i)
+        a[i].assign(system[i].begin(), system[i].end());
+
+    BigInt previous_pivot{1};
+    for (std::size_t k{0}; k < n; ++k)
+    {
+        auto pivot{std::find_if(a.begin() + static_cast<std::ptrdiff_t>(k), a.end(), [k](const auto &row)
+                                { return !row[k].isZero(); })};
+        if (pivot == a.end())
+            return {}; // singular: no unique solution
+        std::swap(a[k], *pivot); // swapping equations doesn't change the solution
+
+        const std::size_t rows{n - k - 1};
+        const std::size_t threads{std::min<std::size_t>(thread_count, rows)};
+        if (threads <= 1)
+        {
+            bareissRows(a, k, previous_pivot, k + 1, n);
+        }
+        else
+        {
+            std::vector<std::thread> workers{};
+            const std::size_t chunk{(rows + threads - 1) / threads};
+            for (std::size_t first{k + 1}; first < n; first += chunk)
+            {
+                workers.emplace_back(bareissRows, std::ref(a), k, std::cref(previous_pivot), first, std::min(first + chunk, n));
+            }
+            for (auto &worker : workers)
+                worker.join();
+        }
+        previous_pivot = a[k][k];
+    }
+
+    // no equations: nothing to solve, and the determinant of a 0 x 0 matrix is 1
+    if (n == 0)
+        return {{}, BigInt{1}};
+
+    // back substitution: a[i][i] * X[i] = D * b[i] - sum(a[i][j] * X[j]), every division is exact
+    BareissSolution solution{std::vector<BigInt>(n), a[n - 1][n - 1]};
+    for (std::size_t i{n}; i-- > 0;)
+    {
+        BigInt sum{solution.denominator * a[i][n]};
+        for (std::size_t j{i + 1}; j < n; ++j)
+            sum -= a[i][j] * solution.numerators[j];
+        solution.numerators[i] = exactDivide(sum, a[i][i]);
+    }
+    return solution;
+}
+
+// checks A * X == D * b without any division
+bool checkSolution(const Matrix &system, const BareissSolution &solution)
+{
+    const std::size_t n{system.size()};
+    for (std::size_t i{0}; i < n; ++i)
+    {
+        BigInt lhs{};
+        for (std::size_t j{0}; j < n; ++j)
+            lhs += BigInt{system[i][j]} * solution.numerators[j];
+        if (lhs != BigInt{system[i][n]} * solution.denominator)
+            return false;
+    }
+    return true;
+}
+
+Matrix makeRandomSystem(std::size_t n, unsigned seed)
+{
+    std::mt19937 mt{seed};
+    std::uniform_int_distribution coefficient{-9, 9};
+    Matrix system(n, std::vector<long long>(n + 1));
+    for (auto &row : system)
+        for (auto &value : row)
+            value = coefficient(mt);
+    return system;
+}
+
+int main()
+{
+    /* A small system we can check by hand */
+    //  2x +  y -  z =   8
+    // -3x -  y + 2z = -11
+    // -2x +  y + 2z =  -3      => x = 2, y = 3, z = -1
+    const Matrix small{{2, 1, -1, 8}, {-3, -1, 2, -11}, {-2, 1, 2, -3}};
+    std::vector<Fraction> naive{solveNaive(small)};
+    BareissSolution bareiss{solveBareiss(small)};
+    assert(bareiss.isValid() && checkSolution(small, bareiss));
+    assert(naive == bareiss.toFractions());
+    for (const auto &x : naive)
+        std::cout << x << ' ';
+    std::cout << '\n';
+
+    // a solution that isn't an integer
+    const Matrix halves{{2, 0, 1}, {0, 3, 1}};
+    for (const auto &x : solveBareiss(halves).toFractions())
+        std::cout << x << ' '; // 1/2 1/3
+    std::cout << '\n';
+
+    // singular system
+    assert(!solveBareiss({{1, 2, 3}, {2, 4, 6}}).isValid());
+    assert(solveBareiss({}).isValid() && solveBareiss({}).numerators.empty());
+
+    /* Benchmark: naive Fraction elimination vs Bareiss */
+    const unsigned hardware_threads{std::max(1u, std::thread::hardware_concurrency())};
+    std::cout << "size   naive(s)  bareiss(s)  bareiss x" << hardware_threads << " threads(s)\n";
+    for (std::size_t n : {10, 20, 40, 100, 200})
+    {
+        const Matrix system{makeRandomSystem(n, static_cast<unsigned>(n))};
+        Timer timer{};
+
+        // the naive version gets too slow past a few dozen unknowns
+        double naive_time{-1.0};
+        std::vector<Fraction> naive_x{};
+        if (n <= 40)
+        {
+            naive_x = solveNaive(system);
+            naive_time = timer.elapsed();
+        }
+
+        timer.reset();
+        BareissSolution solution{solveBareiss(system)};
+        double bareiss_time{timer.elapsed()};
+
+        timer.reset();
+        BareissSolution parallel_solution{solveBareiss(system, hardware_threads)};
+        double parallel_time{timer.elapsed()};
+
+        assert(solution.isValid() && checkSolution(system, solution));
+        assert(parallel_solution.numerators == solution.numerators);
+        if (!naive_x.empty())
+            assert(naive_x == solution.toFractions());
+
+        std::cout << n << "\t";
+        if (naive_time < 0)
+            std::cout << "-";
+        else
+            std::cout << naive_time;
+        std::cout << "\t  " << bareiss_time << "\t" << parallel_time
+                  << "\t(determinant has " << solution.denominator.limbCount() * 32 << " bits)\n";
+    }
+
+    return 0;
+}
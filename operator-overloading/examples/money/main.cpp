@@ -0,0 +1,130 @@
+#include "money.h"
+#include "timer.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <cassert>
+
+/*
+    * Representing money with integers
+    * Interning (sharing one copy of a value and handing out small handles)
+    * Overflow checked arithmetic
+    * Batch kernels over a column of amounts
+*/
+
+/*
+The examples so far model money in three different ways: Dollars holds an int and a std::string country in every single value, Cents converts itself
+through float, and the potion shop keeps its gold in a plain int. float and double can't hold 0.10 exactly (it's a repeating fraction in base 2),
+so amounts drift after enough additions: money should be counted in integers of the smallest unit (cents), a.k.a. minor units.
+int64_t minor units go up to 92 233 720 368 547 758.07 USD, which is enough for any ledger.
+
+The currency doesn't need to be a std::string in every value either: there are only a handful of currencies, so each one is registered once
+(interned) and a value only stores the 16-bit index of its entry. Comparing currencies is then comparing two integers, and copying a Money is
+copying 16 bytes without any allocation.
+
+Integer overflow of a signed type is undefined behavior, and for money a silent wraparound is the worst possible outcome, so every operation checks
+and throws std::overflow_error (the same way mixing two currencies throws std::invalid_argument).
+
+Checking every single addition would stop the compiler from vectorizing a big sum. A Ledger stores its amounts as a plain column of int64_t
+and sums them without branches (see sumMinorUnits): the checks happen once, at the end.
+*/
+
+int main()
+{
+    const Currency usd{Currency::get("USD")};
+    const Currency eur{Currency::get("EUR")};
+    const Currency jpy{Currency::get("JPY")};
+
+    /* Exact arithmetic */
+    Money price{*Money::parse("0.10", usd)};
+    Money total{};
+    for (int i{0}; i < 10; ++i)
+        total += price;
+    assert(total == Money::major(1, usd)); // with double, 0.1 added ten times is 0.9999999999999999
+    std::cout << "10 x " << price << " = " << total << '\n';
+
+    /* Parsing and formatting */
+    assert(Money::parse("-1234.5", usd)->minorUnits() == -123450);
+    assert(Money::parse("1234", jpy)->minorUnits() == 1234);
+    assert(!Money::parse("12.345", usd));               // USD has only 2 minor digits
+    assert(!Money::parse("12.3", jpy));                 // JPY has none
+    assert(!Money::parse("92233720368547758.08", usd)); // doesn't fit in int64_t
+    assert(Money::parse("-92233720368547758.08", usd)->toString() == "-92233720368547758.08 USD");
+    std::cout << *Money::parse("-0.05", usd) << ", " << *Money::parse("3.7", eur) << '\n';
+
+    /* Currencies are interned */
+    Currency kwd{Currency::add("KWD", 3)};      // already registered: same handle
+    assert(kwd == Currency::get("KWD"));
+    Currency gold{Currency::add("GLD", 0)};     // the potion shop's currency
+    std::cout << Money::major(120, gold) << " (sizeof(Money) is " << sizeof(Money) << ")\n";
+
+    /* Errors are exceptions */
+    try
+    {
+        Money mixed{Money::major(1, usd) + Money::major(1, eur)};
+    }
+    catch (const std::invalid_argument &exception)
+    {
+        std::cout << "error: " << exception.what() << '\n';
+    }
+    try
+    {
+        Money huge{std::numeric_limits<std::int64_t>::max(), usd};
+        huge += Money{1, usd};
+    }
+    catch (const std::overflow_error &exception)
+    {
+        std::cout << "error: " << exception.what() << '\n';
+    }
+
+    /* Conversions round to the target currency's minor unit */
+    Ledger small{usd};
+    small.add(*Money::parse("10.00", usd));
+    small.add(*Money::parse("-0.01", usd));
+    Ledger yen{small.convert({usd, jpy, 151'500'000})}; // 1 USD = 151.5 JPY
+    assert(yen[0] == Money(1515, jpy) && yen[1] == Money(-2, jpy)); // -1.515 rounds away from zero
+    try
+    {
+        Ledger huge{usd};
+        huge.add(Money{std::numeric_limits<std::int64_t>::max() / 2, usd});
+        Ledger doubled{huge.convert({usd, eur, 3'000'000})};
+    }
+    catch (const std::overflow_error &exception)
+    {
+        std::cout << "error: " << exception.what() << '\n';
+    }
+
+    /* Batch kernels: a ledger with millions of entries */
+    constexpr std::size_t count{20'000'000};
+    std::mt19937 mt{3};
+    std::uniform_int_distribution<std::int64_t> cents{-1'000'000, 1'000'000};
+    Ledger ledger{usd};
+    ledger.reserve(count);
+    for (std::size_t i{0}; i < count; ++i)
+        ledger.add(Money{cents(mt), usd});
+
+    Timer timer{};
+    Money batch_total{ledger.total()};
+    double batch_time{timer.elapsed()};
+
+    timer.reset();
+    Money checked_total{0, usd};
+    for (std::size_t i{0}; i < ledger.size(); ++i)
+        checked_total += ledger[i]; // one overflow check (and currency check) per entry
+    double checked_time{timer.elapsed()};
+    assert(batch_total == checked_total);
+
+    const ExchangeRate usd_to_eur{usd, eur, 921'300}; // 1 USD = 0.9213 EUR
+    timer.reset();
+    Ledger in_euros{ledger.convert(usd_to_eur)};
+    double convert_time{timer.elapsed()};
+    assert(in_euros[0] == Money(((ledger[0].minorUnits() * 9213) + (ledger[0].minorUnits() < 0 ? -5000 : 5000)) / 10000, eur));
+
+    const double gigabytes{static_cast<double>(count * sizeof(std::int64_t)) / 1e9};
+    std::cout << "total: " << batch_total << " (" << count << " entries)\n";
+    std::cout << "sum     batch: " << gigabytes / batch_time << " GB/s, checked operator+=: " << gigabytes / checked_time << " GB/s\n";
+    std::cout << "convert batch: " << gigabytes / convert_time << " GB/s, total " << in_euros.total() << '\n';
+
+    return 0;
+}
@@ -0,0 +1,379 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <charconv>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A currency is interned once in a small registry: a Currency value is only the 16-bit index of its entry,
+// so comparing two currencies is an integer comparison and a Money value never carries a string around.
+namespace MoneyDetail
+{
+    struct CurrencyInfo
+    {
+        std::array<char, 3> code{};
+        int minor_digits{};           // 2 for USD (cents), 0 for JPY
+        std::int64_t minor_per_major{}; // 10^minor_digits
+    };
+
+    constexpr std::size_t max_currencies{64};
+
+    inline std::array<CurrencyInfo, max_currencies> registry{{
+        {{'U', 'S', 'D'}, 2, 100},
+        {{'E', 'U', 'R'}, 2, 100},
+        {{'G', 'B', 'P'}, 2, 100},
+        {{'J', 'P', 'Y'}, 0, 1},
+        {{'K', 'W', 'D'}, 3, 1000},
+    }};
+    // entries below registry_size are never modified again, so they can be read without locking
+    inline std::atomic<std::size_t> registry_size{5};
+    inline std::mutex registry_mutex{}; // only taken to add a currency
+
+    inline bool sameCode(const CurrencyInfo &info, std::string_view code)
+    {
+        return code.size() == 3 && info.code[0] == code[0] && info.code[1] == code[1] && info.code[2] == code[2];
+    }
+
+    // overflow checked operations: throw instead of silently wrapping around (which is undefined behavior for signed integers)
+    inline std::int64_t checkedAdd(std::int64_t a, std::int64_t b)
+    {
+        if ((b > 0 && a > std::numeric_limits<std::int64_t>::max() - b) || (b < 0 && a < std::numeric_limits<std::int64_t>::min() - b))
+            throw std::overflow_error{"Money: addition overflow"};
+        return a + b;
+    }
+    inline std::int64_t checkedSub(std::int64_t a, std::int64_t b)
+    {
+        if ((b < 0 && a > std::numeric_limits<std::int64_t>::max() + b) || (b > 0 && a < std::numeric_limits<std::int64_t>::min() + b))
+            throw std::overflow_error{"Money: subtraction overflow"};
+        return a - b;
+    }
+    inline std::int64_t checkedMul(std::int64_t a, std::int64_t b)
+    {
+        __extension__ typedef __int128 int128; // GCC/Clang extension
+        int128 product{static_cast<int128>(a) * b};
+        if (product > std::numeric_limits<std::int64_t>::max() || product < std::numeric_limits<std::int64_t>::min())
+            throw std::overflow_error{"Money: multiplication overflow"};
+        return static_cast<std::int64_t>(product);
+    }
+}
+
+class Currency
+{
+private:
+    std::uint16_t m_index{}; // index in the registry, 0 is USD
+
+    explicit Currency(std::size_t index) : m_index{static_cast<std::uint16_t>(index)} {}
+
+    const MoneyDetail::CurrencyInfo &info() const { return MoneyDetail::registry[m_index]; }
+
+public:
+    Currency() = default;
+
+    // looks up a registered currency by its ISO code ("USD"), throws std::invalid_argument if unknown
+    static Currency get(std::string_view code)
+    {
+        std::size_t size{MoneyDetail::registry_size.load(std::memory_order_acquire)};
+        for (std::size_t i{0}; i < size; ++i)
+        {
+            if (MoneyDetail::sameCode(MoneyDetail::registry[i], code))
+                return Currency{i};
+        }
+        throw std::invalid_argument{"Currency: unknown code " + std::string{code}};
+    }
+
+    // registers a new currency (or returns the existing one with the same code)
+    static Currency add(std::string_view code, int minor_digits)
+    {
+        if (code.size() != 3)
+            throw std::invalid_argument{"Currency: codes have 3 letters"};
+        if (minor_digits < 0 || minor_digits > 6)
+            throw std::invalid_argument{"Currency: minor digits must be in [0, 6]"};
+
+        std::lock_guard lock{MoneyDetail::registry_mutex};
+        std::size_t size{MoneyDetail::registry_size.load(std::memory_order_relaxed)};
+        for (std::size_t i{0}; i < size; ++i)
+        {
+            if (MoneyDetail::sameCode(MoneyDetail::registry[i], code))
+            {
+                if (MoneyDetail::registry[i].minor_digits != minor_digits)
+                    throw std::invalid_argument{"Currency: " + std::string{code} + " already registered with other minor digits"};
+                return Currency{i};
+            }
+        }
+        if (size == MoneyDetail::max_currencies)
+            throw std::length_error{"Currency: registry is full"};
+
+        std::int64_t minor_per_major{1};
+        for (int i{0}; i < minor_digits; ++i)
+            minor_per_major *= 10;
+        MoneyDetail::registry[size] = {{code[0], code[1], code[2]}, minor_digits, minor_per_major};
+        MoneyDetail::registry_size.store(size + 1, std::memory_order_release); // publish the new entry
+        return Currency{size};
+    }
+
+    std::string_view code() const { return {info().code.data(), info().code.size()}; }
+    int minorDigits() const { return info().minor_digits; }
+    std::int64_t minorPerMajor() const { return info().minor_per_major; }
+
+    friend bool operator==(Currency c1, Currency c2) { return c1.m_index == c2.m_index; }
+    friend bool operator!=(Currency c1, Currency c2) { return !(c1 == c2); }
+};
+
+// An amount of money stored as a 64-bit number of minor units (cents for USD) next to its interned currency.
+// There is no floating point anywhere: 0.1 + 0.2 is exactly 0.3.
+class Money
+{
+private:
+    std::int64_t m_minor{};
+    Currency m_currency{};
+
+    void checkSameCurrency(const Money &other) const
+    {
+        if (m_currency != other.m_currency)
+            throw std::invalid_argument{"Money: currencies don't match"};
+    }
+
+public:
+    Money() = default;
+    Money(std::int64_t minor_units, Currency currency) : m_minor{minor_units}, m_currency{currency} {}
+
+    // whole major units: Money::major(12, usd) is 12.00 USD
+    static Money major(std::int64_t units, Currency currency)
+    {
+        return {MoneyDetail::checkedMul(units, currency.minorPerMajor()), currency};
+    }
+
+    // parses "-1234.5" as -1234.50: at most minorDigits() digits after the point, no exponent, no thousands separators.
+    // Returns std::nullopt if the text isn't a valid amount or doesn't fit.
+    static std::optional<Money> parse(std::string_view text, Currency currency)
+    {
+        const char *first{text.data()};
+        const char *const last{text.data() + text.size()};
+        bool negative{first != last && *first == '-'};
+        if (negative)
+            ++first;
+
+        std::uint64_t units{};
+        auto [units_end, units_ec]{std::from_chars(first, last, units)};
+        if (units_ec != std::errc{})
+            return std::nullopt;
+        first = units_end;
+
+        std::uint64_t fraction{};
+        int fraction_digits{};
+        if (first != last && *first == '.')
+        {
+            for (++first; first != last && *first >= '0' && *first <= '9'; ++first)
+            {
+                if (++fraction_digits > currency.minorDigits())
+                    return std::nullopt; // more precision than the currency has
+                fraction = fraction * 10 + static_cast<std::uint64_t>(*first - '0');
+            }
+        }
+        if (first != last)
+            return std::nullopt;
+        for (; fraction_digits < currency.minorDigits(); ++fraction_digits)
+            fraction *= 10;
+
+        // |amount| <= 2^63 (one more for negative amounts)
+        const std::uint64_t limit{static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()) + (negative ? 1 : 0)};
+        const auto scale{static_cast<std::uint64_t>(currency.minorPerMajor())};
+        if (units > (limit - fraction) / scale)
+            return std::nullopt;
+        std::uint64_t magnitude{units * scale + fraction};
+        return Money{negative ? static_cast<std::int64_t>(0 - magnitude) : static_cast<std::int64_t>(magnitude), currency};
+    }
+
+    std::int64_t minorUnits() const { return m_minor; }
+    Currency currency() const { return m_currency; }
+
+    // writes the amount (without the currency code) like std::to_chars, returns the end of the text or nullptr if it doesn't fit
+    char *format(char *first, char *last) const
+    {
+        // go through unsigned so the most negative amount works too
+        std::uint64_t magnitude{m_minor < 0 ? 0 - static_cast<std::uint64_t>(m_minor) : static_cast<std::uint64_t>(m_minor)};
+        const auto scale{static_cast<std::uint64_t>(m_currency.minorPerMajor())};
+        const int digits{m_currency.minorDigits()};
+        if (last - first < 21 + digits) // sign + 19 digits + point
+            return nullptr;
+
+        if (m_minor < 0)
+            *first++ = '-';
+        first = std::to_chars(first, last, magnitude / scale).ptr;
+        if (digits)
+        {
+            *first++ = '.';
+            std::uint64_t fraction{magnitude % scale};
+            for (int i{digits - 1}; i >= 0; --i)
+            {
+                first[i] = static_cast<char>('0' + fraction % 10);
+                fraction /= 10;
+            }
+            first += digits;
+        }
+        return first;
+    }
+
+    std::string toString() const
+    {
+        std::array<char, 32> buffer{};
+        char *end{format(buffer.data(), buffer.data() + buffer.size())};
+        return std::string{buffer.data(), end} + ' ' + std::string{m_currency.code()};
+    }
+
+    Money operator-() const { return {MoneyDetail::checkedSub(0, m_minor), m_currency}; }
+
+    friend Money operator+(const Money &m1, const Money &m2)
+    {
+        m1.checkSameCurrency(m2);
+        return {MoneyDetail::checkedAdd(m1.m_minor, m2.m_minor), m1.m_currency};
+    }
+    friend Money operator-(const Money &m1, const Money &m2)
+    {
+        m1.checkSameCurrency(m2);
+        return {MoneyDetail::checkedSub(m1.m_minor, m2.m_minor), m1.m_currency};
+    }
+    friend Money operator*(const Money &m, std::int64_t factor) { return {MoneyDetail::checkedMul(m.m_minor, factor), m.m_currency}; }
+    friend Money operator*(std::int64_t factor, const Money &m) { return m * factor; }
+
+    Money &operator+=(const Money &other) { return *this = *this + other; }
+    Money &operator-=(const Money &other) { return *this = *this - other; }
+
+    // amounts of different currencies are never equal, and ordering them throws like the arithmetic does
+    friend bool operator==(const Money &m1, const Money &m2) { return m1.m_currency == m2.m_currency && m1.m_minor == m2.m_minor; }
+    friend bool operator!=(const Money &m1, const Money &m2) { return !(m1 == m2); }
+    friend bool operator<(const Money &m1, const Money &m2)
+    {
+        m1.checkSameCurrency(m2);
+        return m1.m_minor < m2.m_minor;
+    }
+    friend bool operator>(const Money &m1, const Money &m2) { return m2 < m1; }
+    friend bool operator<=(const Money &m1, const Money &m2) { return !(m2 < m1); }
+    friend bool operator>=(const Money &m1, const Money &m2) { return !(m1 < m2); }
+
+    friend std::ostream &operator<<(std::ostream &out, const Money &m)
+    {
+        out << m.toString();
+        return out;
+    }
+};
+
+// 1 unit of `from` is worth micros / 1'000'000 units of `to`
+struct ExchangeRate
+{
+    Currency from{};
+    Currency to{};
+    std::int64_t micros{};
+};
+
+// Sum of many amounts: each amount is split into its high and low 32 bits, which are summed separately in 64 bits.
+// Neither sum can overflow for less than 2^31 amounts, there is no branch in the loop, so it is vectorized;
+// the two halves are combined and checked only once at the end.
+inline std::int64_t sumMinorUnits(std::span<const std::int64_t> amounts)
+{
+    __extension__ typedef __int128 int128;
+    constexpr std::size_t block{std::size_t{1} << 31};
+    int128 total{};
+    for (std::size_t start{0}; start < amounts.size(); start += block)
+    {
+        const std::size_t end{std::min(amounts.size(), start + block)};
+        std::int64_t high{};
+        std::uint64_t low{};
+        for (std::size_t i{start}; i < end; ++i)
+        {
+            high += amounts[i] >> 32;                             // signed high half
+            low += static_cast<std::uint32_t>(amounts[i]);        // unsigned low half
+        }
+        total += static_cast<int128>(high) * (int128{1} << 32) + low;
+    }
+    if (total > std::numeric_limits<std::int64_t>::max() || total < std::numeric_limits<std::int64_t>::min())
+        throw std::overflow_error{"Money: sum overflow"};
+    return static_cast<std::int64_t>(total);
+}
+
+// out[i] = in[i] converted with rate, rounded to the nearest minor unit of the target currency (halfway away from zero).
+// Out of range results don't stop the loop: they are flagged and reported once at the end.
+inline void convertMinorUnits(std::span<const std::int64_t> in, std::span<std::int64_t> out, const ExchangeRate &rate)
+{
+    __extension__ typedef __int128 int128;
+    assert(in.size() <= out.size());
+    // amount_to = amount_from * micros * 10^to_digits / (10^6 * 10^from_digits), reduced like a Fraction
+    std::int64_t numerator{MoneyDetail::checkedMul(rate.micros, rate.to.minorPerMajor())};
+    std::int64_t denominator{1'000'000 * rate.from.minorPerMajor()};
+    const std::int64_t divisor{std::gcd(numerator, denominator)};
+    numerator /= divisor;
+    denominator /= divisor;
+
+    // amounts up to fast_limit can be converted with 64-bit integers, bigger ones (rare) need 128 bits
+    const std::int64_t fast_limit{(std::numeric_limits<std::int64_t>::max() - denominator) / (numerator ? numerator : 1)};
+    const std::int64_t half{denominator / 2};
+    bool overflow{false};
+    for (std::size_t i{0}; i < in.size(); ++i)
+    {
+        if (in[i] <= fast_limit && in[i] >= -fast_limit)
+        {
+            std::int64_t scaled{in[i] * numerator};
+            out[i] = (scaled + (scaled < 0 ? -half : half)) / denominator;
+        }
+        else
+        {
+            int128 scaled{static_cast<int128>(in[i]) * numerator};
+            int128 rounded{(scaled + (scaled < 0 ? -half : half)) / denominator};
+            overflow |= rounded > std::numeric_limits<std::int64_t>::max() || rounded < std::numeric_limits<std::int64_t>::min();
+            out[i] = static_cast<std::int64_t>(rounded);
+        }
+    }
+    if (overflow)
+        throw std::overflow_error{"Money: conversion overflow"};
+}
+
+// A column of amounts in one currency: only 8 bytes per entry, so the kernels above stream through it
+class Ledger
+{
+private:
+    Currency m_currency{};
+    std::vector<std::int64_t> m_amounts{};
+
+public:
+    explicit Ledger(Currency currency) : m_currency{currency} {}
+
+    void reserve(std::size_t count) { m_amounts.reserve(count); }
+    void add(const Money &entry)
+    {
+        if (entry.currency() != m_currency)
+            throw std::invalid_argument{"Ledger: currencies don't match"};
+        m_amounts.push_back(entry.minorUnits());
+    }
+
+    std::size_t size() const { return m_amounts.size(); }
+    Currency currency() const { return m_currency; }
+    Money operator[](std::size_t index) const { return {m_amounts[index], m_currency}; }
+    std::span<const std::int64_t> amounts() const { return m_amounts; }
+
+    Money total() const { return {sumMinorUnits(m_amounts), m_currency}; }
+
+    Ledger convert(const ExchangeRate &rate) const
+    {
+        if (rate.from != m_currency)
+            throw std::invalid_argument{"Ledger: exchange rate doesn't start from the ledger's currency"};
+        Ledger converted{rate.to};
+        converted.m_amounts.resize(m_amounts.size());
+        convertMinorUnits(m_amounts, converted.m_amounts, rate);
+        return converted;
+    }
+};
+
+#endif
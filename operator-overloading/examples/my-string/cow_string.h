@@ -0,0 +1,79 @@
+#ifndef COW_STRING_H
+#define COW_STRING_H
+
+#include "shared_buffer.h"
+#include <algorithm>
+#include <cassert>
+#include <ostream>
+#include <string_view>
+
+// A MyString whose copies share their characters until one of them is modified (copy-on-write).
+// Reading through a const CowString never copies; operator[] on a non-const string, operator+= and mutableData() detach first.
+// The buffer keeps a '\0' after the characters, so c_str() never allocates: the buffer's length counts it, so that a detached copy gets it too.
+template <Sharing S = Sharing::atomic>
+class CowString
+{
+private:
+    SharedBuffer<char, S> m_buffer{};
+
+    void assign(std::string_view s)
+    {
+        m_buffer = SharedBuffer<char, S>(s.empty() ? 0 : static_cast<int>(s.size()) + 1);
+        if (s.empty())
+            return;
+        char *data{m_buffer.mutableData()};
+        std::copy(s.begin(), s.end(), data);
+        data[s.size()] = '\0';
+        m_buffer.setLength(static_cast<int>(s.size()) + 1);
+    }
+
+public:
+    CowString() = default;
+    CowString(std::string_view s) { assign(s); }
+    CowString(const char *s) { assign(s); }
+
+    int length() const { return std::max(m_buffer.length() - 1, 0); }
+    bool empty() const { return length() == 0; }
+    // how many strings share the characters (for demos and tests)
+    int useCount() const { return m_buffer.useCount(); }
+
+    const char *c_str() const { return empty() ? "" : m_buffer.data(); }
+    std::string_view view() const { return {c_str(), static_cast<std::size_t>(length())}; }
+
+    const char &operator[](int index) const
+    {
+        assert(index >= 0 && index < length());
+        return m_buffer.data()[index];
+    }
+    char &operator[](int index)
+    {
+        assert(index >= 0 && index < length());
+        return m_buffer.mutableData()[index];
+    }
+
+    CowString &operator+=(std::string_view s)
+    {
+        if (s.empty())
+            return *this;
+        int old_length{length()};
+        int new_length{old_length + static_cast<int>(s.size())};
+        // + 1 for the '\0', and geometric growth so that appending in a loop stays linear
+        int needed{new_length + 1 <= m_buffer.capacity() ? 0 : std::max(new_length + 1, 2 * m_buffer.capacity())};
+        char *data{m_buffer.mutableData(needed)};
+        std::copy(s.begin(), s.end(), data + old_length);
+        data[new_length] = '\0';
+        m_buffer.setLength(new_length + 1);
+        return *this;
+    }
+
+    friend bool operator==(const CowString &s1, const CowString &s2)
+    {
+        return s1.view() == s2.view();
+    }
+    friend std::ostream &operator<<(std::ostream &out, const CowString &str)
+    {
+        return out << str.view();
+    }
+};
+
+#endif
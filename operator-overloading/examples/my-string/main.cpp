@@ -0,0 +1,461 @@
+#include "my_string.h"
+#include "cow_string.h"
+#include "string_search.h"
+#include "timer.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <memory_resource>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <random>
+#include <type_traits>
+#include <functional>
+#include <iomanip>
+#include <cctype>
+
+/*
+    * An allocator-aware string class
+    * Arena (monotonic) and pool memory resources
+    * Freeing short lived objects in bulk
+    * Copy-on-write strings
+    * Small string optimization (SSO)
+    * SIMD substring search and character class scanning
+*/
+
+/*
+Every MyString used to call new[]/delete[] for its characters. Programs that create lots of small short lived strings (parsing a request, building
+keys, splitting lines) then spend much of their time in the general purpose allocator (malloc), which has to handle any size, any lifetime.
+
+A std::pmr::polymorphic_allocator lets the caller pick where the memory comes from, per object, at runtime:
+    std::pmr::monotonic_buffer_resource: an arena, allocations bump a pointer, deallocate() does nothing and release() frees everything at once
+    std::pmr::unsynchronized_pool_resource: one pool of fixed size blocks per size class, freed blocks are reused without going back to malloc
+The type stays MyString whatever the resource, so the rest of the code doesn't change.
+
+The resource is not copied with the string: a copy of an arena string would otherwise dangle once the arena is released.
+
+Copy-on-write (cow_string.h):
+A MyString copy allocates and copies the characters even if the copy is never modified. CowString copies share a reference counted buffer,
+the first modification of a shared string gives it its own copy (it "detaches"). CowString<Sharing::single_thread> counts with a plain int
+instead of an atomic. C++11 made copy-on-write illegal for std::string (operator[] returns references a later copy would share, and the
+atomic count costs every copy in multithreaded programs): CowString is a separate class, used where its rules are acceptable.
+
+Small string optimization (my_string.h):
+Most strings are short (names, keys, words), yet the MyString of operator-overloading/main.cpp allocates even for one character, and
+copies every string deeply because it has no move operations (sorting a vector of them copies strings at every swap).
+MyString keeps up to 22 characters inside the object: it is 32 bytes anyway (a pointer, a length, a capacity, the allocator), so the 24
+bytes of the pointer, length and capacity are reused as a character buffer when the string is short. A short string never allocates,
+and a move copies 32 bytes. std::string does the same (15 characters in libstdc++, 22 in libc++).
+Longer strings grow geometrically: reserve() and capacity() work like std::string's.
+
+SIMD search (string_search.h):
+std::string::find looks for the first character of the needle with memchr, then compares the rest: in text where that character is common
+(a needle starting with 'e', or with a space) it stops every few bytes. StringSearch::find compares 32 or 64 positions at once against
+the first AND the last character of the needle, and only checks the positions where both match. The instruction set (SSE2, AVX2,
+AVX-512) is picked at runtime, so one binary uses the best one the cpu has. The functions take std::string_view: they work on MyString
+(view(), or MyString::find()), std::string and literals alike. isAlphaOrSpace() is the check of isValidName() in input-output/main.cpp,
+written without a call and without an early exit per character so that it's vectorized.
+*/
+
+// the MyString class of operator-overloading/main.cpp (with its self-assignment guard fixed), the baseline of the SSO benchmark
+class LessonMyString
+{
+private:
+    char *m_string{};
+    int m_length{};
+
+public:
+    LessonMyString(const char *s = nullptr, int length = 0) : m_length{std::max(length, 0)}
+    {
+        if (m_length)
+        {
+            m_string = new char[length];
+            std::copy_n(s, length, m_string);
+        }
+    }
+    void deepCopy(const LessonMyString &str)
+    {
+        if (m_string)
+            delete[] m_string;
+
+        m_string = nullptr;
+        m_length = 0;
+        if (str.m_string)
+        {
+            m_length = str.m_length;
+            m_string = new char[m_length];
+            std::copy_n(str.m_string, m_length, m_string);
+        }
+    }
+    LessonMyString(const LessonMyString &str)
+    {
+        deepCopy(str);
+    }
+    LessonMyString &operator=(const LessonMyString &str)
+    {
+        if (this == &str)
+            return *this;
+
+        deepCopy(str);
+        return *this;
+    }
+    ~LessonMyString()
+    {
+        delete[] m_string;
+    }
+
+    // for the benchmark
+    std::string_view view() const { return {m_string, static_cast<std::size_t>(m_length)}; }
+};
+
+std::string_view view(const LessonMyString &str) { return str.view(); }
+std::string_view view(const MyString &str) { return str.view(); }
+std::string_view view(const std::string &str) { return str; }
+
+// builds, copies and sorts a list of short keys: the typical work of a map or an index
+template <typename String>
+double shortKeys(const std::vector<std::string> &keys, std::size_t &check)
+{
+    Timer timer{};
+    std::vector<String> strings{};
+    strings.reserve(keys.size());
+    for (const std::string &key : keys)
+    {
+        if constexpr (std::is_same_v<String, LessonMyString>)
+            strings.emplace_back(key.data(), static_cast<int>(key.size()));
+        else
+            strings.emplace_back(key);
+    }
+    std::vector<String> copy{strings};
+    std::sort(copy.begin(), copy.end(), [](const String &a, const String &b)
+              { return view(a) < view(b); });
+    check += view(copy.front()).size() + view(copy.back()).size();
+    return timer.elapsed();
+}
+
+template <typename String>
+std::int64_t firstPlusLast(String str) // by value on purpose
+{
+    return std::int64_t{std::as_const(str)[0]} + std::as_const(str)[str.length() - 1];
+}
+
+// copies a list of strings (a snapshot) and changes one of them in the copy
+template <typename String>
+std::int64_t snapshotAndEdit(const std::vector<String> &names, int round)
+{
+    std::vector<String> snapshot{names};
+    String &name{snapshot[static_cast<std::size_t>(round) % snapshot.size()]};
+    name[0] = 'X';
+    return name.length();
+}
+
+// splits a line into words and joins them back in reverse order: lots of small strings that live as long as one request
+int handleRequest(std::string_view line, std::pmr::memory_resource *resource)
+{
+    std::pmr::vector<MyString> words{resource}; // the vector and its strings all use the resource
+    for (std::size_t begin{0}; begin < line.size();)
+    {
+        std::size_t end{line.find(' ', begin)};
+        if (end == std::string_view::npos)
+            end = line.size();
+        words.emplace_back(line.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    MyString reversed{resource};
+    for (auto it{words.rbegin()}; it != words.rend(); ++it)
+    {
+        reversed += it->view();
+        reversed += " ";
+    }
+    return reversed.length();
+}
+
+// text of lowercase letters and spaces, with the frequent letters more frequent (like English)
+std::string makeText(std::size_t size)
+{
+    constexpr std::string_view letters{"eeeeetttaaoinshrdlucmfwyp      "};
+    std::string text(size, ' ');
+    std::uint32_t state{12345};
+    for (char &c : text)
+    {
+        state = state * 1664525 + 1013904223; // a cheap generator: filling 1 GiB with std::mt19937 takes seconds
+        c = letters[(state >> 24) % letters.size()];
+    }
+    return text;
+}
+
+// input-output/main.cpp's version
+bool isValidName(const std::string &name)
+{
+    return std::ranges::all_of(name, [](char c)
+                               { return isalpha(c) || std::isspace(c); });
+}
+
+int main()
+{
+    MyString hello{"Hello"};
+    MyString copy{hello};
+    copy += ", world!";
+    hello = hello; // self-assignment is a no-op (the self-assignment guard of operator-overloading/main.cpp returned early for *every other* string)
+    std::cout << hello << " / " << copy << '\n';
+
+    {
+        std::byte buffer[256];
+        std::pmr::monotonic_buffer_resource arena{buffer, sizeof(buffer), std::pmr::null_memory_resource()};
+        MyString local{"stack allocated characters", &arena};
+        MyString escaped{local}; // the copy uses the default resource: it can outlive the arena
+        assert(escaped == local && escaped.get_allocator().resource() == std::pmr::get_default_resource());
+        MyString moved{std::move(local)}; // a move keeps the arena
+        assert(moved.get_allocator().resource() == &arena && local.empty());
+        MyString other_resource{};
+        other_resource = std::move(moved); // different resources: the characters are copied, moved is still left empty
+        assert(other_resource.view() == "stack allocated characters" && moved.empty() && moved.isShort());
+    }
+
+    /* Benchmark: short lived strings, one batch per request */
+    const std::string_view line{"the quick brown fox jumps over the lazy dog while five boxing wizards jump quickly"};
+    constexpr int requests{500'000};
+    long results[3]{};
+    double times[3]{};
+
+    Timer timer{};
+    for (int request{0}; request < requests; ++request)
+        results[0] += handleRequest(line.substr(request % 8), std::pmr::new_delete_resource());
+    times[0] = timer.elapsed();
+
+    timer.reset();
+    {
+        static std::byte request_buffer[16 * 1024];
+        std::pmr::monotonic_buffer_resource arena{request_buffer, sizeof(request_buffer)};
+        for (int request{0}; request < requests; ++request)
+        {
+            results[1] += handleRequest(line.substr(request % 8), &arena);
+            arena.release(); // every string of the request is freed at once
+        }
+    }
+    times[1] = timer.elapsed();
+
+    timer.reset();
+    {
+        std::pmr::unsynchronized_pool_resource pool{};
+        for (int request{0}; request < requests; ++request)
+            results[2] += handleRequest(line.substr(request % 8), &pool);
+    }
+    times[2] = timer.elapsed();
+
+    assert(results[0] == results[1] && results[0] == results[2]);
+    std::cout << requests << " requests (split + join):\n";
+    std::cout << "new/delete                   " << times[0] << " s\n";
+    std::cout << "monotonic_buffer_resource    " << times[1] << " s\n";
+    std::cout << "unsynchronized_pool_resource " << times[2] << " s\n";
+
+    /* Small string optimization */
+    static_assert(sizeof(MyString) == 32);
+    MyString key{"student-42"};
+    assert(key.isShort() && key.capacity() == MyString::short_capacity);
+    MyString grown{key};
+    grown += " of the class of 2024"; // 31 characters: moves to the heap
+    assert(!grown.isShort() && grown.view() == "student-42 of the class of 2024");
+    grown += grown.view(); // appending itself is safe
+    assert(grown.length() == 62);
+    MyString moved_key{std::move(key)};
+    assert(moved_key.view() == "student-42" && key.empty());
+    MyString reserved{};
+    reserved.reserve(100);
+    for (int i{0}; i < 100; ++i)
+        reserved.push_back('a');
+    assert(reserved.capacity() == 100 && reserved.length() == 100);
+
+    /* Benchmark: short keys */
+    {
+        std::mt19937 mt{2024};
+        std::uniform_int_distribution<int> key_length{4, 20};
+        std::uniform_int_distribution<int> letter{'a', 'z'};
+        std::vector<std::string> keys(1'000'000);
+        for (std::string &k : keys)
+        {
+            k.resize(static_cast<std::size_t>(key_length(mt)));
+            for (char &c : k)
+                c = static_cast<char>(letter(mt));
+        }
+        std::size_t check{0};
+        double lesson_time{shortKeys<LessonMyString>(keys, check)};
+        double sso_time{shortKeys<MyString>(keys, check)};
+        double std_time{shortKeys<std::string>(keys, check)};
+        std::cout << keys.size() << " keys of 4 to 20 characters (build, copy, sort):\n";
+        std::cout << "MyString of operator-overloading/main.cpp " << lesson_time << " s\n";
+        std::cout << "MyString (SSO, moves)                     " << sso_time << " s\n";
+        std::cout << "std::string                               " << std_time << " s (" << check << ")\n";
+    }
+
+    /* Copy-on-write */
+    CowString<> original{"copy-on-write"};
+    CowString<> shared{original};
+    assert(shared.useCount() == 2 && shared.c_str() == original.c_str());
+    shared[0] = 'C'; // detaches
+    shared += "!";
+    assert(original == CowString<>{"copy-on-write"} && shared == CowString<>{"Copy-on-write!"});
+    assert(std::string_view{shared.c_str()} == "Copy-on-write!");
+    std::cout << original << " / " << shared << '\n';
+
+    /* Benchmark: pass-by-value and container of strings */
+    {
+        const std::string text(4096, ' ');
+        MyString plain{text};
+        CowString<Sharing::atomic> cow{text};
+        CowString<Sharing::single_thread> cow_single{text};
+        constexpr int calls{50'000};
+        std::int64_t results_by_value[3]{};
+        timer.reset();
+        for (int call{0}; call < calls; ++call)
+            results_by_value[0] += firstPlusLast(plain);
+        double plain_time{timer.elapsed()};
+        timer.reset();
+        for (int call{0}; call < calls; ++call)
+            results_by_value[1] += firstPlusLast(cow);
+        double cow_time{timer.elapsed()};
+        timer.reset();
+        for (int call{0}; call < calls; ++call)
+            results_by_value[2] += firstPlusLast(cow_single);
+        double single_time{timer.elapsed()};
+        assert(results_by_value[0] == results_by_value[1] && results_by_value[0] == results_by_value[2]);
+        std::cout << calls << " calls passing a " << text.size() << " character string by value:\n";
+        std::cout << "MyString                          " << plain_time << " s\n";
+        std::cout << "CowString<Sharing::atomic>        " << cow_time << " s\n";
+        std::cout << "CowString<Sharing::single_thread> " << single_time << " s\n";
+    }
+    {
+        std::vector<MyString> plain_names{};
+        std::vector<CowString<Sharing::atomic>> cow_names{};
+        std::vector<CowString<Sharing::single_thread>> single_names{};
+        for (int i{0}; i < 10'000; ++i)
+        {
+            std::string name{"student number " + std::to_string(i) + " of the 2024 class"};
+            plain_names.emplace_back(name);
+            cow_names.emplace_back(name);
+            single_names.emplace_back(name);
+        }
+        constexpr int snapshots{500};
+        std::int64_t results_snapshot[3]{};
+        timer.reset();
+        for (int round{0}; round < snapshots; ++round)
+            results_snapshot[0] += snapshotAndEdit(plain_names, round);
+        double plain_time{timer.elapsed()};
+        timer.reset();
+        for (int round{0}; round < snapshots; ++round)
+            results_snapshot[1] += snapshotAndEdit(cow_names, round);
+        double cow_time{timer.elapsed()};
+        timer.reset();
+        for (int round{0}; round < snapshots; ++round)
+            results_snapshot[2] += snapshotAndEdit(single_names, round);
+        double single_time{timer.elapsed()};
+        assert(results_snapshot[0] == results_snapshot[1] && results_snapshot[0] == results_snapshot[2]);
+        std::cout << snapshots << " snapshots of " << plain_names.size() << " strings, one of them edited:\n";
+        std::cout << "MyString                          " << plain_time << " s\n";
+        std::cout << "CowString<Sharing::atomic>        " << cow_time << " s\n";
+        std::cout << "CowString<Sharing::single_thread> " << single_time << " s\n";
+    }
+
+    /* SIMD substring search */
+    std::cout << "StringSearch uses " << StringSearch::implementation() << '\n';
+    const std::string_view sentence{"the quick brown fox jumps over the lazy dog, the end"};
+    assert(StringSearch::find(sentence, "the") == 0 && StringSearch::find(sentence, "the", 1) == 31);
+    assert(StringSearch::find(sentence, "the end") == sentence.size() - 7 && StringSearch::find(sentence, "cat") == StringSearch::npos);
+    assert(StringSearch::contains(sentence, "lazy dog") && !StringSearch::contains(sentence, "lazy cat"));
+    assert(StringSearch::count(sentence, "the") == 3 && StringSearch::count(sentence, 'o') == 4);
+    auto words{StringSearch::split("a, b,, c", ", ")};
+    assert((words == std::vector<std::string_view>{"a", "b,", "c"}));
+    MyString long_sentence{sentence};
+    assert(long_sentence.find("fox") == 16 && long_sentence.find("fox", 17) == -1 && long_sentence.contains("over"));
+    assert(StringSearch::isAlphaOrSpace("John Smith") && !StringSearch::isAlphaOrSpace("John Smith 2"));
+    {
+        // every position and needle length against std::string_view::find, to cover the ends of the blocks
+        std::string text{makeText(300)};
+        for (std::size_t length{1}; length <= 70; ++length)
+            for (std::size_t position{0}; position + length <= text.size(); position += 7)
+            {
+                std::string_view needle{std::string_view{text}.substr(position, length)};
+                for (std::size_t from : {std::size_t{0}, position / 2, position})
+                    assert(StringSearch::find(text, needle, from) == std::string_view{text}.find(needle, from));
+            }
+    }
+
+    /* Benchmark: substring search, 1 KiB to 1 GiB */
+    {
+        constexpr std::string_view needle{"e the same thing"}; // starts with the most frequent letter
+        constexpr std::size_t sizes[]{std::size_t{1} << 10, std::size_t{1} << 16, std::size_t{1} << 24, std::size_t{1} << 30};
+        constexpr std::size_t scanned{std::size_t{1} << 30}; // bytes searched per size and method
+        std::string text{makeText(sizes[std::size(sizes) - 1])};
+        std::cout << "finding a " << needle.size() << " character needle at the end of the text (GB/s):\n";
+        std::cout << "size        std::string::find  boyer_moore_horspool  StringSearch::find\n";
+        const std::boyer_moore_horspool_searcher searcher{needle.begin(), needle.end()};
+        for (std::size_t size : sizes)
+        {
+            // the needle is only at the end: the whole text is searched
+            std::string haystack{};
+            if (size == text.size())
+                haystack = std::move(text);
+            else
+                haystack = text.substr(0, size);
+            haystack.replace(size - needle.size(), needle.size(), needle);
+            const std::size_t expected{size - needle.size()};
+            const std::size_t rounds{std::max<std::size_t>(1, scanned / size)};
+            std::size_t found[3]{};
+            double speeds[3]{};
+
+            timer.reset();
+            for (std::size_t round{0}; round < rounds; ++round)
+                found[0] += haystack.find(needle);
+            speeds[0] = static_cast<double>(size * rounds) / timer.elapsed() / 1e9;
+
+            timer.reset();
+            for (std::size_t round{0}; round < rounds; ++round)
+                found[1] += static_cast<std::size_t>(std::search(haystack.begin(), haystack.end(), searcher) - haystack.begin());
+            speeds[1] = static_cast<double>(size * rounds) / timer.elapsed() / 1e9;
+
+            timer.reset();
+            for (std::size_t round{0}; round < rounds; ++round)
+                found[2] += StringSearch::find(haystack, needle);
+            speeds[2] = static_cast<double>(size * rounds) / timer.elapsed() / 1e9;
+
+            for (std::size_t result : found)
+                assert(result == expected * rounds);
+            std::cout << std::left << std::setw(12) << std::to_string(size / 1024) + " KiB" << std::setw(19) << speeds[0]
+                      << std::setw(22) << speeds[1] << speeds[2] << '\n';
+        }
+    }
+
+    /* Benchmark: character class scanning */
+    {
+        std::vector<std::string> names{};
+        std::mt19937 random{7};
+        const std::string text{makeText(1 << 20)};
+        for (int i{0}; i < 200'000; ++i)
+            names.push_back(text.substr(random() % (text.size() - 100), 8 + random() % 56));
+        names.back() += '1'; // one invalid name
+        constexpr int rounds{10};
+
+        timer.reset();
+        int valid[2]{};
+        for (int round{0}; round < rounds; ++round)
+            for (const std::string &name : names)
+                valid[0] += isValidName(name);
+        double lesson_time{timer.elapsed()};
+
+        timer.reset();
+        for (int round{0}; round < rounds; ++round)
+            for (const std::string &name : names)
+                valid[1] += StringSearch::isAlphaOrSpace(name);
+        double simd_time{timer.elapsed()};
+
+        assert(valid[0] == valid[1] && valid[0] == rounds * (static_cast<int>(names.size()) - 1));
+        std::cout << "validating " << names.size() << " names, " << rounds << " times:\n";
+        std::cout << "isValidName() (isalpha/isspace) " << lesson_time << " s\n";
+        std::cout << "StringSearch::isAlphaOrSpace()  " << simd_time << " s\n";
+    }
+
+    return 0;
+}
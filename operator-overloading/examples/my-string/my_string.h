@@ -0,0 +1,261 @@
+#ifndef MY_STRING_H
+#define MY_STRING_H
+
+#include "string_search.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <ostream>
+#include <string_view>
+#include <utility>
+
+// The MyString class of operator-overloading/main.cpp (rule of three, deep copies), grown into a usable string class:
+//   allocator-aware: its characters come from a polymorphic allocator, new/delete by default, or an arena/pool chosen by the caller
+//   small string optimization (SSO): up to 22 characters are stored inside the object itself, no allocation at all
+//   move semantics, and a capacity that grows geometrically (reserve(), +=, push_back())
+// The characters are always followed by a '\0', so c_str() can be handed to C functions.
+//
+// Layout (32 bytes, the allocator included): a 24 byte union of
+//   short: the length in byte 0, the characters in bytes 1 to 23 ('\0' included)
+//   long:  long_tag in byte 0, the length and the capacity, a pointer to the heap characters
+// Byte 0 is the first member of both structs (their "common initial sequence"): C++ allows reading it through either one,
+// whichever was written last, so m_short.tag tells which one is in use.
+class MyString
+{
+public:
+    // makes std::pmr containers of MyString pass their memory resource down to the strings
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    static constexpr int short_capacity{22};
+
+private:
+    static constexpr unsigned char long_tag{0xff};
+    struct Short
+    {
+        unsigned char tag; // the length
+        char chars[short_capacity + 1];
+    };
+    struct Long
+    {
+        unsigned char tag; // long_tag
+        std::int32_t length;
+        std::int32_t capacity; // characters, the '\0' not included
+        char *data;
+    };
+    static_assert(sizeof(Short) == 24 && sizeof(Long) == 24);
+
+    union
+    {
+        Short m_short{};
+        Long m_long;
+    };
+    allocator_type m_alloc{};
+
+    bool isLong() const { return m_short.tag == long_tag; }
+    void setShortLength(int length)
+    {
+        assert(length >= 0 && length <= short_capacity);
+        m_short.tag = static_cast<unsigned char>(length);
+        m_short.chars[length] = '\0';
+    }
+
+    char *allocate(int capacity)
+    {
+        return m_alloc.allocate(static_cast<std::size_t>(capacity) + 1);
+    }
+    void deallocate()
+    {
+        if (isLong())
+            m_alloc.deallocate(m_long.data, static_cast<std::size_t>(m_long.capacity) + 1);
+    }
+
+    // makes room for capacity characters, keeping the current ones, and appends extra (which may point into the old characters)
+    void grow(int capacity, std::string_view extra = {})
+    {
+        int length{this->length()};
+        char *data{allocate(capacity)};
+        std::copy_n(this->data(), length, data);
+        std::copy(extra.begin(), extra.end(), data + length);
+        length += static_cast<int>(extra.size());
+        data[length] = '\0';
+        deallocate();
+        m_long.data = data;
+        m_long.length = length;
+        m_long.capacity = capacity;
+        m_long.tag = long_tag;
+    }
+
+    void setLength(int length)
+    {
+        if (isLong())
+        {
+            m_long.length = length;
+            m_long.data[length] = '\0';
+        }
+        else
+            setShortLength(length);
+    }
+
+    void assign(const char *s, int length)
+    {
+        assert(length >= 0);
+        if (length > capacity())
+        {
+            // no need to keep the old characters: free first, then allocate the exact size
+            deallocate();
+            setShortLength(0);
+            grow(length);
+        }
+        std::copy_n(s, length, data());
+        setLength(length);
+    }
+
+    // steals str's heap characters, or copies its short ones
+    void take(MyString &str) noexcept
+    {
+        if (str.isLong())
+            m_long = str.m_long;
+        else
+            m_short = str.m_short;
+        str.setShortLength(0);
+    }
+
+public:
+    MyString() { setShortLength(0); }
+    explicit MyString(const allocator_type &alloc) : m_alloc{alloc} { setShortLength(0); }
+    MyString(const char *s, int length, const allocator_type &alloc = {}) : m_alloc{alloc}
+    {
+        setShortLength(0);
+        assign(s, std::max(length, 0));
+    }
+    MyString(std::string_view s, const allocator_type &alloc = {}) : MyString(s.data(), static_cast<int>(s.size()), alloc) {}
+    MyString(const char *s, const allocator_type &alloc = {}) : MyString(std::string_view{s}, alloc) {}
+
+    // copy constructor: deep copy, into the default resource unless the caller passes one (the source's resource may be a short-lived arena)
+    MyString(const MyString &str, const allocator_type &alloc = {}) : MyString(str.data(), str.length(), alloc) {}
+    // assignment operator: deep copy, the string keeps its own resource (and reuses its buffer when it's big enough)
+    MyString &operator=(const MyString &str)
+    {
+        // self-assignment guard
+        if (this == &str)
+            return *this;
+
+        assign(str.data(), str.length());
+        return *this;
+    }
+
+    // move constructor: steals the characters and the resource that owns them (short strings are copied: 24 bytes, no allocation)
+    MyString(MyString &&str) noexcept : m_alloc{str.m_alloc}
+    {
+        take(str);
+    }
+    // allocator-extended move: only steals the characters when both strings use the same resource
+    MyString(MyString &&str, const allocator_type &alloc) : m_alloc{alloc}
+    {
+        setShortLength(0);
+        *this = std::move(str);
+    }
+    // move assignment: the characters can only change hands between strings of the same resource, otherwise they are copied
+    // (so it can't be noexcept, like std::pmr::string; with the default resource it never allocates)
+    MyString &operator=(MyString &&str)
+    {
+        if (this == &str)
+            return *this;
+        if (m_alloc != str.m_alloc)
+        {
+            assign(str.data(), str.length());
+            // left empty, like after a move of the characters (and like IntArray)
+            str.deallocate();
+            str.setShortLength(0);
+            return *this;
+        }
+        deallocate();
+        take(str);
+        return *this;
+    }
+
+    ~MyString()
+    {
+        deallocate();
+    }
+
+    allocator_type get_allocator() const { return m_alloc; }
+
+    int length() const { return isLong() ? m_long.length : static_cast<int>(m_short.tag); }
+    bool empty() const { return length() == 0; }
+    int capacity() const { return isLong() ? m_long.capacity : short_capacity; }
+    // true when the characters are inside the object (no allocation)
+    bool isShort() const { return !isLong(); }
+
+    char *data() { return isLong() ? m_long.data : m_short.chars; }
+    const char *data() const { return isLong() ? m_long.data : m_short.chars; }
+    const char *c_str() const { return data(); }
+    std::string_view view() const { return {data(), static_cast<std::size_t>(length())}; }
+
+    char &operator[](int index)
+    {
+        assert(index >= 0 && index < length());
+        return data()[index];
+    }
+    const char &operator[](int index) const
+    {
+        assert(index >= 0 && index < length());
+        return data()[index];
+    }
+
+    // the position of the first s at or after from, -1 if there is none (SIMD search, see string_search.h)
+    int find(std::string_view s, int from = 0) const
+    {
+        std::size_t position{StringSearch::find(view(), s, static_cast<std::size_t>(std::max(from, 0)))};
+        return position == StringSearch::npos ? -1 : static_cast<int>(position);
+    }
+    bool contains(std::string_view s) const { return StringSearch::contains(view(), s); }
+
+    // makes room for new_capacity characters, so that appending up to there doesn't allocate
+    void reserve(int new_capacity)
+    {
+        if (new_capacity > capacity())
+            grow(new_capacity);
+    }
+    void clear() { setLength(0); }
+
+    void push_back(char c)
+    {
+        int old_length{length()};
+        if (old_length == capacity())
+            grow(2 * capacity());
+        data()[old_length] = c;
+        setLength(old_length + 1);
+    }
+    MyString &operator+=(std::string_view s)
+    {
+        int old_length{length()};
+        int new_length{old_length + static_cast<int>(s.size())};
+        // geometric growth: appending in a loop stays linear
+        if (new_length > capacity())
+            grow(std::max(new_length, 2 * capacity()), s);
+        else
+        {
+            std::copy(s.begin(), s.end(), data() + old_length);
+            setLength(new_length);
+        }
+        return *this;
+    }
+
+    friend bool operator==(const MyString &s1, const MyString &s2)
+    {
+        return s1.view() == s2.view();
+    }
+    friend bool operator<(const MyString &s1, const MyString &s2)
+    {
+        return s1.view() < s2.view();
+    }
+    friend std::ostream &operator<<(std::ostream &out, const MyString &str)
+    {
+        return out << str.view();
+    }
+};
+
+#endif
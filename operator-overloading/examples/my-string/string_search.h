@@ -0,0 +1,241 @@
+#ifndef STRING_SEARCH_H
+#define STRING_SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(STRING_SEARCH_NO_DISPATCH)
+#define STRING_SEARCH_X86
+#include <immintrin.h>
+#endif
+
+// Substring search and character class scanning over std::string_view (so over MyString::view(), std::string, literals...).
+//
+// find() uses the "generic SIMD" algorithm (Wojciech Muła, "SIMD-friendly algorithms for substring searching"): for the 32 (or 64)
+// positions of a block at once, it compares the haystack with the first byte of the needle, and the haystack shifted by
+// needle.size() - 1 with the last byte of the needle. Only the positions where both bytes match are compared in full (memcmp).
+// In ordinary text the pair of bytes rarely matches, so it scans at close to the speed of memory whatever the needle is
+// (std::string::find looks for the first byte with memchr, then compares: slow when that byte is common).
+//
+// The instruction set is chosen once, on the first call, from what the cpu reports (__builtin_cpu_supports): AVX-512BW, AVX2,
+// or the baseline (SSE2) everywhere else on x86-64. The kernels are compiled for their instruction set with the target attribute,
+// the rest of the program doesn't need -mavx2. Other targets (or STRING_SEARCH_NO_DISPATCH) use std::string_view::find.
+//
+// The character class functions (count(text, char), isAlphaOrSpace()) are plain loops without early exit inside blocks of 64
+// characters, which the compiler vectorizes; target_clones compiles them once per instruction set, like IntArrayOps (x86-64-v4 is
+// the AVX-512 level that includes the byte instructions, AVX-512BW).
+#if defined(STRING_SEARCH_X86)
+#define STRING_SEARCH_DISPATCH __attribute__((target_clones("default", "avx2", "arch=x86-64-v4")))
+#else
+#define STRING_SEARCH_DISPATCH
+#endif
+
+namespace StringSearch
+{
+    constexpr std::size_t npos{std::string_view::npos};
+
+    namespace detail
+    {
+        using FindFunction = std::size_t (*)(std::string_view haystack, std::string_view needle, std::size_t from);
+
+        // for the positions the blocks didn't cover: a haystack shorter than a block, or its end
+        inline std::size_t findTail(std::string_view haystack, std::string_view needle, std::size_t from)
+        {
+            return haystack.find(needle, from);
+        }
+
+#if defined(STRING_SEARCH_X86)
+        // the kernels only get needles of 2 characters or more: position i is a candidate when haystack[i] == needle[0]
+        // and haystack[i + n - 1] == needle[n - 1], then the n - 2 characters in between are compared
+        inline bool middleMatches(const char *candidate, std::string_view needle)
+        {
+            return std::memcmp(candidate + 1, needle.data() + 1, needle.size() - 2) == 0;
+        }
+
+        inline std::size_t findSse2(std::string_view haystack, std::string_view needle, std::size_t from)
+        {
+            const char *data{haystack.data()};
+            const std::size_t last_offset{needle.size() - 1};
+            const __m128i first{_mm_set1_epi8(needle.front())};
+            const __m128i last{_mm_set1_epi8(needle.back())};
+            std::size_t i{from};
+            for (; i + 16 + last_offset <= haystack.size(); i += 16)
+            {
+                __m128i block_first{_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i))};
+                __m128i block_last{_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + last_offset))};
+                unsigned mask{static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last))))};
+                for (; mask != 0; mask &= mask - 1)
+                {
+                    std::size_t position{i + static_cast<std::size_t>(__builtin_ctz(mask))};
+                    if (middleMatches(data + position, needle))
+                        return position;
+                }
+            }
+            return findTail(haystack, needle, i);
+        }
+
+        __attribute__((target("avx2"))) inline std::size_t findAvx2(std::string_view haystack, std::string_view needle, std::size_t from)
+        {
+            const char *data{haystack.data()};
+            const std::size_t last_offset{needle.size() - 1};
+            const __m256i first{_mm256_set1_epi8(needle.front())};
+            const __m256i last{_mm256_set1_epi8(needle.back())};
+            std::size_t i{from};
+            for (; i + 32 + last_offset <= haystack.size(); i += 32)
+            {
+                __m256i block_first{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i))};
+                __m256i block_last{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + last_offset))};
+                unsigned mask{static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last))))};
+                for (; mask != 0; mask &= mask - 1)
+                {
+                    std::size_t position{i + static_cast<std::size_t>(__builtin_ctz(mask))};
+                    if (middleMatches(data + position, needle))
+                        return position;
+                }
+            }
+            return findTail(haystack, needle, i);
+        }
+
+        __attribute__((target("avx512f,avx512bw"))) inline std::size_t findAvx512(std::string_view haystack, std::string_view needle, std::size_t from)
+        {
+            const char *data{haystack.data()};
+            const std::size_t last_offset{needle.size() - 1};
+            const __m512i first{_mm512_set1_epi8(needle.front())};
+            const __m512i last{_mm512_set1_epi8(needle.back())};
+            std::size_t i{from};
+            for (; i + 64 + last_offset <= haystack.size(); i += 64)
+            {
+                __m512i block_first{_mm512_loadu_si512(data + i)};
+                __m512i block_last{_mm512_loadu_si512(data + i + last_offset)};
+                // the compare of the last bytes only runs on the lanes where the first bytes matched
+                std::uint64_t mask{_mm512_mask_cmpeq_epi8_mask(_mm512_cmpeq_epi8_mask(first, block_first), last, block_last)};
+                for (; mask != 0; mask &= mask - 1)
+                {
+                    std::size_t position{i + static_cast<std::size_t>(__builtin_ctzll(mask))};
+                    if (middleMatches(data + position, needle))
+                        return position;
+                }
+            }
+            return findTail(haystack, needle, i);
+        }
+
+        inline FindFunction selectFind()
+        {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512bw"))
+                return findAvx512;
+            if (__builtin_cpu_supports("avx2"))
+                return findAvx2;
+            return findSse2;
+        }
+        inline const char *selectName()
+        {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512bw"))
+                return "avx512bw";
+            if (__builtin_cpu_supports("avx2"))
+                return "avx2";
+            return "sse2";
+        }
+#else
+        inline FindFunction selectFind() { return findTail; }
+        inline const char *selectName() { return "std::string_view::find"; }
+#endif
+    }
+
+    // the name of the instruction set find() uses on this cpu
+    inline const char *implementation()
+    {
+        static const char *name{detail::selectName()};
+        return name;
+    }
+
+    // the position of the first needle in haystack at or after from, npos if there is none (like std::string_view::find)
+    inline std::size_t find(std::string_view haystack, std::string_view needle, std::size_t from = 0)
+    {
+        if (from > haystack.size() || needle.size() > haystack.size() - from)
+            return npos;
+        if (needle.size() < 2) // an empty needle, or a single character: memchr is vectorized already
+            return haystack.find(needle, from);
+        static const detail::FindFunction kernel{detail::selectFind()}; // chosen on the first call
+        return kernel(haystack, needle, from);
+    }
+
+    inline bool contains(std::string_view haystack, std::string_view needle)
+    {
+        return find(haystack, needle) != npos;
+    }
+
+    // the number of non overlapping needles in haystack
+    inline std::size_t count(std::string_view haystack, std::string_view needle)
+    {
+        if (needle.empty())
+            return 0;
+        std::size_t total{0};
+        for (std::size_t position{find(haystack, needle)}; position != npos; position = find(haystack, needle, position + needle.size()))
+            ++total;
+        return total;
+    }
+
+    // the number of c in text: no branch per character
+    STRING_SEARCH_DISPATCH inline std::size_t count(std::string_view text, char c)
+    {
+        std::size_t total{0};
+        for (char x : text)
+            total += (x == c);
+        return total;
+    }
+
+    // the pieces of text between the delimiters (empty pieces included, so n delimiters give n + 1 pieces); the views point into text
+    inline std::vector<std::string_view> split(std::string_view text, std::string_view delimiter)
+    {
+        std::vector<std::string_view> pieces{};
+        if (delimiter.empty())
+        {
+            pieces.push_back(text);
+            return pieces;
+        }
+        std::size_t begin{0};
+        for (std::size_t end{find(text, delimiter)}; end != npos; end = find(text, delimiter, begin))
+        {
+            pieces.push_back(text.substr(begin, end - begin));
+            begin = end + delimiter.size();
+        }
+        pieces.push_back(text.substr(begin));
+        return pieces;
+    }
+
+    // what isalpha(c) || isspace(c) answer in the "C" locale, for ASCII: letters, ' ' and '\t' '\n' '\v' '\f' '\r'
+    // (characters >= 128 are not), without a function call or a table lookup per character
+    inline bool isAlphaOrSpace(unsigned char c)
+    {
+        unsigned char lower{static_cast<unsigned char>(c | 0x20)}; // 'A'..'Z' -> 'a'..'z'
+        return static_cast<unsigned char>(lower - 'a') < 26 || c == ' ' || static_cast<unsigned char>(c - '\t') < 5;
+    }
+
+    // true when every character of text is a letter or a space (input-output/main.cpp's isValidName())
+    // each block of 64 characters is checked without an early exit, so the compiler vectorizes the check
+    STRING_SEARCH_DISPATCH inline bool isAlphaOrSpace(std::string_view text)
+    {
+        const auto *data{reinterpret_cast<const unsigned char *>(text.data())};
+        constexpr std::size_t block{64};
+        std::size_t i{0};
+        for (; i + block <= text.size(); i += block)
+        {
+            bool valid{true};
+            for (std::size_t j{0}; j < block; ++j)
+                valid &= isAlphaOrSpace(data[i + j]);
+            if (!valid)
+                return false;
+        }
+        for (; i < text.size(); ++i)
+            if (!isAlphaOrSpace(data[i]))
+                return false;
+        return true;
+    }
+}
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef CONCURRENT_GRADE_MAP_H
+#define CONCURRENT_GRADE_MAP_H
+
+#include "flat_hash_map.h"
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// A GradeMap that many threads can use at the same time: mostly readers, now and then a writer.
+//
+// Guarding a GradeMap with a mutex (or a std::shared_mutex) makes every reader write to the mutex: with many threads on many
+// cores, the cache line of the mutex moves from core to core at every lookup, and the readers slow each other down even though
+// none of them changes anything. Here:
+//   the students are spread over 64 shards by the hash of their name, each with its own mutex: writers to different shards
+//   don't wait for each other
+//   readers don't lock at all, and don't write to shared memory: a lookup is a few atomic loads
+// The readers can go through a shard while a writer changes it because nothing a reader may be looking at is ever changed or freed:
+//   a student (Entry) is never moved or freed while the map exists: its name never changes, its grade is an atomic
+//   a slot of the index is written once, from empty to its entry (with a release store: a reader that sees the entry sees
+//   the name in it); erasing a student only marks its grade erased
+//   when an index is full, the writer builds a twice bigger one and publishes it; the old one is kept until the map is destroyed,
+//   since readers may still be going through it (it's at most as big as all the later ones together)
+// The price: memory is only given back by compact(). A map that keeps adding and erasing different names (sessions, temporary
+// ids) grows without limit, by an Entry per name ever added and by the old indexes; call compact() at a quiet moment (no other
+// thread using the map), or use a LockedGradeMap for such workloads. Setting an erased name again reuses its entry.
+// A seqlock (readers retry when a writer was active during their read) would need the same rules: a writer rehashing the table
+// while a reader goes through it would make the reader read freed memory, not just stale values.
+//
+// Lookups return a copy of the grade (std::optional<char>): a reference would be read and written by other threads.
+class ConcurrentGradeMap
+{
+public:
+    static constexpr int shard_bits{6};
+    static constexpr std::size_t shard_count{std::size_t{1} << shard_bits};
+
+private:
+    static constexpr int erased{-1};
+
+    struct Entry
+    {
+        InlineKey name;
+        std::atomic<int> grade; // the grade (as an unsigned char), or erased
+    };
+    struct Slot
+    {
+        std::atomic<std::size_t> hash{};
+        std::atomic<Entry *> entry{}; // nullptr: empty
+    };
+    // an open addressing table (linear probing) of pointers to the entries, at most half full
+    struct Index
+    {
+        std::size_t capacity{};
+        std::unique_ptr<Slot[]> slots{};
+
+        explicit Index(std::size_t new_capacity) : capacity{new_capacity}, slots{std::make_unique<Slot[]>(new_capacity)} {}
+    };
+
+    // its own cache lines: a writer of a shard doesn't slow down the readers of the next one (false sharing)
+    struct alignas(64) Shard
+    {
+        std::atomic<const Index *> index{};
+        std::atomic<std::size_t> size{};
+        std::mutex writer{};
+        // owned here, written under the mutex only
+        std::vector<std::unique_ptr<Entry>> entries{};
+        std::vector<std::unique_ptr<Index>> indexes{}; // the current one last
+    };
+
+    std::unique_ptr<Shard[]> m_shards{std::make_unique<Shard[]>(shard_count)};
+
+    static std::size_t hash(std::string_view name) { return std::hash<std::string_view>{}(name); }
+    // the high bits pick the shard, the low bits the slot in the shard's index
+    Shard &shardOf(std::size_t name_hash) const { return m_shards[name_hash >> (64 - shard_bits)]; }
+
+    // the entry of name in index, nullptr if there is none; safe without the lock
+    static Entry *findEntry(const Index *index, std::string_view name, std::size_t name_hash)
+    {
+        if (!index)
+            return nullptr;
+        const std::size_t mask{index->capacity - 1};
+        for (std::size_t i{name_hash & mask};; i = (i + 1) & mask)
+        {
+            const Slot &slot{index->slots[i]};
+            Entry *entry{slot.entry.load(std::memory_order_acquire)};
+            if (!entry)
+                return nullptr;
+            if (slot.hash.load(std::memory_order_relaxed) == name_hash && entry->name.view() == name)
+                return entry;
+        }
+    }
+
+    static void addToIndex(const Index &index, Entry *entry, std::size_t name_hash)
+    {
+        const std::size_t mask{index.capacity - 1};
+        std::size_t i{name_hash & mask};
+        while (index.slots[i].entry.load(std::memory_order_relaxed))
+            i = (i + 1) & mask;
+        index.slots[i].hash.store(name_hash, std::memory_order_relaxed);
+        index.slots[i].entry.store(entry, std::memory_order_release); // publishes the entry (and the hash) to the readers
+    }
+
+    // under the shard's mutex: a twice bigger index with all the entries, published once complete
+    static void grow(Shard &shard)
+    {
+        rebuild(shard, shard.indexes.empty() ? 16 : 2 * shard.indexes.back()->capacity);
+    }
+    static void rebuild(Shard &shard, std::size_t capacity)
+    {
+        auto index{std::make_unique<Index>(capacity)};
+        for (const auto &entry : shard.entries)
+            addToIndex(*index, entry.get(), hash(entry->name.view()));
+        shard.index.store(index.get(), std::memory_order_release);
+        shard.indexes.push_back(std::move(index));
+    }
+
+public:
+    ConcurrentGradeMap() = default;
+    ConcurrentGradeMap(const ConcurrentGradeMap &) = delete;
+    ConcurrentGradeMap &operator=(const ConcurrentGradeMap &) = delete;
+
+    // the grade of the student, std::nullopt if the name isn't in the map; never waits for a writer
+    std::optional<char> find(std::string_view name) const
+    {
+        std::size_t name_hash{hash(name)};
+        const Shard &shard{shardOf(name_hash)};
+        const Entry *entry{findEntry(shard.index.load(std::memory_order_acquire), name, name_hash)};
+        if (!entry)
+            return std::nullopt;
+        int grade{entry->grade.load(std::memory_order_acquire)};
+        if (grade == erased)
+            return std::nullopt;
+        return static_cast<char>(grade);
+    }
+    bool contains(std::string_view name) const { return find(name).has_value(); }
+
+    // adds the student, or changes their grade
+    void set(std::string_view name, char grade)
+    {
+        std::size_t name_hash{hash(name)};
+        Shard &shard{shardOf(name_hash)};
+        std::lock_guard lock{shard.writer};
+        const Index *index{shard.index.load(std::memory_order_relaxed)};
+        if (Entry *entry{findEntry(index, name, name_hash)})
+        {
+            if (entry->grade.load(std::memory_order_relaxed) == erased)
+                shard.size.fetch_add(1, std::memory_order_relaxed);
+            entry->grade.store(static_cast<unsigned char>(grade), std::memory_order_release);
+            return;
+        }
+        if (!index || 2 * (shard.entries.size() + 1) > index->capacity)
+            grow(shard);
+        shard.entries.push_back(std::make_unique<Entry>(InlineKey{name}, static_cast<unsigned char>(grade)));
+        addToIndex(*shard.indexes.back(), shard.entries.back().get(), name_hash);
+        shard.size.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // returns false if the name wasn't in the map; the entry stays, so that a reader going through it is never left with freed memory
+    bool erase(std::string_view name)
+    {
+        std::size_t name_hash{hash(name)};
+        Shard &shard{shardOf(name_hash)};
+        std::lock_guard lock{shard.writer};
+        Entry *entry{findEntry(shard.index.load(std::memory_order_relaxed), name, name_hash)};
+        if (!entry || entry->grade.exchange(erased, std::memory_order_release) == erased)
+            return false;
+        shard.size.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // frees the erased students and the old indexes, which the readers may still be going through otherwise: no other thread
+    // may use the map during the call
+    void compact()
+    {
+        for (std::size_t i{0}; i < shard_count; ++i)
+        {
+            Shard &shard{m_shards[i]};
+            std::lock_guard lock{shard.writer};
+            std::erase_if(shard.entries, [](const std::unique_ptr<Entry> &entry)
+                          { return entry->grade.load(std::memory_order_relaxed) == erased; });
+            shard.index.store(nullptr, std::memory_order_relaxed);
+            shard.indexes.clear();
+            if (shard.entries.empty())
+                continue;
+            std::size_t capacity{16};
+            while (2 * shard.entries.size() > capacity)
+                capacity *= 2;
+            rebuild(shard, capacity);
+        }
+    }
+
+    // the number of students; only exact when no writer is running
+    std::size_t size() const
+    {
+        std::size_t total{0};
+        for (std::size_t i{0}; i < shard_count; ++i)
+            total += m_shards[i].size.load(std::memory_order_relaxed);
+        return total;
+    }
+};
+
+#endif
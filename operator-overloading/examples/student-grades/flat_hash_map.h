@@ -0,0 +1,405 @@
+#ifndef FLAT_HASH_MAP_H
+#define FLAT_HASH_MAP_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <span>
+#include <string_view>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// A string key that keeps up to 22 characters inside itself (24 bytes, like MyString's small string optimization):
+// most names fit, and comparing a key then reads the slot that was already loaded, no pointer to follow.
+// Byte 0 is the length, or long_tag for a key on the heap: it's the first member of both structs of the union, which C++
+// allows reading through either one.
+class InlineKey
+{
+public:
+    static constexpr std::size_t inline_capacity{22};
+
+private:
+    static constexpr unsigned char long_tag{0xff};
+    struct Short
+    {
+        unsigned char tag; // the length
+        char chars[inline_capacity];
+    };
+    struct Long
+    {
+        unsigned char tag; // long_tag
+        std::size_t length;
+        char *data;
+    };
+    static_assert(sizeof(Short) <= 24 && sizeof(Long) == 24);
+
+    union
+    {
+        Short m_short{};
+        Long m_long;
+    };
+
+    bool isLong() const { return m_short.tag == long_tag; }
+
+public:
+    explicit InlineKey(std::string_view key)
+    {
+        if (key.size() <= inline_capacity)
+        {
+            std::copy(key.begin(), key.end(), m_short.chars);
+            m_short.tag = static_cast<unsigned char>(key.size());
+        }
+        else
+        {
+            m_long.data = new char[key.size()];
+            std::copy(key.begin(), key.end(), m_long.data);
+            m_long.length = key.size();
+            m_long.tag = long_tag;
+        }
+    }
+    InlineKey(InlineKey &&key) noexcept
+    {
+        if (key.isLong())
+            m_long = key.m_long;
+        else
+            m_short = key.m_short;
+        key.m_short.tag = 0;
+    }
+    InlineKey(const InlineKey &) = delete;
+    InlineKey &operator=(const InlineKey &) = delete;
+    ~InlineKey()
+    {
+        if (isLong())
+            delete[] m_long.data;
+    }
+
+    std::string_view view() const
+    {
+        if (isLong())
+            return {m_long.data, m_long.length};
+        return {m_short.chars, static_cast<std::size_t>(m_short.tag)};
+    }
+};
+
+// A hash map from strings to T, laid out like Abseil's "Swiss table" (flat_hash_map):
+//   the elements (slots) are in one array, open addressing: no node, no pointer per element
+//   a separate array has one control byte per slot: empty, deleted, or 7 bits of the hash of the key in the slot
+//   the slots are grouped by 16: a lookup compares the 16 control bytes of a group with the 7 bits of the key's hash in one
+//   SSE2 instruction, and only compares the keys of the slots that match (1/128 of the others on average)
+//   a group with an empty slot ends the search: most lookups read one group of control bytes and one slot
+// The lookups take std::string_view: a literal or a piece of a bigger string is looked up without creating a std::string.
+//
+// The table stays at most 7/8 full, and doubles when it would get fuller. Erasing marks the slot deleted (a "tombstone"),
+// so that the searches that went past it still go on; the tombstones are cleaned up by the next rehash.
+// Like std::vector, growing moves the elements: pointers and references to the values are invalidated by an insertion.
+template <typename T>
+class FlatStringMap
+{
+public:
+    static constexpr std::size_t group_width{16};
+
+private:
+    using Control = std::int8_t;
+    static constexpr Control empty_slot{-128};  // 0b10000000
+    static constexpr Control deleted_slot{-2};  // 0b11111110
+    // a full slot: 0b0xxxxxxx, the 7 low bits of the hash
+
+    struct Slot
+    {
+        InlineKey key;
+        T value;
+    };
+
+    std::unique_ptr<Control[]> m_control{};
+    Slot *m_slots{};
+    std::size_t m_capacity{}; // a power of two, 0 or at least group_width
+    std::size_t m_size{};
+    std::size_t m_growth_left{}; // empty slots that can be filled before the table is too full
+
+    static std::size_t hash(std::string_view key) { return std::hash<std::string_view>{}(key); }
+    static Control hashBits(std::size_t hash) { return static_cast<Control>(hash & 0x7f); }
+    static std::size_t maxSize(std::size_t capacity) { return capacity - capacity / 8; }
+
+    // bit i is set when control byte i of the group is value
+    static std::uint32_t match(const Control *group, Control value)
+    {
+#if defined(__SSE2__)
+        __m128i control{_mm_loadu_si128(reinterpret_cast<const __m128i *>(group))};
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(value))));
+#else
+        std::uint32_t mask{0};
+        for (std::size_t i{0}; i < group_width; ++i)
+            mask |= static_cast<std::uint32_t>(group[i] == value) << i;
+        return mask;
+#endif
+    }
+    // the empty and the deleted slots (their control byte is negative)
+    static std::uint32_t matchFree(const Control *group)
+    {
+#if defined(__SSE2__)
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(group))));
+#else
+        std::uint32_t mask{0};
+        for (std::size_t i{0}; i < group_width; ++i)
+            mask |= static_cast<std::uint32_t>(group[i] < 0) << i;
+        return mask;
+#endif
+    }
+
+    // the groups a key visits, in order: its home group, then +1, +3, +6... groups (triangular numbers visit every group
+    // of a power of two table)
+    class ProbeSequence
+    {
+    private:
+        std::size_t m_group{};
+        std::size_t m_mask{};
+        std::size_t m_step{};
+
+    public:
+        ProbeSequence(std::size_t hash, std::size_t capacity) : m_group{(hash >> 7) & (capacity / group_width - 1)}, m_mask{capacity / group_width - 1} {}
+        std::size_t offset() const { return m_group * group_width; }
+        void next()
+        {
+            ++m_step;
+            m_group = (m_group + m_step) & m_mask;
+        }
+    };
+
+    // the slot of key, or m_capacity if it isn't there
+    std::size_t findIndex(std::string_view key, std::size_t hash) const
+    {
+        if (m_capacity == 0)
+            return m_capacity;
+        const Control bits{hashBits(hash)};
+        for (ProbeSequence probe{hash, m_capacity};; probe.next())
+        {
+            const Control *group{&m_control[probe.offset()]};
+            for (std::uint32_t mask{match(group, bits)}; mask != 0; mask &= mask - 1)
+            {
+                std::size_t index{probe.offset() + static_cast<std::size_t>(__builtin_ctz(mask))};
+                if (m_slots[index].key.view() == key) [[likely]]
+                    return index;
+            }
+            if (match(group, empty_slot) != 0)
+                return m_capacity;
+        }
+    }
+    // the first empty or deleted slot on the probe sequence of hash
+    std::size_t findFree(std::size_t hash) const
+    {
+        for (ProbeSequence probe{hash, m_capacity};; probe.next())
+        {
+            std::uint32_t mask{matchFree(&m_control[probe.offset()])};
+            if (mask != 0)
+                return probe.offset() + static_cast<std::size_t>(__builtin_ctz(mask));
+        }
+    }
+
+    static Slot *allocateSlots(std::size_t capacity)
+    {
+        return static_cast<Slot *>(::operator new(sizeof(Slot) * capacity, std::align_val_t{alignof(Slot)}));
+    }
+    static void freeSlots(Slot *slots)
+    {
+        ::operator delete(slots, std::align_val_t{alignof(Slot)});
+    }
+
+    void destroyAll()
+    {
+        for (std::size_t i{0}; i < m_capacity; ++i)
+            if (m_control[i] >= 0)
+                std::destroy_at(&m_slots[i]);
+        freeSlots(m_slots);
+    }
+
+    // moves every element to a new table of new_capacity slots (and drops the tombstones)
+    void rehash(std::size_t new_capacity)
+    {
+        assert(new_capacity >= group_width && (new_capacity & (new_capacity - 1)) == 0 && m_size <= maxSize(new_capacity));
+        FlatStringMap table{};
+        table.m_control = std::make_unique_for_overwrite<Control[]>(new_capacity);
+        std::fill_n(table.m_control.get(), new_capacity, empty_slot);
+        table.m_slots = allocateSlots(new_capacity);
+        table.m_capacity = new_capacity;
+        table.m_growth_left = maxSize(new_capacity) - m_size;
+        table.m_size = m_size;
+        for (std::size_t i{0}; i < m_capacity; ++i)
+        {
+            if (m_control[i] < 0)
+                continue;
+            std::size_t key_hash{hash(m_slots[i].key.view())};
+            std::size_t index{table.findFree(key_hash)};
+            table.m_control[index] = hashBits(key_hash);
+            ::new (static_cast<void *>(&table.m_slots[index])) Slot{std::move(m_slots[i])};
+            std::destroy_at(&m_slots[i]);
+            m_control[i] = empty_slot;
+        }
+        m_size = 0;
+        swap(table);
+    }
+
+public:
+    FlatStringMap() = default;
+    FlatStringMap(const FlatStringMap &map)
+    {
+        reserve(map.m_size);
+        map.forEach([this](std::string_view key, const T &value)
+                    { (*this)[key] = value; });
+    }
+    FlatStringMap &operator=(const FlatStringMap &map)
+    {
+        if (this != &map)
+        {
+            FlatStringMap copy{map};
+            swap(copy);
+        }
+        return *this;
+    }
+    FlatStringMap(FlatStringMap &&map) noexcept { swap(map); }
+    FlatStringMap &operator=(FlatStringMap &&map) noexcept
+    {
+        FlatStringMap moved{std::move(map)};
+        swap(moved);
+        return *this;
+    }
+    ~FlatStringMap()
+    {
+        if (m_capacity != 0)
+            destroyAll();
+    }
+
+    void swap(FlatStringMap &map) noexcept
+    {
+        std::swap(m_control, map.m_control);
+        std::swap(m_slots, map.m_slots);
+        std::swap(m_capacity, map.m_capacity);
+        std::swap(m_size, map.m_size);
+        std::swap(m_growth_left, map.m_growth_left);
+    }
+
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    std::size_t capacity() const { return m_capacity; }
+
+    // makes room for count elements: inserting up to there doesn't rehash
+    void reserve(std::size_t count)
+    {
+        std::size_t capacity{group_width};
+        while (maxSize(capacity) < count)
+            capacity *= 2;
+        if (capacity > m_capacity)
+            rehash(capacity);
+    }
+
+    // the value of key, nullptr if key isn't in the map
+    T *find(std::string_view key)
+    {
+        std::size_t index{findIndex(key, hash(key))};
+        return index == m_capacity ? nullptr : &m_slots[index].value;
+    }
+    const T *find(std::string_view key) const
+    {
+        std::size_t index{findIndex(key, hash(key))};
+        return index == m_capacity ? nullptr : &m_slots[index].value;
+    }
+    bool contains(std::string_view key) const { return find(key) != nullptr; }
+
+    // looks up many keys at once: out[i] is the value of keys[i], nullptr if it isn't in the map
+    // In a table bigger than the cache, a lookup waits for two cache misses in a row (the control bytes, then the slot), and the
+    // next lookup hardly starts before the first one ends. The keys are taken by batches of 16, and each step is done for the
+    // whole batch before the next one (hash and prefetch the control bytes, match them and prefetch the slot, compare the keys):
+    // the 16 lookups wait for their memory at the same time.
+    void findBatch(std::span<const std::string_view> keys, std::span<const T *> out) const
+    {
+        assert(out.size() == keys.size());
+        constexpr std::size_t batch{16};
+        std::size_t hashes[batch];
+        std::size_t candidates[batch];
+        for (std::size_t first{0}; first < keys.size(); first += batch)
+        {
+            const std::size_t count{std::min(batch, keys.size() - first)};
+            if (m_capacity == 0)
+            {
+                std::fill_n(out.begin() + static_cast<std::ptrdiff_t>(first), count, nullptr);
+                continue;
+            }
+            for (std::size_t i{0}; i < count; ++i)
+            {
+                hashes[i] = hash(keys[first + i]);
+                __builtin_prefetch(&m_control[ProbeSequence{hashes[i], m_capacity}.offset()]);
+            }
+            for (std::size_t i{0}; i < count; ++i)
+            {
+                std::size_t offset{ProbeSequence{hashes[i], m_capacity}.offset()};
+                std::uint32_t mask{match(&m_control[offset], hashBits(hashes[i]))};
+                candidates[i] = mask != 0 ? offset + static_cast<std::size_t>(__builtin_ctz(mask)) : m_capacity;
+                if (mask != 0)
+                    __builtin_prefetch(&m_slots[candidates[i]]);
+            }
+            for (std::size_t i{0}; i < count; ++i)
+            {
+                std::string_view key{keys[first + i]};
+                std::size_t index{candidates[i]};
+                // the first candidate is almost always the key; otherwise the ordinary lookup sorts it out
+                if (index == m_capacity || m_slots[index].key.view() != key)
+                    index = findIndex(key, hashes[i]);
+                out[first + i] = index == m_capacity ? nullptr : &m_slots[index].value;
+            }
+        }
+    }
+
+    // the value of key, inserted (value-initialized) if key isn't in the map yet
+    T &operator[](std::string_view key)
+    {
+        std::size_t key_hash{hash(key)};
+        std::size_t index{findIndex(key, key_hash)};
+        if (index != m_capacity)
+            return m_slots[index].value;
+
+        if (m_growth_left == 0)
+        {
+            // full of elements: twice as big; full of tombstones: same size, without them
+            std::size_t capacity{std::max(group_width, m_capacity)};
+            if (m_size + 1 > maxSize(capacity) / 2)
+                capacity *= 2;
+            rehash(capacity);
+        }
+        index = findFree(key_hash);
+        if (m_control[index] == empty_slot)
+            --m_growth_left; // reusing a tombstone doesn't make the table fuller
+        ::new (static_cast<void *>(&m_slots[index])) Slot{InlineKey{key}, T{}};
+        m_control[index] = hashBits(key_hash);
+        ++m_size;
+        return m_slots[index].value;
+    }
+
+    // returns false if key wasn't in the map
+    bool erase(std::string_view key)
+    {
+        std::size_t index{findIndex(key, hash(key))};
+        if (index == m_capacity)
+            return false;
+        std::destroy_at(&m_slots[index]);
+        m_control[index] = deleted_slot;
+        --m_size;
+        return true;
+    }
+
+    // calls function(key, value) for each element, in no particular order
+    template <typename Function>
+    void forEach(Function function) const
+    {
+        for (std::size_t i{0}; i < m_capacity; ++i)
+            if (m_control[i] >= 0)
+                function(m_slots[i].key.view(), static_cast<const T &>(m_slots[i].value));
+    }
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef GRADE_MAP_H
+#define GRADE_MAP_H
+
+#include "flat_hash_map.h"
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+// The GradeMap of main.cpp on top of a hash map: operator[] finds a student in O(1) instead of comparing the name with every
+// student, and takes a std::string_view, so grades["Joe"] doesn't build a std::string.
+class GradeMap
+{
+private:
+    FlatStringMap<char> m_map{};
+
+public:
+    // the grade of the student, a new student (grade '\0') if the name isn't in the map
+    char &operator[](std::string_view name) { return m_map[name]; }
+
+    // the grade of the student, nullptr if the name isn't in the map (doesn't add anything)
+    const char *find(std::string_view name) const { return m_map.find(name); }
+    bool contains(std::string_view name) const { return m_map.contains(name); }
+    // grades[i] = find(names[i]), with the memory accesses of the lookups overlapped: much faster for big maps
+    void findBatch(std::span<const std::string_view> names, std::span<const char *> grades) const { m_map.findBatch(names, grades); }
+    bool erase(std::string_view name) { return m_map.erase(name); }
+
+    std::size_t size() const { return m_map.size(); }
+    void reserve(std::size_t count) { m_map.reserve(count); }
+
+    // calls function(name, grade) for each student, in no particular order
+    template <typename Function>
+    void forEach(Function function) const { m_map.forEach(function); }
+};
+
+#endif
@@ -0,0 +1,306 @@
+#ifndef GRADE_SNAPSHOT_H
+#define GRADE_SNAPSHOT_H
+
+#include "grade_map.h"
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <sys/mman.h> // POSIX only: mmap()
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// A GradeMap saved to a file that is used as it is: opening it maps the file into memory and checks its header, nothing is parsed,
+// copied or inserted, and lookups read the mapped pages directly.
+//
+// Rebuilding a GradeMap at startup hashes and inserts every student, allocating as the table grows: seconds for millions of students.
+// The snapshot stores the table already built, in a layout that needs no pointers (offsets instead), so it is valid wherever the
+// file is mapped. The pages are only read from the disk (or the page cache) when a lookup touches them.
+//
+// Layout (version 1, in the byte order of the machine that wrote it, checked when opening):
+//   header    64 bytes: tag, version, byte order mark, counts and sizes of the sections, checksum of the sections
+//   records   one per student, in no particular order: name offset in the pool, name length, grade (8 bytes)
+//   index     an open addressing hash table (linear probing, at most half full) of record numbers + 1 (0: empty) and 32 bits
+//             of the hash, so that most lookups compare one name only
+//   pool      all the names, one after the other
+// The hash is FNV-1a, computed the same way on every platform (std::hash may change from one standard library to the next).
+class GradeSnapshot
+{
+private:
+    struct Header
+    {
+        char tag[8];
+        std::uint32_t version;
+        std::uint32_t byte_order; // byte_order_mark, as the writer stored it
+        std::uint64_t count;
+        std::uint64_t index_capacity; // a power of two
+        std::uint64_t pool_size;
+        std::uint64_t checksum; // FNV-1a of everything after the header
+        std::uint64_t reserved[2];
+    };
+    struct Record
+    {
+        std::uint32_t name_offset;
+        std::uint16_t name_length;
+        char grade;
+        std::uint8_t reserved;
+    };
+    struct Bucket
+    {
+        std::uint32_t record; // record number + 1, 0 for an empty bucket
+        std::uint32_t hash;   // the high 32 bits of the name's hash
+    };
+    static_assert(sizeof(Header) == 64 && sizeof(Record) == 8 && sizeof(Bucket) == 8);
+
+    static constexpr char file_tag[8]{'G', 'R', 'A', 'D', 'E', 'S', 'N', 'P'};
+    static constexpr std::uint32_t file_version{1};
+    static constexpr std::uint32_t byte_order_mark{0x01020304};
+
+    std::string m_path{};
+    const std::byte *m_map{};
+    std::size_t m_map_size{};
+    const Header *m_header{};
+    const Record *m_records{};
+    const Bucket *m_index{};
+    const char *m_pool{};
+
+    static std::uint64_t fnv1a(const void *data, std::size_t size, std::uint64_t hash = 0xcbf29ce484222325)
+    {
+        const auto *bytes{static_cast<const unsigned char *>(data)};
+        for (std::size_t i{0}; i < size; ++i)
+            hash = (hash ^ bytes[i]) * 0x100000001b3;
+        return hash;
+    }
+    static std::uint64_t hash(std::string_view name) { return fnv1a(name.data(), name.size()); }
+
+    [[noreturn]] void fail(const std::string &what) const
+    {
+        throw std::runtime_error{"GradeSnapshot: " + m_path + ": " + what};
+    }
+
+    std::string_view name(const Record &record) const { return {m_pool + record.name_offset, record.name_length}; }
+
+    void close()
+    {
+        if (m_map)
+            ::munmap(const_cast<std::byte *>(m_map), m_map_size);
+        m_map = nullptr;
+    }
+
+    // checks that the header describes a file of this size: O(1), whatever the number of students
+    void validate()
+    {
+        if (m_map_size < sizeof(Header))
+            fail("not a grade snapshot (too small)");
+        m_header = reinterpret_cast<const Header *>(m_map);
+        if (std::memcmp(m_header->tag, file_tag, sizeof(file_tag)) != 0)
+            fail("not a grade snapshot");
+        if (m_header->version != file_version)
+            fail("unsupported version " + std::to_string(m_header->version));
+        if (m_header->byte_order != byte_order_mark)
+            fail("written on a machine with another byte order");
+        const std::uint64_t count{m_header->count};
+        const std::uint64_t capacity{m_header->index_capacity};
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0 || count > capacity / 2 || count > UINT32_MAX)
+            fail("corrupt index");
+        // in this order, the sizes can't overflow: each is checked against the file size before it is added
+        std::uint64_t remaining{m_map_size - sizeof(Header)};
+        if (count > remaining / sizeof(Record))
+            fail("truncated");
+        remaining -= count * sizeof(Record);
+        if (capacity > remaining / sizeof(Bucket))
+            fail("truncated");
+        remaining -= capacity * sizeof(Bucket);
+        if (m_header->pool_size != remaining)
+            fail("truncated");
+
+        m_records = reinterpret_cast<const Record *>(m_map + sizeof(Header));
+        m_index = reinterpret_cast<const Bucket *>(m_records + count);
+        m_pool = reinterpret_cast<const char *>(m_index + capacity);
+    }
+
+public:
+    explicit GradeSnapshot(const std::string &path) : m_path{path}
+    {
+        int fd{::open(path.c_str(), O_RDONLY)};
+        if (fd < 0)
+            fail(std::string{"can't open: "} + std::strerror(errno));
+        struct stat info{};
+        if (::fstat(fd, &info) < 0)
+        {
+            ::close(fd);
+            fail(std::string{"can't stat: "} + std::strerror(errno));
+        }
+        m_map_size = static_cast<std::size_t>(info.st_size);
+        void *addr{m_map_size == 0 ? MAP_FAILED : ::mmap(nullptr, m_map_size, PROT_READ, MAP_SHARED, fd, 0)};
+        ::close(fd); // the mapping keeps the file open
+        if (addr == MAP_FAILED)
+            fail(m_map_size == 0 ? std::string{"empty file"} : std::string{"can't map: "} + std::strerror(errno));
+        m_map = static_cast<const std::byte *>(addr);
+        try
+        {
+            validate();
+        }
+        catch (...)
+        {
+            close();
+            throw;
+        }
+    }
+    GradeSnapshot(const GradeSnapshot &) = delete;
+    GradeSnapshot &operator=(const GradeSnapshot &) = delete;
+    GradeSnapshot(GradeSnapshot &&snapshot) noexcept
+        : m_path{std::move(snapshot.m_path)}, m_map{std::exchange(snapshot.m_map, nullptr)}, m_map_size{snapshot.m_map_size},
+          m_header{snapshot.m_header}, m_records{snapshot.m_records}, m_index{snapshot.m_index}, m_pool{snapshot.m_pool}
+    {
+    }
+    ~GradeSnapshot()
+    {
+        close();
+    }
+
+    // writes map to path: to a temporary file first, flushed to the disk (fsync) and then renamed over path, and the directory
+    // flushed too, so that a crash or a power loss leaves either the old snapshot or the complete new one, never half of one
+    static void write(const GradeMap &map, const std::string &path)
+    {
+        const std::uint64_t count{map.size()};
+        std::uint64_t capacity{16};
+        while (capacity / 2 < count)
+            capacity *= 2;
+
+        std::vector<Record> records{};
+        records.reserve(count);
+        std::vector<Bucket> index(capacity);
+        std::string pool{};
+        map.forEach([&](std::string_view student, char grade)
+                    {
+                        if (student.size() > UINT16_MAX || pool.size() + student.size() > UINT32_MAX)
+                            throw std::length_error{"GradeSnapshot: name too long or more than 4 GiB of names"};
+                        records.push_back(Record{static_cast<std::uint32_t>(pool.size()), static_cast<std::uint16_t>(student.size()), grade, 0});
+                        pool += student;
+                        std::uint64_t name_hash{hash(student)};
+                        std::size_t i{name_hash & (capacity - 1)};
+                        while (index[i].record != 0)
+                            i = (i + 1) & (capacity - 1);
+                        index[i] = Bucket{static_cast<std::uint32_t>(records.size()), static_cast<std::uint32_t>(name_hash >> 32)}; });
+
+        Header header{};
+        std::memcpy(header.tag, file_tag, sizeof(file_tag));
+        header.version = file_version;
+        header.byte_order = byte_order_mark;
+        header.count = count;
+        header.index_capacity = capacity;
+        header.pool_size = pool.size();
+        header.checksum = fnv1a(pool.data(), pool.size(), fnv1a(index.data(), index.size() * sizeof(Bucket), fnv1a(records.data(), records.size() * sizeof(Record))));
+
+        const std::string temporary{path + ".tmp"};
+        int fd{::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)};
+        if (fd < 0)
+            throw std::runtime_error{"GradeSnapshot: can't create " + temporary + ": " + std::strerror(errno)};
+        auto fail{[&](const std::string &what)
+                  {
+                      int error{errno};
+                      if (fd >= 0)
+                          ::close(fd);
+                      ::unlink(temporary.c_str());
+                      throw std::runtime_error{"GradeSnapshot: " + what + ": " + std::strerror(error)};
+                  }};
+        // ::write() may write less than asked (a signal, a full disk): loop until everything is written
+        auto writeAll{[&](const void *data, std::size_t size)
+                      {
+                          const char *bytes{static_cast<const char *>(data)};
+                          while (size > 0)
+                          {
+                              ssize_t written{::write(fd, bytes, size)};
+                              if (written < 0 && errno == EINTR)
+                                  continue;
+                              if (written <= 0)
+                                  fail("can't write " + temporary);
+                              bytes += written;
+                              size -= static_cast<std::size_t>(written);
+                          }
+                      }};
+        writeAll(&header, sizeof(header));
+        writeAll(records.data(), records.size() * sizeof(Record));
+        writeAll(index.data(), index.size() * sizeof(Bucket));
+        writeAll(pool.data(), pool.size());
+        // without fsync(), the rename can reach the disk before the data: after a power loss, path would be empty or truncated
+        if (::fsync(fd) != 0)
+            fail("can't flush " + temporary);
+        int result{::close(fd)};
+        fd = -1;
+        if (result != 0)
+            fail("can't close " + temporary);
+        if (std::rename(temporary.c_str(), path.c_str()) != 0)
+            fail("can't rename " + temporary + " to " + path);
+
+        // the rename itself is an update of the directory, durable once the directory is flushed
+        std::string directory{std::filesystem::path{path}.parent_path().string()};
+        int directory_fd{::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY)};
+        if (directory_fd < 0)
+            throw std::runtime_error{"GradeSnapshot: can't open the directory of " + path + ": " + std::strerror(errno)};
+        int error{::fsync(directory_fd) != 0 ? errno : 0};
+        ::close(directory_fd);
+        if (error != 0)
+            throw std::runtime_error{"GradeSnapshot: can't flush the directory of " + path + ": " + std::strerror(error)};
+    }
+
+    std::size_t size() const { return m_header->count; }
+
+    // the grade of the student, nullptr if the name isn't in the snapshot
+    // the record numbers and name offsets read from the file are bounds checked: a corrupt file gives wrong answers, never a crash
+    const char *find(std::string_view student) const
+    {
+        const std::uint64_t name_hash{hash(student)};
+        const std::uint32_t high{static_cast<std::uint32_t>(name_hash >> 32)};
+        const std::uint64_t mask{m_header->index_capacity - 1};
+        for (std::uint64_t i{name_hash & mask}, probes{0}; probes <= mask; i = (i + 1) & mask, ++probes)
+        {
+            const Bucket bucket{m_index[i]};
+            if (bucket.record == 0)
+                return nullptr;
+            if (bucket.hash != high || bucket.record > m_header->count)
+                continue;
+            const Record &record{m_records[bucket.record - 1]};
+            if (std::uint64_t{record.name_offset} + record.name_length <= m_header->pool_size && name(record) == student)
+                return &record.grade;
+        }
+        return nullptr;
+    }
+    bool contains(std::string_view student) const { return find(student) != nullptr; }
+
+    // calls function(name, grade) for each student, in the order they were written
+    template <typename Function>
+    void forEach(Function function) const
+    {
+        for (std::size_t i{0}; i < size(); ++i)
+            if (std::uint64_t{m_records[i].name_offset} + m_records[i].name_length <= m_header->pool_size)
+                function(name(m_records[i]), m_records[i].grade);
+    }
+
+    // reads the whole file and compares it with the checksum of the header: O(size of the file), for when the file may be damaged
+    bool verify() const
+    {
+        return fnv1a(m_records, m_map_size - sizeof(Header)) == m_header->checksum;
+    }
+
+    // a GradeMap with the same students, to modify them (and write a new snapshot)
+    GradeMap toGradeMap() const
+    {
+        GradeMap map{};
+        map.reserve(size());
+        forEach([&](std::string_view student, char grade)
+                { map[student] = grade; });
+        return map;
+    }
+};
+
+#endif
@@ -1,7 +1,83 @@
+#include "grade_map.h"
+#include "concurrent_grade_map.h"
+#include "sorted_grade_map.h"
+#include "grade_snapshot.h"
+#include "timer.h"
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <unordered_map>
 #include <algorithm>
+#include <random>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <shared_mutex>
+#include <mutex>
+#include <atomic>
+#include <optional>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+/*
+    * Overloading the subscript operator for a map class
+    * Hash maps with open addressing (Swiss table)
+    * Looking up std::string_view keys without building strings
+    * Sharing a map between threads: sharding, lock-free reads
+    * Sorted arrays in Eytzinger (breadth first) order
+    * Saving a map in a file that is used without loading it (mmap)
+*/
+
+/*
+The first GradeMap (LessonGradeMap below) keeps the students in a std::vector and finds a name with std::find_if: every lookup compares the
+name with the students one by one, O(n). With a million students, one lookup compares up to a million strings, and building the map
+does it for every student (O(n^2)). Its operator[] also takes a const std::string&: grades["Joe"] first builds a std::string
+(an allocation when the name is longer than the 15 characters of libstdc++'s small string buffer).
+
+GradeMap (grade_map.h) uses FlatStringMap (flat_hash_map.h), a hash map in the style of Abseil's "Swiss table":
+    the hash of the name picks a group of 16 slots; the 16 control bytes of the group hold 7 bits of the hash of each slot's key,
+    and are compared with the name's 7 bits in one SSE2 instruction; only the matching slots (almost always just the right one)
+    have their key compared
+    everything is in two flat arrays: no node per element (std::unordered_map allocates one per element, and follows a pointer
+    to the bucket, then one per element of the bucket)
+    the keys keep up to 22 characters inside the slot (InlineKey): comparing the key reads memory that was already loaded
+    lookups take a std::string_view: nothing is allocated to look up a literal or a piece of a line
+
+A table of a million students doesn't fit in the cache: a lookup then waits for memory twice (the control bytes, then the slot), about
+150 ns each on a typical server, whatever the data structure. findBatch() looks up many names at once, each step for 16 names before
+the next step, so that the 16 lookups wait for their memory at the same time instead of one after the other.
+
+Many threads reading a map that is sometimes written (concurrent_grade_map.h):
+The usual answer is a std::shared_mutex around the map (LockedGradeMap below): readers take it shared, writers exclusive. Yet taking it shared
+is an atomic write to the mutex: all the readers write to the same cache line, which has to move from core to core, and they slow each
+other down. ConcurrentGradeMap splits the students over 64 shards, each with its own mutex for the writers, and its readers take no lock
+at all: a reader only loads atomics, and the writers never change or free anything a reader may be reading (see the header).
+That has a cost: an erased student and every outgrown index stay in memory until compact() is called while no other thread uses the
+map, so a map that keeps adding and erasing different names grows without limit in between.
+
+Tables built once and then read (sorted_grade_map.h):
+When all the students are known up front, SortedGradeMap sorts them once (O(n log n)) and finds a name with a binary search. Building it
+is not faster than inserting the students one by one in a GradeMap: it's 2 to 3 times slower in the benchmark below (sorting strings
+compares each of them many times). Its lookups are 1.3 to 3 times faster than a binary search over a sorted std::vector (the more
+students, the bigger the gap), and slower than GradeMap's: it's for tables that must also be listed in order. The lesson's vector
+scan (LessonGradeMap, measured up to 10'000 students) is already 14 times slower than the binary search at 10'000. A plain binary search over a sorted std::vector misses the cache at nearly every step on big
+tables. SortedGradeMap stores its search tree in Eytzinger (breadth first) order, with the first 8 characters of each name in the
+node: the top of the tree stays in the cache, the nodes two levels down are prefetched, and most steps compare integers.
+It can't add students after it's built (operator[] throws std::out_of_range for an unknown name), and lists them alphabetically.
+
+Starting up without loading (grade_snapshot.h):
+A program that reads its students from a file at startup inserts them one by one: seconds for ten million students, before the
+first lookup. GradeSnapshot::write() saves the hash table itself, already built: the names one after the other, a record per student
+and the index, with offsets instead of pointers. Opening the snapshot maps the file (mmap) and checks that its header matches the size
+of the file, in O(1): a lookup hashes the name and reads the index, the record and the name straight from the mapped pages, which the
+operating system reads from the disk (or finds in its page cache) the first time they're touched. verify() reads the whole file to
+check its checksum, when it may be damaged; toGradeMap() makes a GradeMap of it to change the students.
+*/
 
 struct StudentGrade
 {
@@ -9,7 +85,8 @@ struct StudentGrade
     char grade{};
 };
 
-class GradeMap
+// the GradeMap of the lesson: the baseline of the benchmark
+class LessonGradeMap
 {
 private:
     std::vector<StudentGrade> m_map{};
@@ -29,6 +106,116 @@ public:
     }
 };
 
+// a GradeMap behind a std::shared_mutex: the simple way to share it between threads, the baseline of the thread benchmark
+class LockedGradeMap
+{
+private:
+    GradeMap m_map{};
+    mutable std::shared_mutex m_mutex{};
+
+public:
+    std::optional<char> find(std::string_view name) const
+    {
+        std::shared_lock lock{m_mutex};
+        const char *grade{m_map.find(name)};
+        return grade ? std::optional<char>{*grade} : std::nullopt;
+    }
+    void set(std::string_view name, char grade)
+    {
+        std::unique_lock lock{m_mutex};
+        m_map[name] = grade;
+    }
+};
+
+// threads each doing operations lookups or updates (write_percent % of updates) on random names: operations per second
+template <typename Map>
+double throughput(Map &map, const std::vector<std::string> &names, int threads, unsigned write_percent, std::int64_t &check)
+{
+    constexpr int operations{1'000'000}; // per thread
+    std::atomic<std::int64_t> found{0};
+    std::vector<std::thread> workers{};
+    Timer timer{};
+    for (int thread{0}; thread < threads; ++thread)
+        workers.emplace_back([&, thread]
+                             {
+                                 std::uint64_t state{static_cast<std::uint64_t>(thread) * 0x9e3779b97f4a7c15 + 1};
+                                 std::int64_t local_found{0};
+                                 for (int i{0}; i < operations; ++i)
+                                 {
+                                     state ^= state << 13; // xorshift: a std::mt19937 per thread would cost more than a lookup
+                                     state ^= state >> 7;
+                                     state ^= state << 17;
+                                     std::string_view name{names[state % names.size()]};
+                                     if ((state >> 40) % 100 < write_percent)
+                                         map.set(name, static_cast<char>('A' + (state >> 20) % 6));
+                                     else
+                                         local_found += map.find(name).has_value();
+                                 }
+                                 found += local_found; });
+    for (std::thread &worker : workers)
+        worker.join();
+    double seconds{timer.elapsed()};
+    check += found;
+    return operations * threads / seconds;
+}
+
+// "firstname lastname number": names of 10 to 25 characters, some too long for the small string buffers
+std::vector<std::string> makeNames(std::size_t count)
+{
+    const std::string_view first_names[]{"Joe", "Frank", "Alexandra", "Li", "Maximilian", "Eve", "Christopher", "Ana"};
+    const std::string_view last_names[]{"Smith", "Ng", "Johansson", "Brown", "Okonkwo-Adeyemi", "Lee", "Garcia", "Ivanova"};
+    std::vector<std::string> names{};
+    names.reserve(count);
+    for (std::size_t i{0}; i < count; ++i)
+    {
+        std::string name{first_names[i % 8]};
+        name += ' ';
+        name += last_names[i / 8 % 8];
+        name += ' ';
+        name += std::to_string(i / 64);
+        names.push_back(std::move(name));
+    }
+    return names;
+}
+
+// names to look up, in random order, copied one after the other: reading the queries doesn't miss the cache, the benchmarks
+// measure the maps
+struct Queries
+{
+    std::string text{};
+    std::vector<std::string_view> names{};
+};
+Queries makeQueries(const std::vector<std::string> &names, std::size_t count, std::mt19937 &random)
+{
+    Queries queries{};
+    std::vector<std::size_t> lengths{};
+    for (std::size_t i{0}; i < count; ++i)
+    {
+        const std::string &name{names[random() % names.size()]};
+        queries.text += name;
+        lengths.push_back(name.size());
+    }
+    for (std::size_t offset{0}; std::size_t length : lengths)
+    {
+        queries.names.push_back(std::string_view{queries.text}.substr(offset, length));
+        offset += length;
+    }
+    return queries;
+}
+
+// builds a map of the names, then times lookups of queries: nanoseconds per lookup
+template <typename Map, typename Lookup>
+double nanosecondsPerLookup(const std::vector<std::string> &names, const std::vector<std::string_view> &queries, Lookup lookup, std::int64_t &check)
+{
+    Map map{};
+    for (std::size_t i{0}; i < names.size(); ++i)
+        lookup(map, names[i]) = static_cast<char>('A' + i % 6);
+    Timer timer{};
+    for (std::string_view query : queries)
+        check += lookup(map, query);
+    return timer.elapsed() * 1e9 / static_cast<double>(queries.size());
+}
+
 int main()
 {
     GradeMap grades{};
@@ -39,5 +226,369 @@ int main()
     std::cout << "Joe has a grade of " << grades["Joe"] << '\n';
     std::cout << "Frank has a grade of " << grades["Frank"] << '\n';
 
+    assert(grades.find("Frank") && *grades.find("Frank") == 'B' && !grades.find("Nobody") && grades.size() == 2);
+    grades["Alexandra Okonkwo-Adeyemi the Third"] = 'C'; // too long to be stored inline
+    assert(grades.erase("Joe") && !grades.contains("Joe") && grades.size() == 2);
+    assert(grades["Alexandra Okonkwo-Adeyemi the Third"] == 'C');
+
+    {
+        // against std::unordered_map, with inserts, erases and rehashes
+        FlatStringMap<int> map{};
+        std::unordered_map<std::string, int> expected{};
+        std::mt19937 random{1};
+        std::vector<std::string> keys{makeNames(5000)};
+        for (int i{0}; i < 200'000; ++i)
+        {
+            const std::string &key{keys[random() % keys.size()]};
+            if (random() % 3 == 0)
+                assert(map.erase(key) == (expected.erase(key) == 1));
+            else
+                map[key] = ++expected[key];
+        }
+        assert(map.size() == expected.size());
+        for (const auto &[key, value] : expected)
+            assert(map.find(key) && *map.find(key) == value);
+        std::vector<std::string_view> batch_keys(keys.begin(), keys.begin() + 100);
+        std::vector<const int *> batch_values(batch_keys.size());
+        map.findBatch(batch_keys, batch_values);
+        for (std::size_t i{0}; i < batch_keys.size(); ++i)
+            assert(batch_values[i] == map.find(batch_keys[i]));
+        FlatStringMap<int> copy{map};
+        assert(copy.size() == map.size() && copy.find(expected.begin()->first));
+    }
+
+    /* Benchmark: lookups */
+    std::mt19937 random{42};
+    std::cout << "ns per lookup, names in random order:\n";
+    std::cout << "students  LessonGradeMap  std::unordered_map  GradeMap  GradeMap::findBatch\n";
+    for (std::size_t count : {std::size_t{1'000}, std::size_t{10'000}, std::size_t{1'000'000}})
+    {
+        std::vector<std::string> names{makeNames(count)};
+        const Queries query_list{makeQueries(names, std::max<std::size_t>(count, 1'000'000), random)};
+        const std::vector<std::string_view> &queries{query_list.names};
+
+        std::int64_t checks[3]{};
+        double lesson_time{-1};
+        if (count <= 10'000) // building a million student LessonGradeMap compares half a trillion names
+            lesson_time = nanosecondsPerLookup<LessonGradeMap>(
+                names, std::vector<std::string_view>(queries.begin(), queries.begin() + 100'000),
+                [](LessonGradeMap &map, std::string_view name) -> char &
+                { return map[std::string{name}]; },
+                checks[0]);
+        // with std::string_view names, as a GradeMap would get them: the lesson's interface builds a std::string for each
+        double unordered_time{nanosecondsPerLookup<std::unordered_map<std::string, char>>(
+            names, queries, [](std::unordered_map<std::string, char> &map, std::string_view name) -> char &
+            { return map[std::string{name}]; },
+            checks[1])};
+        double grade_map_time{nanosecondsPerLookup<GradeMap>(
+            names, queries, [](GradeMap &map, std::string_view name) -> char &
+            { return map[name]; },
+            checks[2])};
+
+        GradeMap batch_map{};
+        for (std::size_t i{0}; i < names.size(); ++i)
+            batch_map[names[i]] = static_cast<char>('A' + i % 6);
+        std::vector<const char *> found(queries.size());
+        Timer timer{};
+        batch_map.findBatch(queries, found);
+        std::int64_t batch_check{0};
+        for (const char *grade : found)
+            batch_check += *grade;
+        double batch_time{timer.elapsed() * 1e9 / static_cast<double>(queries.size())};
+        assert(checks[1] == checks[2] && batch_check == checks[2]);
+
+        std::cout << std::left << std::setw(10) << count << std::setw(16);
+        if (lesson_time < 0)
+            std::cout << "-";
+        else
+            std::cout << lesson_time;
+        std::cout << std::setw(20) << unordered_time << std::setw(10) << grade_map_time << batch_time << '\n';
+    }
+
+    /* Sorted map */
+    {
+        SortedGradeMap sorted{{{"Joe", 'A'}, {"Frank", 'B'}, {"Alexandra", 'C'}, {"Joe", 'D'}}};
+        assert(sorted.size() == 3 && *sorted.find("Joe") == 'D' && !sorted.find("Bob") && !sorted.find("Zoe") && !sorted.find(""));
+        sorted["Frank"] = 'A';
+        assert(sorted["Frank"] == 'A');
+        bool thrown{false};
+        try
+        {
+            sorted["Bob"] = 'F';
+        }
+        catch (const std::out_of_range &)
+        {
+            thrown = true;
+        }
+        assert(thrown);
+        std::string in_order{};
+        sorted.forEach([&](std::string_view name, char grade)
+                       { (in_order += name) += grade; });
+        assert(in_order == "AlexandraCFrankAJoeD");
+
+        // every name of a GradeMap, and names that are not in it (between them, before, after, with the same 8 first characters)
+        GradeMap hashed{};
+        std::vector<std::string> names{makeNames(5000)};
+        for (std::size_t i{0}; i < names.size(); ++i)
+            hashed[names[i]] = static_cast<char>('A' + i % 6);
+        SortedGradeMap from_hashed{hashed};
+        assert(from_hashed.size() == hashed.size());
+        for (const std::string &name : names)
+        {
+            assert(from_hashed.find(name) && *from_hashed.find(name) == *hashed.find(name));
+            assert(!from_hashed.find(name + "x") && !from_hashed.find(name.substr(0, name.size() - 1) + "~"));
+        }
+        assert(!from_hashed.find("A") && !from_hashed.find("zzz") && !from_hashed.find("Alexandra Brown"));
+    }
+
+    /* Benchmark: built once, read often */
+    std::cout << "building a map of the students (s), then ns per lookup:\n";
+    std::cout << "students  build: GradeMap  SortedGradeMap  lookup: LessonGradeMap  sorted std::vector  GradeMap  SortedGradeMap\n";
+    // 100M students would need about 20 GB for the names and the three maps
+    for (std::size_t count : {std::size_t{1'000}, std::size_t{10'000}, std::size_t{100'000}, std::size_t{1'000'000}, std::size_t{10'000'000}})
+    {
+        std::vector<std::string> names{makeNames(count)};
+        const Queries query_list{makeQueries(names, 1'000'000, random)};
+        auto gradeOf{[](std::size_t i)
+                     { return static_cast<char>('A' + i * 7 % 6); }};
+
+        // inserting the students one by one, as a program that starts up reading them
+        Timer timer{};
+        GradeMap hashed{};
+        for (std::size_t i{0}; i < count; ++i)
+            hashed[names[i]] = gradeOf(i);
+        double hashed_build_time{timer.elapsed()};
+
+        timer.reset();
+        std::vector<std::pair<std::string_view, char>> students{};
+        students.reserve(count);
+        for (std::size_t i{0}; i < count; ++i)
+            students.emplace_back(names[i], gradeOf(i));
+        SortedGradeMap sorted{students};
+        double sorted_build_time{timer.elapsed()};
+
+        // the lesson's vector scan, up to 10'000 students and on 100'000 lookups, like the table above
+        double lesson_time{-1};
+        if (count <= 10'000)
+        {
+            LessonGradeMap lesson{};
+            for (std::size_t i{0}; i < count; ++i)
+                lesson[names[i]] = gradeOf(i);
+            const std::vector<std::string_view> lesson_queries(query_list.names.begin(), query_list.names.begin() + 100'000);
+            std::int64_t lesson_checks[2]{};
+            timer.reset();
+            for (std::string_view name : lesson_queries)
+                lesson_checks[0] += lesson[std::string{name}];
+            lesson_time = timer.elapsed() * 1e9 / static_cast<double>(lesson_queries.size());
+            for (std::string_view name : lesson_queries)
+                lesson_checks[1] += *hashed.find(name);
+            assert(lesson_checks[0] == lesson_checks[1]);
+        }
+
+        // a sorted std::vector and std::lower_bound
+        std::sort(students.begin(), students.end());
+        std::int64_t checks[3]{};
+        timer.reset();
+        for (std::string_view name : query_list.names)
+            checks[0] += std::lower_bound(students.begin(), students.end(), name, [](const auto &student, std::string_view key)
+                                          { return student.first < key; })
+                             ->second;
+        double vector_time{timer.elapsed()};
+
+        timer.reset();
+        for (std::string_view name : query_list.names)
+            checks[1] += *hashed.find(name);
+        double hashed_time{timer.elapsed()};
+
+        timer.reset();
+        for (std::string_view name : query_list.names)
+            checks[2] += *sorted.find(name);
+        double sorted_time{timer.elapsed()};
+
+        assert(checks[0] == checks[1] && checks[1] == checks[2]);
+        const double per_lookup{1e9 / static_cast<double>(query_list.names.size())};
+        std::cout << std::setw(10) << count << std::setw(16) << hashed_build_time << std::setw(24) << sorted_build_time << std::setw(16);
+        if (lesson_time < 0)
+            std::cout << "-";
+        else
+            std::cout << lesson_time;
+        std::cout << std::setw(20) << vector_time * per_lookup << std::setw(10) << hashed_time * per_lookup << sorted_time * per_lookup << '\n';
+    }
+
+    /* Sharing the map between threads */
+    {
+        ConcurrentGradeMap shared{};
+        shared.set("Joe", 'A');
+        shared.set("Frank", 'B');
+        shared.set("Joe", 'C');
+        assert(shared.find("Joe") == 'C' && shared.size() == 2 && !shared.find("Nobody"));
+        assert(shared.erase("Joe") && !shared.erase("Joe") && !shared.contains("Joe") && shared.size() == 1);
+        shared.set("Joe", 'D');
+        assert(shared.find("Joe") == 'D' && shared.size() == 2);
+
+        // readers and writers at the same time: a reader sees a name with one of its grades, or not at all
+        std::vector<std::string> names{makeNames(20'000)};
+        std::atomic<bool> wrong{false};
+        std::thread writer{[&]
+                           {
+                               for (int round{0}; round < 3; ++round)
+                                   for (std::size_t i{0}; i < names.size(); ++i)
+                                       shared.set(names[i], static_cast<char>('A' + (i + round) % 6));
+                           }};
+        std::thread reader{[&]
+                           {
+                               for (int round{0}; round < 10; ++round)
+                                   for (const std::string &name : names)
+                                       if (std::optional<char> grade{shared.find(name)}; grade && (*grade < 'A' || *grade > 'F'))
+                                           wrong = true;
+                           }};
+        writer.join();
+        reader.join();
+        assert(!wrong && shared.size() == names.size() + 2);
+
+        // the erased students are only freed by compact(), once the threads are done
+        for (std::size_t i{0}; i < names.size(); i += 2)
+            shared.erase(names[i]);
+        shared.compact();
+        assert(shared.size() == names.size() / 2 + 2 && shared.find("Joe") == 'D' && !shared.contains(names[0]) && shared.contains(names[1]));
+        shared.set(names[0], 'B');
+        assert(shared.find(names[0]) == 'B');
+    }
+
+    /* Benchmark: threads */
+    {
+        std::vector<std::string> names{makeNames(100'000)};
+        ConcurrentGradeMap concurrent{};
+        LockedGradeMap locked{};
+        for (std::size_t i{0}; i < names.size(); ++i)
+        {
+            concurrent.set(names[i], 'A');
+            locked.set(names[i], 'A');
+        }
+        const int max_threads{static_cast<int>(std::max(4u, std::thread::hardware_concurrency()))};
+        std::cout << "millions of operations per second on " << names.size() << " students (" << std::thread::hardware_concurrency()
+                  << " hardware threads):\n";
+        std::cout << "reads  threads  LockedGradeMap (per thread)  ConcurrentGradeMap (per thread)\n";
+        for (unsigned write_percent : {1u, 10u})
+            for (int threads{1}; threads <= max_threads; threads *= 2)
+            {
+                std::int64_t checks[2]{};
+                double locked_speed{throughput(locked, names, threads, write_percent, checks[0]) / 1e6};
+                double concurrent_speed{throughput(concurrent, names, threads, write_percent, checks[1]) / 1e6};
+                assert(checks[0] == checks[1]); // every name is in both maps: every lookup finds it
+                auto format{[threads](double speed)
+                            {
+                                std::ostringstream out{};
+                                out << std::fixed << std::setprecision(2) << speed << " (" << speed / threads << ')';
+                                return out.str();
+                            }};
+                std::cout << std::setw(7) << std::to_string(100 - write_percent) + "%" << std::setw(9) << threads
+                          << std::setw(29) << format(locked_speed) << format(concurrent_speed) << '\n';
+            }
+    }
+
+    /* Snapshots */
+    {
+        const std::filesystem::path path{std::filesystem::temp_directory_path() / "grade-snapshot.bin"};
+        GradeMap map{};
+        std::vector<std::string> names{makeNames(5000)};
+        for (std::size_t i{0}; i < names.size(); ++i)
+            map[names[i]] = static_cast<char>('A' + i % 6);
+        map["Alexandra Okonkwo-Adeyemi the Third"] = 'F';
+        GradeSnapshot::write(map, path);
+        {
+            GradeSnapshot snapshot{path};
+            assert(snapshot.size() == map.size() && snapshot.verify());
+            for (const std::string &name : names)
+                assert(snapshot.find(name) && *snapshot.find(name) == *map.find(name) && !snapshot.contains(name + "x"));
+            assert(*snapshot.find("Alexandra Okonkwo-Adeyemi the Third") == 'F' && !snapshot.find("") && !snapshot.find("Joe"));
+            GradeMap copy{snapshot.toGradeMap()};
+            assert(copy.size() == map.size() && *copy.find(names[42]) == *map.find(names[42]));
+        }
+
+        // a file that isn't a snapshot, or a truncated one, is rejected when it's opened
+        auto rejected{[&]
+                      {
+                          try
+                          {
+                              GradeSnapshot snapshot{path};
+                          }
+                          catch (const std::runtime_error &)
+                          {
+                              return true;
+                          }
+                          return false;
+                      }};
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+        assert(rejected());
+        std::ofstream{path, std::ios::binary} << "not a snapshot";
+        assert(rejected());
+        std::filesystem::remove(path);
+        assert(rejected());
+
+        // a failed write throws and leaves no temporary file behind (here the rename fails: path is a directory)
+        std::filesystem::create_directory(path);
+        bool thrown{false};
+        try
+        {
+            GradeSnapshot::write(map, path);
+        }
+        catch (const std::runtime_error &)
+        {
+            thrown = true;
+        }
+        assert(thrown && !std::filesystem::exists(path.string() + ".tmp"));
+        std::filesystem::remove(path);
+    }
+
+    /* Benchmark: starting up */
+    {
+        const std::filesystem::path path{std::filesystem::temp_directory_path() / "grade-snapshot.bin"};
+        std::cout << "starting up with the students (ms), then ns per lookup:\n";
+        std::cout << "students  insert into GradeMap  write snapshot  open snapshot  first lookup  lookup: GradeMap  GradeSnapshot\n";
+        for (std::size_t count : {std::size_t{100'000}, std::size_t{1'000'000}, std::size_t{10'000'000}})
+        {
+            std::vector<std::string> names{makeNames(count)};
+            const Queries query_list{makeQueries(names, 1'000'000, random)};
+
+            Timer timer{};
+            GradeMap map{};
+            for (std::size_t i{0}; i < count; ++i)
+                map[names[i]] = static_cast<char>('A' + i % 6);
+            double insert_time{timer.elapsed()};
+
+            timer.reset();
+            GradeSnapshot::write(map, path);
+            double write_time{timer.elapsed()};
+
+            timer.reset();
+            GradeSnapshot snapshot{path};
+            double open_time{timer.elapsed()};
+            // the first lookup reads its pages of the file (from the page cache: the file was just written)
+            timer.reset();
+            const char *first{snapshot.find(names[count / 2])};
+            double first_time{timer.elapsed()};
+            assert(first && *first == *map.find(names[count / 2]));
+
+            std::int64_t checks[2]{};
+
+            timer.reset();
+            for (std::string_view name : query_list.names)
+                checks[0] += *map.find(name);
+            double map_time{timer.elapsed()};
+            timer.reset();
+            for (std::string_view name : query_list.names)
+                checks[1] += *snapshot.find(name);
+            double snapshot_time{timer.elapsed()};
+            assert(checks[0] == checks[1]);
+
+            const double per_lookup{1e9 / static_cast<double>(query_list.names.size())};
+            std::cout << std::setw(10) << count << std::setw(22) << insert_time * 1e3 << std::setw(16) << write_time * 1e3
+                      << std::setw(15) << open_time * 1e3 << std::setw(14) << first_time * 1e3 << std::setw(18)
+                      << map_time * per_lookup << snapshot_time * per_lookup << '\n';
+        }
+        std::filesystem::remove(path);
+    }
+
     return 0;
 }
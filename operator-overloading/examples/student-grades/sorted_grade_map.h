@@ -0,0 +1,221 @@
+#ifndef SORTED_GRADE_MAP_H
+#define SORTED_GRADE_MAP_H
+
+#include "grade_map.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// A GradeMap for tables that are built once and then only read (and their grades changed): the students are sorted by name,
+// and found by a binary search laid out for the cache.
+//
+// A binary search over a sorted array jumps to the middle, then a quarter, an eighth...: each step is a cache miss once the array
+// is bigger than the cache, and the compiler can't know the next address before the comparison is done.
+// The Eytzinger layout stores the search tree in breadth first order, like a binary heap: the root at 1, the children of k at
+// 2k and 2k + 1. The nodes a search visits first are together at the start of the array (and stay in the cache), and the four
+// grandchildren of node k are the 64 bytes at 4k: they can be prefetched two steps before they are needed, whichever way the
+// search goes. Each node keeps 8 characters of its name as an integer (a "partial key", the 8 that come after the prefix all the
+// names under the node share), so most steps compare two integers without reading the name itself.
+// Unlike a hash map, it keeps the names in order: forEach() lists the students alphabetically.
+class SortedGradeMap
+{
+private:
+    struct Node
+    {
+        std::uint64_t partial{}; // 8 characters of the name from skip on, big endian: comparing integers compares the characters
+        std::uint32_t offset{};  // the name is m_names[offset, offset + length)
+        std::uint16_t length{};
+        std::uint16_t skip{}; // the characters every name that can reach this node starts with
+    };
+    struct NodeDeleter
+    {
+        void operator()(Node *nodes) const { ::operator delete(nodes, std::align_val_t{64}); }
+    };
+
+    std::string m_names{}; // all the names, alphabetically, one after the other
+    std::unique_ptr<Node[], NodeDeleter> m_nodes{}; // the Eytzinger tree, from 1 to size(), 64 byte aligned
+    std::vector<char> m_grades{};                   // in the same order as the nodes
+    std::size_t m_size{};
+
+    // the 8 characters of name from first on (0 past the end), as a big endian integer
+    static std::uint64_t partialKey(std::string_view name, std::size_t first)
+    {
+        std::uint64_t partial{0};
+        if (first + 8 <= name.size())
+        {
+            std::memcpy(&partial, name.data() + first, 8);
+            return __builtin_bswap64(partial);
+        }
+        if (first < name.size() && name.size() >= 8) // the last 8 characters, shifted: the characters past the end become 0
+        {
+            std::memcpy(&partial, name.data() + name.size() - 8, 8);
+            return __builtin_bswap64(partial) << (8 * (first + 8 - name.size()));
+        }
+        for (std::size_t i{first}; i < first + 8; ++i)
+            partial = partial << 8 | (i < name.size() ? static_cast<unsigned char>(name[i]) : 0u);
+        return partial;
+    }
+    static std::size_t commonPrefix(std::string_view a, std::string_view b)
+    {
+        return static_cast<std::size_t>(std::mismatch(a.begin(), a.begin() + static_cast<std::ptrdiff_t>(std::min(a.size(), b.size())), b.begin()).first - a.begin());
+    }
+
+    // the name is in the node: when the prefixes are equal, comparing the names costs one memory access, not two
+    std::string_view name(const Node &node) const { return {m_names.data() + node.offset, node.length}; }
+
+    // the alphabetical position of each node: an in-order walk of the tree visits the names in alphabetical order
+    std::size_t number(std::size_t node, std::size_t next, std::vector<std::uint32_t> &positions) const
+    {
+        if (node > m_size)
+            return next;
+        next = number(2 * node, next, positions);
+        positions[node] = static_cast<std::uint32_t>(next);
+        return number(2 * node + 1, next + 1, positions);
+    }
+
+    // A search reaches a node only with a key between the last ancestors it went right and left at (low and high): when both
+    // exist, the key starts with the characters they have in common, and so do all the names below. The node's partial key
+    // starts after those characters: deep in the tree, where neighbouring names share long prefixes, the integers still differ.
+    template <typename Students>
+    void fill(std::size_t node, const std::vector<std::uint32_t> &positions, const std::vector<std::uint32_t> &offsets,
+              const Students &students, const std::string_view *low, const std::string_view *high)
+    {
+        if (node > m_size)
+            return;
+        const auto &[student, grade]{students[positions[node]]};
+        std::size_t skip{low && high ? commonPrefix(*low, *high) : 0};
+        m_nodes[node] = Node{partialKey(student, skip), offsets[positions[node]], static_cast<std::uint16_t>(student.size()), static_cast<std::uint16_t>(skip)};
+        m_grades[node] = grade;
+        fill(2 * node, positions, offsets, students, low, &student);
+        fill(2 * node + 1, positions, offsets, students, &student, high);
+    }
+
+    template <typename Function>
+    void inOrder(std::size_t node, Function &function) const
+    {
+        if (node > m_size)
+            return;
+        inOrder(2 * node, function);
+        function(name(m_nodes[node]), m_grades[node]);
+        inOrder(2 * node + 1, function);
+    }
+
+    // the node of name, 0 if it isn't in the map
+    std::size_t findNode(std::string_view key) const
+    {
+        const Node *nodes{m_nodes.get()};
+        std::size_t k{1};
+        while (k <= m_size)
+        {
+            __builtin_prefetch(nodes + 4 * k); // the grandchildren: 4 nodes of 16 bytes, one cache line
+            const Node &node{nodes[k]};
+            // node < key? both start with the node's skip characters; the rest of the names is only compared when the partial keys are equal
+            std::uint64_t partial{partialKey(key, node.skip)};
+            bool less{node.partial < partial}; // no branch: which way the search goes is random
+            if (node.partial == partial) [[unlikely]]
+                less = name(node).substr(node.skip) < std::string_view{key.data() + node.skip, key.size() - node.skip};
+            k = 2 * k + less;
+        }
+        // k went right after the last node that is >= key, then only left: remove those right turns and the left turn before them
+        k >>= __builtin_ffsll(static_cast<long long>(~k));
+        if (k == 0 || name(nodes[k]) != key)
+            return 0;
+        return k;
+    }
+
+public:
+    SortedGradeMap() = default;
+    // the students, in any order; when a name appears twice, its last grade is kept
+    explicit SortedGradeMap(std::vector<std::pair<std::string_view, char>> students)
+    {
+        // O(n log n): sort by name, keep the last of equal names
+        std::stable_sort(students.begin(), students.end(), [](const auto &a, const auto &b)
+                         { return a.first < b.first; });
+        std::vector<std::pair<std::string_view, char>> unique{};
+        unique.reserve(students.size());
+        for (const auto &student : students)
+        {
+            if (!unique.empty() && unique.back().first == student.first)
+                unique.back().second = student.second;
+            else
+                unique.push_back(student);
+        }
+
+        m_size = unique.size();
+        std::size_t total{0};
+        for (const auto &student : unique)
+            total += student.first.size();
+        if (total > UINT32_MAX)
+            throw std::length_error{"SortedGradeMap: more than 4 GiB of names"};
+        m_names.reserve(total);
+        std::vector<std::uint32_t> offsets{};
+        offsets.reserve(m_size);
+        for (const auto &student : unique)
+        {
+            if (student.first.size() > UINT16_MAX)
+                throw std::length_error{"SortedGradeMap: name longer than 65535 characters"};
+            offsets.push_back(static_cast<std::uint32_t>(m_names.size()));
+            m_names += student.first;
+        }
+
+        // 4 nodes more than needed: the prefetches of the last levels stay in the allocation
+        std::size_t count{4 * (m_size + 1)};
+        m_nodes.reset(static_cast<Node *>(::operator new(count * sizeof(Node), std::align_val_t{64})));
+        std::uninitialized_value_construct_n(m_nodes.get(), count);
+        m_grades.resize(m_size + 1);
+        std::vector<std::uint32_t> positions(m_size + 1);
+        number(1, 0, positions);
+        fill(1, positions, offsets, unique, nullptr, nullptr);
+    }
+    explicit SortedGradeMap(const GradeMap &map) : SortedGradeMap(students(map)) {}
+
+    static std::vector<std::pair<std::string_view, char>> students(const GradeMap &map)
+    {
+        std::vector<std::pair<std::string_view, char>> result{};
+        result.reserve(map.size());
+        map.forEach([&](std::string_view name, char grade)
+                    { result.emplace_back(name, grade); });
+        return result;
+    }
+
+    std::size_t size() const { return m_size; }
+
+    // the grade of the student, nullptr if the name isn't in the map
+    const char *find(std::string_view name) const
+    {
+        std::size_t node{findNode(name)};
+        return node == 0 ? nullptr : &m_grades[node];
+    }
+    char *find(std::string_view name)
+    {
+        std::size_t node{findNode(name)};
+        return node == 0 ? nullptr : &m_grades[node];
+    }
+    bool contains(std::string_view name) const { return find(name) != nullptr; }
+
+    // the grade of the student; the set of students is fixed when the map is built, so an unknown name throws
+    char &operator[](std::string_view name)
+    {
+        char *grade{find(name)};
+        if (!grade)
+            throw std::out_of_range{"SortedGradeMap: unknown student " + std::string{name}};
+        return *grade;
+    }
+
+    // calls function(name, grade) for each student, alphabetically
+    template <typename Function>
+    void forEach(Function function) const
+    {
+        inOrder(1, function);
+    }
+};
+
+#endif
@@ -241,6 +241,8 @@ template tries to perform some operation that the actual type doesn’t support
 
 */
 
+// Dollars and Cents show how to overload operators, they are not a model for money (a std::string in every value, a conversion
+// through float): see examples/money for why, and for an integer Money type
 class Dollars
 {
 private:
@@ -393,6 +395,7 @@ Dollars Dollars::operator-() const
     return -m_dollars; // converted to Dollars using the constructor
 }
 
+// an operator overloading example, not a model for money: see the comment above Dollars
 class Cents
 {
 private:
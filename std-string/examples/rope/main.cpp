@@ -0,0 +1,165 @@
+#include "rope.h"
+#include "string_builder.h"
+#include "timer.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <random>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+
+/*
+    * A rope: a string as a balanced tree of immutable chunks
+    * O(log n) insert and erase anywhere
+    * Sharing chunks between strings (persistent data structure)
+    * A chunked string builder for big texts
+*/
+
+/*
+std-string/main.cpp appends with += and append(), and inserts with insert(5, "==="). A std::string is one contiguous buffer:
+    insert(pos, text) moves all the characters after pos to make room: O(length) for each insert, even a one character insert
+    += is amortized O(1), but every time the capacity is reached the whole text is copied to a buffer twice as big
+For a text of a few KiB it doesn't matter. For multi-megabyte logs and reports built from many small pieces, or edited in the middle,
+it becomes the bottleneck.
+
+Rope (rope.h) stores the text in chunks of up to 1 KiB at the leaves of a balanced binary tree; each node knows the length of its subtree.
+    insert/erase split the tree at the position and join the parts: O(log n) nodes are created, the chunks aren't copied
+    operator[] walks down the tree: O(log n), slower than a string's, so ropes are for editing, not for reading character by character
+    the nodes are immutable and shared: a copy of a rope, or a substr(), costs no character copy at all
+    the text is read chunk by chunk (forEachChunk()), or viewed without a copy (contiguousView()) when it is a single chunk
+
+StringBuilder (string_builder.h) only appends. It fills a chunk, then allocates the next one (twice as big, up to 1 MiB) instead of
+reallocating: the characters are written once, and never copied again until toString() copies them once into an exact size string
+(or forEachChunk() writes them out without any copy). Numbers are formatted with std::to_chars: no locale and no stream state, unlike
+std::ostringstream.
+*/
+
+// a line of a log: what the builder benchmark writes, 1.4 million times
+template <typename Out>
+void writeLine(Out &out, int i)
+{
+    out << "request " << i << " status " << 200 + i % 5 << " took " << i % 1000 << " us\n";
+}
+
+std::uint64_t checksum(std::string_view text)
+{
+    std::uint64_t sum{0};
+    for (char c : text)
+        sum = sum * 31 + static_cast<unsigned char>(c);
+    return sum;
+}
+
+int main()
+{
+    /* Rope */
+    Rope text{"Hello, World!"};
+    text += " Hello, C++!";
+    text.insert(5, "===");
+    assert(text.toString() == "Hello===, World! Hello, C++!");
+    assert(text[5] == '=' && text.length() == 28);
+
+    Rope copy{text}; // shares every node
+    text.erase(5, 3);
+    assert(text.toString() == "Hello, World! Hello, C++!" && copy.toString() == "Hello===, World! Hello, C++!");
+    assert(text.substr(7, 5).toString() == "World");
+
+    // small pieces are merged into one chunk: the text is still contiguous
+    assert(text.contiguousView() && *text.contiguousView() == "Hello, World! Hello, C++!");
+
+    // a long text is cut in 1 KiB chunks, flatten() puts it back in one
+    Rope big{std::string(10'000, 'a')};
+    big.insert(5000, "b");
+    assert(!big.contiguousView() && big[5000] == 'b' && big.length() == 10'001);
+    std::size_t chunks{0};
+    big.forEachChunk([&](std::string_view chunk)
+                     { chunks += !chunk.empty(); });
+    assert(chunks > 1);
+    assert(big.flatten().size() == 10'001 && big.contiguousView());
+
+    /* StringBuilder */
+    StringBuilder builder{};
+    builder << "pi is about " << 3.14 << ", " << 42 << '!';
+    assert(builder.contiguousView() && *builder.contiguousView() == "pi is about 3.14, 42!");
+    for (int i{0}; i < 1000; ++i)
+        builder.append("0123456789");
+    assert(builder.length() == 21 + 10'000 && builder.chunkCount() > 1 && !builder.contiguousView());
+    assert(builder.toString().substr(21, 12) == "012345678901");
+
+    /* Benchmark: inserting in the middle */
+    constexpr std::size_t initial_length{1 << 20};
+    constexpr int inserts{20'000};
+    std::mt19937 random{42};
+    std::uniform_int_distribution<std::size_t> position{0, initial_length};
+    std::string base(initial_length, 'x');
+
+    Timer timer{};
+    std::string string{base};
+    for (int i{0}; i < inserts; ++i)
+        string.insert(position(random) % (string.size() + 1), "[inserted]");
+    double string_time{timer.elapsed()};
+
+    random.seed(42);
+    timer.reset();
+    Rope rope{base};
+    for (int i{0}; i < inserts; ++i)
+        rope.insert(position(random) % (rope.length() + 1), "[inserted]");
+    double rope_time{timer.elapsed()};
+
+    assert(rope.toString() == string);
+    std::cout << inserts << " inserts at random positions in a " << initial_length / 1024 << " KiB text:\n";
+    std::cout << "std::string::insert " << string_time << " s\n";
+    std::cout << "Rope::insert        " << rope_time << " s (tree height " << rope.height() << ")\n";
+
+    /* Benchmark: building a big text */
+    constexpr int lines{1'400'000};
+    timer.reset();
+    std::string appended{};
+    for (int i{0}; i < lines; ++i)
+    {
+        appended += "request ";
+        appended += std::to_string(i);
+        appended += " status ";
+        appended += std::to_string(200 + i % 5);
+        appended += " took ";
+        appended += std::to_string(i % 1000);
+        appended += " us\n";
+    }
+    double append_time{timer.elapsed()};
+
+    timer.reset();
+    std::ostringstream stream{};
+    for (int i{0}; i < lines; ++i)
+        writeLine(stream, i);
+    std::string streamed{stream.str()};
+    double stream_time{timer.elapsed()};
+
+    timer.reset();
+    StringBuilder report{};
+    for (int i{0}; i < lines; ++i)
+        writeLine(report, i);
+    double builder_time{timer.elapsed()};
+
+    // written out chunk by chunk, no copy of the whole text
+    std::uint64_t built_checksum{0};
+    report.forEachChunk([&](std::string_view chunk)
+                        {
+                            for (char c : chunk)
+                                built_checksum = built_checksum * 31 + static_cast<unsigned char>(c); });
+
+    timer.reset();
+    std::string built{report.toString()};
+    double to_string_time{timer.elapsed()};
+
+    assert(streamed == appended && built == appended);
+    std::uint64_t expected{checksum(appended)};
+    assert(built_checksum == expected);
+    std::cout << "building a " << appended.size() / (1024 * 1024) << " MiB log of " << lines << " lines (checksum " << expected << "):\n";
+    std::cout << "std::string +=       " << append_time << " s\n";
+    std::cout << "std::ostringstream   " << stream_time << " s\n";
+    std::cout << "StringBuilder        " << builder_time << " s (" << report.chunkCount() << " chunks, + "
+              << to_string_time << " s for toString())\n";
+
+    return 0;
+}
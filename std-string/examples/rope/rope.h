@@ -0,0 +1,296 @@
+#ifndef ROPE_H
+#define ROPE_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// A rope: a string stored as a balanced binary tree whose leaves are pieces of text (chunks).
+//
+// std::string::insert(pos, text) moves every character after pos (and may reallocate): O(n) per insert. A rope inserts by splitting
+// the tree at pos and joining the three parts: only the nodes on the paths from the root are rebuilt, O(log n).
+// The nodes are immutable and shared (std::shared_ptr): copying a rope copies one pointer, and a rope built from another one shares
+// all the untouched nodes with it. A leaf refers to a range of a shared text buffer, so splitting a leaf doesn't copy its characters.
+//
+// The tree is kept balanced like an AVL tree (the heights of the two children of a node differ by at most 1), with the join
+// algorithm of Blelloch, Ferizovic and Sun ("Just Join for Parallel Ordered Sets", 2016).
+// Small neighbouring leaves are merged, so appending characters one by one doesn't make one leaf per character.
+class Rope
+{
+public:
+    // leaves up to this size are merged when they meet; text longer than this is cut in leaves of this size
+    static constexpr std::size_t max_leaf{1024};
+
+private:
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    struct Node
+    {
+        // leaf: a range of a shared buffer
+        std::shared_ptr<const std::string> buffer{};
+        std::size_t offset{};
+        // inner node: the two halves
+        NodePtr left{};
+        NodePtr right{};
+
+        std::size_t length{};
+        int height{}; // 0 for a leaf
+
+        bool isLeaf() const { return !left; }
+        std::string_view text() const { return {buffer->data() + offset, length}; }
+    };
+
+    NodePtr m_root{};
+
+    static int height(const NodePtr &node) { return node ? node->height : -1; }
+    static std::size_t length(const NodePtr &node) { return node ? node->length : 0; }
+
+    static NodePtr makeLeaf(std::shared_ptr<const std::string> buffer, std::size_t offset, std::size_t length)
+    {
+        auto node{std::make_shared<Node>()};
+        node->buffer = std::move(buffer);
+        node->offset = offset;
+        node->length = length;
+        return node;
+    }
+    static NodePtr makeLeaf(std::string text)
+    {
+        std::size_t length{text.size()};
+        return makeLeaf(std::make_shared<const std::string>(std::move(text)), 0, length);
+    }
+    static NodePtr makeNode(NodePtr left, NodePtr right)
+    {
+        auto node{std::make_shared<Node>()};
+        node->length = left->length + right->length;
+        node->height = 1 + std::max(left->height, right->height);
+        node->left = std::move(left);
+        node->right = std::move(right);
+        return node;
+    }
+    // a node for two neighbours: a single leaf when both are small leaves
+    static NodePtr makeNodeOrMerge(NodePtr left, NodePtr right)
+    {
+        if (left->isLeaf() && right->isLeaf() && left->length + right->length <= max_leaf)
+        {
+            std::string text{left->text()};
+            text += right->text();
+            return makeLeaf(std::move(text));
+        }
+        return makeNode(std::move(left), std::move(right));
+    }
+
+    static NodePtr rotateLeft(const NodePtr &node)
+    {
+        const NodePtr &right{node->right};
+        return makeNode(makeNode(node->left, right->left), right->right);
+    }
+    static NodePtr rotateRight(const NodePtr &node)
+    {
+        const NodePtr &left{node->left};
+        return makeNode(left->left, makeNode(left->right, node->right));
+    }
+
+    // left is more than one level taller than right: goes down the right side of left until the heights match
+    static NodePtr joinRight(const NodePtr &left, const NodePtr &right)
+    {
+        const NodePtr &inner{left->right};
+        if (height(inner) <= height(right) + 1)
+        {
+            NodePtr joined{makeNodeOrMerge(inner, right)};
+            if (height(joined) <= height(left->left) + 1)
+                return makeNode(left->left, std::move(joined));
+            return rotateLeft(makeNode(left->left, rotateRight(joined)));
+        }
+        NodePtr joined{joinRight(inner, right)};
+        NodePtr node{makeNode(left->left, joined)};
+        if (height(joined) <= height(left->left) + 1)
+            return node;
+        return rotateLeft(node);
+    }
+    static NodePtr joinLeft(const NodePtr &left, const NodePtr &right)
+    {
+        const NodePtr &inner{right->left};
+        if (height(inner) <= height(left) + 1)
+        {
+            NodePtr joined{makeNodeOrMerge(left, inner)};
+            if (height(joined) <= height(right->right) + 1)
+                return makeNode(std::move(joined), right->right);
+            return rotateRight(makeNode(rotateLeft(joined), right->right));
+        }
+        NodePtr joined{joinLeft(left, inner)};
+        NodePtr node{makeNode(joined, right->right)};
+        if (height(joined) <= height(right->right) + 1)
+            return node;
+        return rotateRight(node);
+    }
+    // the concatenation of two balanced trees, balanced: O(difference of the heights)
+    static NodePtr join(const NodePtr &left, const NodePtr &right)
+    {
+        if (!left || left->length == 0)
+            return right;
+        if (!right || right->length == 0)
+            return left;
+        if (height(left) > height(right) + 1)
+            return joinRight(left, right);
+        if (height(right) > height(left) + 1)
+            return joinLeft(left, right);
+        return makeNodeOrMerge(left, right);
+    }
+
+    // the characters before position and from position on
+    static std::pair<NodePtr, NodePtr> split(const NodePtr &node, std::size_t position)
+    {
+        if (!node)
+            return {};
+        if (position == 0)
+            return {nullptr, node};
+        if (position >= node->length)
+            return {node, nullptr};
+        if (node->isLeaf()) // the two halves share the buffer
+            return {makeLeaf(node->buffer, node->offset, position), makeLeaf(node->buffer, node->offset + position, node->length - position)};
+        if (position < node->left->length)
+        {
+            auto [before, after]{split(node->left, position)};
+            return {before, join(after, node->right)};
+        }
+        auto [before, after]{split(node->right, position - node->left->length)};
+        return {join(node->left, before), after};
+    }
+
+    // a balanced tree of leaves of at most max_leaf characters, all sharing one buffer
+    static NodePtr build(const std::shared_ptr<const std::string> &buffer, std::size_t first, std::size_t last)
+    {
+        if (last - first <= max_leaf)
+            return makeLeaf(buffer, first, last - first);
+        std::size_t leaves{(last - first + max_leaf - 1) / max_leaf};
+        std::size_t middle{first + leaves / 2 * max_leaf};
+        return makeNode(build(buffer, first, middle), build(buffer, middle, last));
+    }
+    static NodePtr build(std::string_view text)
+    {
+        if (text.empty())
+            return nullptr;
+        auto buffer{std::make_shared<const std::string>(text)};
+        return build(buffer, 0, text.size());
+    }
+
+    explicit Rope(NodePtr root) : m_root{std::move(root)} {}
+
+    template <typename Function>
+    static void forEachChunk(const NodePtr &node, Function &function)
+    {
+        if (!node)
+            return;
+        if (node->isLeaf())
+        {
+            function(node->text());
+            return;
+        }
+        forEachChunk(node->left, function);
+        forEachChunk(node->right, function);
+    }
+
+public:
+    Rope() = default;
+    explicit Rope(std::string_view text) : m_root{build(text)} {}
+    explicit Rope(const char *text) : Rope(std::string_view{text}) {}
+
+    std::size_t length() const { return length(m_root); }
+    bool empty() const { return length() == 0; }
+    int height() const { return height(m_root); }
+
+    // O(log n)
+    char operator[](std::size_t index) const
+    {
+        assert(index < length());
+        const Node *node{m_root.get()};
+        while (!node->isLeaf())
+        {
+            if (index < node->left->length)
+                node = node->left.get();
+            else
+            {
+                index -= node->left->length;
+                node = node->right.get();
+            }
+        }
+        return node->text()[index];
+    }
+
+    Rope &operator+=(std::string_view text)
+    {
+        m_root = join(m_root, build(text));
+        return *this;
+    }
+    Rope &operator+=(const Rope &rope)
+    {
+        m_root = join(m_root, rope.m_root);
+        return *this;
+    }
+    friend Rope operator+(const Rope &a, const Rope &b)
+    {
+        return Rope{join(a.m_root, b.m_root)};
+    }
+
+    // O(log n) whatever the position
+    void insert(std::size_t position, std::string_view text)
+    {
+        assert(position <= length());
+        auto [before, after]{split(m_root, position)};
+        m_root = join(join(before, build(text)), after);
+    }
+    void erase(std::size_t position, std::size_t count)
+    {
+        assert(position <= length());
+        auto [before, rest]{split(m_root, position)};
+        auto [removed, after]{split(rest, count)};
+        m_root = join(before, after);
+    }
+    // shares the nodes of this rope
+    Rope substr(std::size_t position, std::size_t count) const
+    {
+        auto [before, rest]{split(m_root, position)};
+        return Rope{split(rest, count).first};
+    }
+
+    // calls function(std::string_view) for each chunk, in order: the way to write a rope out without flattening it
+    template <typename Function>
+    void forEachChunk(Function function) const
+    {
+        forEachChunk(m_root, function);
+    }
+
+    // the text without a copy, when it is a single chunk
+    std::optional<std::string_view> contiguousView() const
+    {
+        if (!m_root)
+            return std::string_view{};
+        if (m_root->isLeaf())
+            return m_root->text();
+        return std::nullopt;
+    }
+    // the whole text in one string (one allocation)
+    std::string toString() const
+    {
+        std::string result{};
+        result.reserve(length());
+        forEachChunk([&](std::string_view chunk)
+                     { result += chunk; });
+        return result;
+    }
+    // rebuilds the rope as a single chunk: afterwards contiguousView() always succeeds
+    std::string_view flatten()
+    {
+        if (!contiguousView())
+            m_root = makeLeaf(toString());
+        return *contiguousView();
+    }
+};
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef STRING_BUILDER_H
+#define STRING_BUILDER_H
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// An append-only string made of chunks: for building big texts (logs, reports) piece by piece.
+//
+// std::string += reallocates when the capacity is reached and copies everything written so far to the new buffer (and needs
+// a buffer as big as the whole text). StringBuilder adds a new chunk instead: what was written is never copied again.
+// The chunks grow geometrically, from min_chunk to max_chunk characters, so there are few of them but no huge allocation.
+// The text is written out chunk by chunk (forEachChunk()), or copied once into an exactly sized std::string (toString()).
+class StringBuilder
+{
+public:
+    static constexpr std::size_t min_chunk{256};
+    static constexpr std::size_t max_chunk{std::size_t{1} << 20};
+
+private:
+    struct Chunk
+    {
+        std::unique_ptr<char[]> data{};
+        std::size_t length{};
+        std::size_t capacity{};
+    };
+
+    std::vector<Chunk> m_chunks{};
+    std::size_t m_length{};
+
+    // the last chunk, with room for at least one more character
+    Chunk &lastChunk()
+    {
+        if (m_chunks.empty() || m_chunks.back().length == m_chunks.back().capacity)
+        {
+            std::size_t capacity{m_chunks.empty() ? min_chunk : std::min(2 * m_chunks.back().capacity, max_chunk)};
+            m_chunks.push_back(Chunk{std::make_unique_for_overwrite<char[]>(capacity), 0, capacity});
+        }
+        return m_chunks.back();
+    }
+
+public:
+    StringBuilder() = default;
+
+    std::size_t length() const { return m_length; }
+    bool empty() const { return m_length == 0; }
+    std::size_t chunkCount() const { return m_chunks.size(); }
+
+    StringBuilder &append(std::string_view text)
+    {
+        m_length += text.size();
+        // the common case: the text fits in the last chunk
+        if (!m_chunks.empty() && text.size() <= m_chunks.back().capacity - m_chunks.back().length)
+        {
+            Chunk &chunk{m_chunks.back()};
+            std::copy_n(text.data(), text.size(), chunk.data.get() + chunk.length);
+            chunk.length += text.size();
+            return *this;
+        }
+        while (!text.empty())
+        {
+            Chunk &chunk{lastChunk()};
+            std::size_t count{std::min(text.size(), chunk.capacity - chunk.length)};
+            std::copy_n(text.data(), count, chunk.data.get() + chunk.length);
+            chunk.length += count;
+            text.remove_prefix(count);
+        }
+        return *this;
+    }
+    StringBuilder &append(char c)
+    {
+        Chunk &chunk{lastChunk()};
+        chunk.data[chunk.length++] = c;
+        ++m_length;
+        return *this;
+    }
+    // integers and floating point numbers, formatted by std::to_chars (no locale, no allocation, unlike std::ostringstream)
+    template <typename Number>
+        requires std::is_arithmetic_v<Number> && (!std::is_same_v<Number, char>) && (!std::is_same_v<Number, bool>)
+    StringBuilder &append(Number number)
+    {
+        char digits[32];
+        auto [end, error]{std::to_chars(digits, digits + sizeof(digits), number)};
+        assert(error == std::errc{});
+        return append(std::string_view{digits, static_cast<std::size_t>(end - digits)});
+    }
+
+    template <typename T>
+    StringBuilder &operator<<(const T &value)
+    {
+        if constexpr (std::is_convertible_v<const T &, std::string_view>)
+            return append(std::string_view{value});
+        else
+            return append(value);
+    }
+
+    // calls function(std::string_view) for each chunk, in order
+    template <typename Function>
+    void forEachChunk(Function function) const
+    {
+        for (const Chunk &chunk : m_chunks)
+            function(std::string_view{chunk.data.get(), chunk.length});
+    }
+
+    // the text without a copy, when it still fits in the first chunk
+    std::optional<std::string_view> contiguousView() const
+    {
+        if (m_chunks.empty())
+            return std::string_view{};
+        if (m_chunks.size() == 1)
+            return std::string_view{m_chunks[0].data.get(), m_chunks[0].length};
+        return std::nullopt;
+    }
+
+    // the whole text, in one allocation of the exact size
+    std::string toString() const
+    {
+        std::string result{};
+        result.reserve(m_length);
+        forEachChunk([&](std::string_view chunk)
+                     { result += chunk; });
+        return result;
+    }
+
+    // keeps the first chunk for the next text
+    void clear()
+    {
+        if (m_chunks.size() > 1)
+            m_chunks.resize(1);
+        if (!m_chunks.empty())
+            m_chunks[0].length = 0;
+        m_length = 0;
+    }
+};
+
+#endif